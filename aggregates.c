@@ -0,0 +1,166 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "functions.h"
+
+// Task counts kept on every list, board and user, so a summary never walks the tasks. Every
+// change to the working set adjusts the three levels above the task in constant time; the
+// counts are built as the tasks are linked during loading. Tasks become overdue when the
+// reminder wheel fires their overdue event, so the wheel's day is the "today" of the counts.
+// The next deadline is kept with the number of tasks due on it; when the last of them goes,
+// it is marked unknown and found again the next time a summary asks for it.
+
+static void clearNextDeadline(TaskCounts* counts) {
+    counts->nextDeadlineTasks = 0;
+    counts->nextDeadlineUnknown = 0;
+}
+
+// Adds (tasks > 0) or removes (tasks < 0) tasks due on deadline from the next deadline
+static void adjustNextDeadline(TaskCounts* counts, long deadline, long tasks) {
+    if (counts->nextDeadlineUnknown || tasks == 0) {
+        return;
+    }
+    if (tasks > 0) {
+        if (counts->nextDeadlineTasks == 0 || deadline < counts->nextDeadline) {
+            counts->nextDeadline = deadline;
+            counts->nextDeadlineTasks = tasks;
+        } else if (deadline == counts->nextDeadline) {
+            counts->nextDeadlineTasks += tasks;
+        }
+    } else if (counts->nextDeadlineTasks > 0 && deadline == counts->nextDeadline) {
+        counts->nextDeadlineTasks += tasks;
+        counts->nextDeadlineUnknown = counts->nextDeadlineTasks == 0;
+    }
+}
+
+static void adjustCounts(TaskCounts* counts, const Task* task, long deadline, long delta) {
+    counts->total += delta;
+    counts->byPriority[priorityRank(task->priority)] += delta;
+    if (task->overdue) {
+        counts->overdue += delta;
+    } else if (deadline >= 0) {
+        adjustNextDeadline(counts, deadline, delta);
+    }
+}
+
+static void adjustAllCounts(const Task* task, long deadline, long delta) {
+    List* list = task->list;
+    adjustCounts(&list->counts, task, deadline, delta);
+    adjustCounts(&list->board->counts, task, deadline, delta);
+    adjustCounts(&list->board->user->counts, task, deadline, delta);
+}
+
+// Adds a task that has just been linked into its list
+void countTask(Task* task) {
+    long deadline = dateToDay(task->date);
+    task->overdue = deadline >= 0 && deadline < reminderDay();
+    adjustAllCounts(task, deadline, 1);
+}
+
+// Takes a task out of the counts; call while task->list is still the list that holds it
+void uncountTask(Task* task) {
+    adjustAllCounts(task, dateToDay(task->date), -1);
+}
+
+// Moves a task from the pending counts to the overdue ones
+void markTaskOverdue(Task* task) {
+    if (task->overdue || task->list == NULL) {
+        return;
+    }
+    long deadline = dateToDay(task->date);
+    adjustAllCounts(task, deadline, -1);
+    task->overdue = 1;
+    adjustAllCounts(task, deadline, 1);
+}
+
+// Takes everything in part out of whole, for a list or board that is being deleted
+static void subtractCounts(TaskCounts* whole, const TaskCounts* part) {
+    whole->total -= part->total;
+    for (int i = 0; i < PRIORITY_RANKS; i++) {
+        whole->byPriority[i] -= part->byPriority[i];
+    }
+    whole->overdue -= part->overdue;
+    if (part->nextDeadlineUnknown) {
+        whole->nextDeadlineUnknown = 1;
+    } else if (part->nextDeadlineTasks > 0) {
+        adjustNextDeadline(whole, part->nextDeadline, -part->nextDeadlineTasks);
+    }
+}
+
+void uncountList(List* list) {
+    subtractCounts(&list->board->counts, &list->counts);
+    subtractCounts(&list->board->user->counts, &list->counts);
+}
+
+void uncountBoard(Board* board) {
+    subtractCounts(&board->user->counts, &board->counts);
+}
+
+// Finds the next deadline again where it is unknown, from the level below
+static void refreshListDeadline(List* list) {
+    if (!list->counts.nextDeadlineUnknown) {
+        return;
+    }
+    clearNextDeadline(&list->counts);
+    for (const Task* task = list->tasks; task != NULL; task = task->next) {
+        long deadline = dateToDay(task->date);
+        if (!task->overdue && deadline >= 0) {
+            adjustNextDeadline(&list->counts, deadline, 1);
+        }
+    }
+}
+
+static void refreshBoardDeadline(Board* board) {
+    if (!board->counts.nextDeadlineUnknown) {
+        return;
+    }
+    clearNextDeadline(&board->counts);
+    for (List* list = board->lists; list != NULL; list = list->next) {
+        refreshListDeadline(list);
+        adjustNextDeadline(&board->counts, list->counts.nextDeadline, list->counts.nextDeadlineTasks);
+    }
+}
+
+static void refreshUserDeadline(User* user) {
+    if (!user->counts.nextDeadlineUnknown) {
+        return;
+    }
+    clearNextDeadline(&user->counts);
+    for (Board* board = user->boards; board != NULL; board = board->next) {
+        refreshBoardDeadline(board);
+        adjustNextDeadline(&user->counts, board->counts.nextDeadline, board->counts.nextDeadlineTasks);
+    }
+}
+
+static void printCounts(const char* indent, const char* label, const TaskCounts* counts) {
+    printf("%s%s: %ld tasks (high %ld, medium %ld, low %ld), %ld overdue", indent, label, counts->total,
+           counts->byPriority[0], counts->byPriority[1], counts->byPriority[2], counts->overdue);
+    if (counts->nextDeadlineTasks > 0) {
+        char date[16];
+        dayToDate(counts->nextDeadline, date);
+        printf(", next deadline %s (%ld task%s)\n", date, counts->nextDeadlineTasks,
+               counts->nextDeadlineTasks == 1 ? "" : "s");
+    } else {
+        printf(", no upcoming deadline\n");
+    }
+}
+
+// Prints the user's counts and each board's, or the board's and each of its lists' when a
+// board is given
+void printTaskSummary(User* user, Board* board) {
+    if (board == NULL) {
+        refreshUserDeadline(user);
+        printCounts("", user->username, &user->counts);
+        for (board = user->boards; board != NULL; board = board->next) {
+            refreshBoardDeadline(board);
+            printCounts("  ", board->name, &board->counts);
+        }
+        return;
+    }
+    refreshBoardDeadline(board);
+    printCounts("", board->name, &board->counts);
+    for (List* list = board->lists; list != NULL; list = list->next) {
+        refreshListDeadline(list);
+        printCounts("  ", list->name, &list->counts);
+    }
+}
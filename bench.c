@@ -0,0 +1,280 @@
+// Storage benchmark: times pinning read snapshots of a generated dataset, compares plain, compressed
+// and borrowed-string loading on it, then times the organisation-wide report on more and more workers.
+// Build: make utboard-bench
+// Usage: utboard-bench [--replay session.txt] [users] [boards per user] [lists per board] [tasks per list]
+// Runs inside a "utboard-bench" directory so real data files are never touched.
+// --replay feeds a session recorded with "utboard --record session.txt" through the menus at full
+// speed instead and reports latency percentiles per operation; generated users log in as
+// "login user<N> secret<N * 7919>". The menu output goes to utboard-bench/replay-output.txt.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <windows.h>
+#include "functions.h"
+
+#define BENCH_DIRECTORY "utboard-bench"
+
+static const char* dataFiles[] = { "users.csv", "boards.csv", "lists.csv", "tasks.csv" };
+
+static double elapsedMs(LARGE_INTEGER start) {
+    LARGE_INTEGER now, frequency;
+    QueryPerformanceCounter(&now);
+    QueryPerformanceFrequency(&frequency);
+    return (double)(now.QuadPart - start.QuadPart) * 1000.0 / (double)frequency.QuadPart;
+}
+
+static long fileSize(const char* fileName) {
+    FILE* fp = fopen(fileName, "rb");
+    if (fp == NULL) {
+        return 0;
+    }
+    fseek(fp, 0, SEEK_END);
+    long size = ftell(fp);
+    fclose(fp);
+    return size;
+}
+
+static StringPool benchStrings;
+
+static char* formatString(const char* format, long a, long b) {
+    char buffer[64];
+    char* text = NULL;
+    snprintf(buffer, sizeof(buffer), format, a, b);
+    storeString(&benchStrings, &text, NULL, 0, buffer);
+    return text;
+}
+
+// Builds users -> boards -> lists -> tasks in memory with realistic, repetitive field values
+static User* generateDataset(int userCount, int boardsPerUser, int listsPerBoard, int tasksPerList) {
+    static const char* priorities[] = { "low", "medium", "high" };
+    static const char* listNames[] = { "Backlog", "Doing", "Review", "Done" };
+    User* users = NULL;
+    unsigned int seed = 12345;
+    char name[64];
+
+    for (int u = 0; u < userCount; u++) {
+        User* user = calloc(1, sizeof(User));
+        user->username = formatString("user%ld", u, 0);
+        user->password = formatString("secret%ld", u * 7919L, 0);
+        user->next = users;
+        users = user;
+        for (int b = 0; b < boardsPerUser; b++) {
+            snprintf(name, sizeof(name), "Project %d board %d", u, b);
+            Board* board = createBoardWithArgs(user, name);
+            for (int l = 0; l < listsPerBoard; l++) {
+                List* list = createListWithArgs(board, listNames[l % 4]);
+                for (int t = 0; t < tasksPerList; t++) {
+                    seed = seed * 1103515245u + 12345u;
+                    snprintf(name, sizeof(name), "Implement feature %d of milestone %u", t, (seed >> 24) % 50);
+                    char date[11];
+                    snprintf(date, sizeof(date), "%04u-%02u-%02u", 2024 + (seed >> 8) % 3, 1 + (seed >> 4) % 12, 1 + seed % 28);
+                    addTaskWithArgs(list, name, priorities[(seed >> 16) % 3], date);
+                }
+            }
+        }
+    }
+    return users;
+}
+
+static void runStorageBenchmark(const User* dataset, int compressed, int borrowed, const char* label) {
+    setCompressedStorage(compressed);
+    setBorrowedStrings(borrowed);
+
+    LARGE_INTEGER start;
+    QueryPerformanceCounter(&start);
+    saveAllData(dataset);
+    double saveMs = elapsedMs(start);
+
+    long totalSize = 0;
+    long tasksSize = fileSize("tasks.csv");
+    for (int i = 0; i < 4; i++) {
+        totalSize += fileSize(dataFiles[i]);
+    }
+
+    User* loaded = NULL;
+    QueryPerformanceCounter(&start);
+    if (!loadAllData(&loaded)) {
+        fprintf(stderr, "Not every record loaded in the %s run, its load time is for part of the data.\n", label);
+    }
+    double loadMs = elapsedMs(start);
+    freeAllData(&loaded);
+
+    printf("%-10s save %9.2f ms   load %9.2f ms   tasks.csv %11ld bytes   all files %11ld bytes\n",
+           label, saveMs, loadMs, tasksSize, totalSize);
+}
+
+// Best of several plain saveTasks runs, reported as MB/s of CSV written
+static void runTaskSaveThroughput(const User* dataset) {
+    setCompressedStorage(0);
+    double bestMs = 0;
+    for (int run = 0; run < 5; run++) {
+        LARGE_INTEGER start;
+        QueryPerformanceCounter(&start);
+        saveTasks(dataset);
+        double ms = elapsedMs(start);
+        if (run == 0 || ms < bestMs) {
+            bestMs = ms;
+        }
+    }
+    long size = fileSize("tasks.csv.tmp");
+    remove("tasks.csv.tmp");
+    printf("saveTasks %9.2f ms   %8.1f MB/s\n", bestMs, bestMs > 0 ? size / (bestMs * 1000.0) : 0.0);
+}
+
+// Best of several runs of the organisation-wide report on 1, 2, 4 ... workers up to the core count
+static void runReportScaling(const User* dataset) {
+    int cores = getCoreCount();
+    double serialMs = 0;
+    for (int workers = 1; ; workers = workers * 2 < cores ? workers * 2 : cores) {
+        double bestMs = 0;
+        for (int run = 0; run < 5; run++) {
+            FILE* out = fopen("report.txt", "w");
+            if (out == NULL) {
+                perror("Unable to open the report output");
+                return;
+            }
+            LARGE_INTEGER start;
+            QueryPerformanceCounter(&start);
+            printReport(dataset, REPORT_USERS, workers, out);
+            double ms = elapsedMs(start);
+            fclose(out);
+            if (run == 0 || ms < bestMs) {
+                bestMs = ms;
+            }
+        }
+        if (workers == 1) {
+            serialMs = bestMs;
+        }
+        printf("report %3d worker(s) %9.2f ms   speedup %5.2fx\n", workers, bestMs, bestMs > 0 ? serialMs / bestMs : 0.0);
+        if (workers == cores) {
+            break;
+        }
+    }
+    remove("report.txt");
+}
+
+// Pins a snapshot of the whole dataset, then pins again after an edit, which copies one user
+static void runSnapshotPinning(User* dataset) {
+    LARGE_INTEGER start;
+    QueryPerformanceCounter(&start);
+    Snapshot* first = pinSnapshot(dataset);
+    double firstMs = elapsedMs(start);
+    size_t pinned, copies, bytes;
+    getSnapshotMemory(&pinned, &copies, &bytes);
+
+    Task* task = dataset->boards != NULL && dataset->boards->lists != NULL ? dataset->boards->lists->tasks : NULL;
+    if (task != NULL) {
+        editTaskWithArgs(task, NULL, strcmp(task->priority, "high") == 0 ? "low" : "high", NULL);
+    }
+    QueryPerformanceCounter(&start);
+    Snapshot* second = pinSnapshot(dataset);
+    double secondMs = elapsedMs(start);
+    size_t copiesAfter;
+    getSnapshotMemory(&pinned, &copiesAfter, &bytes);
+
+    printf("snapshot first pin %9.2f ms   pin after one edit %9.2f ms   users copied %lu then %lu\n", firstMs,
+           secondMs, (unsigned long)copies, (unsigned long)(copiesAfter - copies));
+    if (first != NULL) {
+        releaseSnapshot(first);
+    }
+    if (second != NULL) {
+        releaseSnapshot(second);
+    }
+}
+
+static long countLines(FILE* fp) {
+    long lines = 0;
+    int ch, last = '\n';
+    while ((ch = fgetc(fp)) != EOF) {
+        if (ch == '\n') {
+            lines++;
+        }
+        last = ch;
+    }
+    rewind(fp);
+    return lines + (last != '\n');
+}
+
+// Saves the dataset and loads it back like the program does, then runs the recorded input
+static void runReplay(User* dataset, long inputLines) {
+    setCompressedStorage(0);
+    saveAllData(dataset);
+    User* users = NULL;
+    if (!loadAllData(&users)) {
+        freeAllData(&users);
+        return;
+    }
+
+    if (freopen("replay-output.txt", "w", stdout) == NULL) {
+        perror("Unable to redirect the menu output");
+        freeAllData(&users);
+        return;
+    }
+    setDiffRendering(0);
+    setActionTiming(1);
+
+    LARGE_INTEGER start;
+    QueryPerformanceCounter(&start);
+    runSession(&users);
+    finishBackgroundReads(1);
+    fflush(stdout);
+    double replayMs = elapsedMs(start);
+
+    fprintf(stderr, "Replayed %ld input lines in %.2f ms (%.0f lines/s)\n", inputLines, replayMs,
+            replayMs > 0 ? inputLines * 1000.0 / replayMs : 0.0);
+    printStats(stderr);
+    freeAllData(&users);
+    freeInputBuffer();
+    freeScreen();
+}
+
+int main(int argc, char* argv[]) {
+    const char* sessionFile = NULL;
+    if (argc > 2 && strcmp(argv[1], "--replay") == 0) {
+        sessionFile = argv[2];
+        argc -= 2;
+        argv += 2;
+    }
+    int userCount = argc > 1 ? atoi(argv[1]) : 100;
+    int boardsPerUser = argc > 2 ? atoi(argv[2]) : 5;
+    int listsPerBoard = argc > 3 ? atoi(argv[3]) : 4;
+    int tasksPerList = argc > 4 ? atoi(argv[4]) : 50;
+
+    long inputLines = 0;
+    if (sessionFile != NULL) {
+        // Opened before changing directory so relative paths name the caller's file
+        if (freopen(sessionFile, "r", stdin) == NULL) {
+            perror("Unable to open the session file");
+            return 1;
+        }
+        inputLines = countLines(stdin);
+    }
+
+    CreateDirectory(BENCH_DIRECTORY, NULL);
+    if (!SetCurrentDirectory(BENCH_DIRECTORY)) {
+        perror("Unable to enter the benchmark directory");
+        return 1;
+    }
+
+    User* dataset = generateDataset(userCount, boardsPerUser, listsPerBoard, tasksPerList);
+    printf("Dataset: %d users, %d boards, %d lists, %ld tasks\n", userCount, userCount * boardsPerUser,
+           userCount * boardsPerUser * listsPerBoard, (long)userCount * boardsPerUser * listsPerBoard * tasksPerList);
+
+    if (sessionFile != NULL) {
+        runReplay(dataset, inputLines);
+    } else {
+        runSnapshotPinning(dataset); // First, while the change sequence still runs on from generating the dataset
+        runStorageBenchmark(dataset, 0, 0, "plain");
+        runStorageBenchmark(dataset, 1, 0, "compressed");
+        runStorageBenchmark(dataset, 0, 1, "borrowed");
+        runTaskSaveThroughput(dataset);
+        runReportScaling(dataset);
+    }
+
+    for (int i = 0; i < 4; i++) {
+        remove(dataFiles[i]);
+    }
+    freeAllData(&dataset);
+    releaseStringPool(&benchStrings);
+    return 0;
+}
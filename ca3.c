@@ -8,60 +8,82 @@
 #define ENTER '\n'
 #define QUOTE '\"'
 
-int main(){
+int main(int argc, char* argv[]){
     system("color 5F");
-    User* users = NULL;
-    loadAllData(&users);
-
-    printLogo();
-    User* loggedInUser = NULL;
-    char* input;
-    char* rest;
-    char* command;
-    char* username;
-    char* password;
-
-    while (1) {
-        printf("Enter command (signup or login), followed by username and password in quotes if containing spaces, or 'exit' to quit:\n");
-        printf("> ");
-        input = dynamicInput();
-        rest = input;  // Initialize rest to the start of input
-
-        if (input == NULL || strncmp(input, "exit", 4) == 0) {
-            free(input);
-            break;
-        }
-
-        command = getNextToken(&rest);  // Extract command
-
-        if (command && (strcmp(command, "signup") == 0 || strcmp(command, "login") == 0)) {
-            username = getNextToken(&rest);  // Extract username
-            password = getNextToken(&rest);  // Extract password
-
-            if (username && password) {
-                if (strcmp(command, "signup") == 0) {
-                    loggedInUser = signupWithArgs(&users, username, password);
-                } else if (strcmp(command, "login") == 0) {
-                    loggedInUser = loginWithArgs(users, username, password);
-                }
-            } else {
-                printf("Invalid format. Please follow the '<command> \"<username>\" \"<password>\"' format.\n");
+    FILE* recording = NULL;
+    FILE* reminderLog = NULL;
+    int archiveAfterDays = -1;
+    const char* replicaPath = NULL;
+    const char* standbyPath = NULL;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--compress") == 0) {
+            setCompressedStorage(1); // Save the data files as compressed blocks
+        } else if (strcmp(argv[i], "--borrow") == 0) {
+            setBorrowedStrings(1); // Keep loaded strings in the file contents until edited
+        } else if (strcmp(argv[i], "--stats") == 0 && i + 1 < argc) {
+            setStatsInterval(atoi(argv[++i])); // Dump stats to stderr every N commands in batch runs
+        } else if (strcmp(argv[i], "--archive-after") == 0 && i + 1 < argc) {
+            archiveAfterDays = atoi(argv[++i]); // Archive tasks whose deadline passed more than N days ago
+        } else if (strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+            recording = fopen(argv[++i], "w"); // Save the typed input for utboard-bench --replay
+            if (recording == NULL) {
+                perror("Unable to open the recording file");
             }
-        } else {
-            printf("Unknown command. Please use 'signup' or 'login'.\n");
+            setInputRecording(recording);
+        } else if (strcmp(argv[i], "--reminders") == 0 && i + 1 < argc) {
+            reminderLog = fopen(argv[++i], "a"); // Log due-tomorrow, due-today and overdue events
+            if (reminderLog == NULL) {
+                perror("Unable to open the reminder log");
+            }
+            setReminderLog(reminderLog);
+        } else if (strcmp(argv[i], "--tombstone-retention") == 0 && i + 1 < argc) {
+            setTombstoneRetention(atol(argv[++i])); // Keep the deletions of the last N changes for exports
+        } else if (strcmp(argv[i], "--replicate") == 0 && i + 1 < argc) {
+            replicaPath = argv[++i]; // Stream every change to the standby listening on this socket
+        } else if (strcmp(argv[i], "--standby") == 0 && i + 1 < argc) {
+            standbyPath = argv[++i]; // Follow a primary on this socket, take over if it dies
         }
-
-        free(input);
-
-        if (loggedInUser) {
-            clearScreen();
-            boardsMenu(loggedInUser);
-            loggedInUser = NULL;
+    }
+    TRACE_START("utboard-trace.json");
+    User* users = NULL;
+    // Nothing is saved after a partial load, which would lose the records left out
+    int loaded = standbyPath == NULL ? loadAllData(&users) : runStandby(standbyPath, &users);
+    if (!loaded) {
+        freeAllData(&users);
+        TRACE_STOP();
+        return 1;
+    }
+    tickReminders();
+    if (archiveAfterDays >= 0) {
+        int archived = 0;
+        for (User* user = users; user != NULL; user = user->next) {
+            archived += archiveTasksOlderThan(user, archiveAfterDays);
         }
+        printf("Archived %d tasks whose deadline passed more than %d days ago.\n", archived, archiveAfterDays);
     }
 
+    if (replicaPath != NULL) {
+        startReplication(replicaPath, &users);
+    }
+
+    clearScreen();
+    runSession(&users);
+
+    finishBackgroundReads(1);
     saveAllData(users);
+    stopReplication();
     freeAllData(&users);
+    freeInputBuffer();
+    freeScreen();
+    if (reminderLog != NULL) {
+        setReminderLog(NULL);
+        fclose(reminderLog);
+    }
+    if (recording != NULL) {
+        setInputRecording(NULL);
+        fclose(recording);
+    }
+    TRACE_STOP();
     printf("Exiting the program.\n");
     return 0;
 }
@@ -0,0 +1,381 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <windows.h>
+#include "functions.h"
+
+// Change feed for incremental backups and syncs. Every change to a user, board, list or task
+// takes the next number of a single sequence and stores it in the record's modified field,
+// which is saved with the record; every deletion leaves a tombstone with its number, saved in
+// tombstones.csv. The changes since a number are then the records whose modified is above it
+// followed by the tombstones above it, and replaying exports in order on a copy of the data
+// files brings the copy up to date. Users, boards and lists also keep the newest number of
+// anything under them, deletions included, so an export only descends where something changed:
+// its cost follows the churn since the number, not the size of the data, and a read snapshot
+// (snapshot.c) copies only the users whose number moved. Records saved before sequence numbers
+// existed have 0 and are only part of full copies. Tombstones are kept for the last
+// tombstoneRetention changes; exports from before the oldest one kept have to start from 0.
+
+#define DEFAULT_TOMBSTONE_RETENTION 100000
+
+static long changeSequence = 0;      // Last number handed out
+static Tombstone* tombstones = NULL; // In sequence order
+static size_t tombstoneCount = 0;
+static size_t tombstoneCapacity = 0;
+static long tombstoneFloor = 0;      // Tombstones up to this number were pruned
+static long tombstoneRetention = DEFAULT_TOMBSTONE_RETENTION;
+static int replaying = 0;            // A change of the primary is being applied
+static long replayedSequence = 0;    // Its number
+
+static const char* recordFileNames[RECORD_TYPES] = { "users.csv", "boards.csv", "lists.csv", "tasks.csv" };
+
+long currentChangeSequence() {
+    return changeSequence;
+}
+
+const char* recordFileName(RecordType type) {
+    return recordFileNames[type];
+}
+
+// Record type stored in the given data file, or -1 if the file holds none
+int recordTypeOf(const char* fileName) {
+    for (int type = 0; type < RECORD_TYPES; type++) {
+        if (strcmp(fileName, recordFileNames[type]) == 0) {
+            return type;
+        }
+    }
+    return -1;
+}
+
+// Number for the change being made: the next one, or the primary's while a standby replays it
+static long takeSequence() {
+    return replaying ? replayedSequence : ++changeSequence;
+}
+
+// The touch functions stamp a record that was just created or changed; the record must already
+// be linked to its parent
+void touchUser(User* user) {
+    user->modified = takeSequence();
+    noteLoadedChange(user->modified, user, NULL, NULL);
+}
+
+void touchBoard(Board* board) {
+    board->modified = takeSequence();
+    noteLoadedChange(board->modified, board->user, board, NULL);
+}
+
+void touchList(List* list) {
+    list->modified = takeSequence();
+    noteLoadedChange(list->modified, list->board->user, list->board, list);
+}
+
+void touchTask(Task* task) {
+    List* list = task->list;
+    task->modified = takeSequence();
+    noteLoadedChange(task->modified, list->board->user, list->board, list);
+}
+
+// A standby (replica.c) applies each change of its primary between these two calls, so the
+// records and tombstones it makes carry the primary's number for the change
+void beginReplayedChange(long sequence) {
+    replaying = 1;
+    replayedSequence = sequence;
+    noteLoadedChange(sequence, NULL, NULL, NULL);
+}
+
+void endReplayedChange() {
+    replaying = 0;
+}
+
+// Takes in the number of a record read from the data files: new numbers must come after it,
+// and the record's user, board and list (any of which may be NULL) hold a change that recent
+void noteLoadedChange(long sequence, User* user, Board* board, List* list) {
+    if (sequence > changeSequence) {
+        changeSequence = sequence;
+    }
+    if (user != NULL && sequence > user->newestChange) {
+        user->newestChange = sequence;
+    }
+    if (board != NULL && sequence > board->newestChange) {
+        board->newestChange = sequence;
+    }
+    if (list != NULL && sequence > list->newestChange) {
+        list->newestChange = sequence;
+    }
+}
+
+void addTombstone(const Tombstone* tombstone) {
+    if (tombstoneCount == tombstoneCapacity) {
+        size_t capacity = tombstoneCapacity ? tombstoneCapacity * 2 : 64;
+        Tombstone* grown = realloc(tombstones, capacity * sizeof(Tombstone));
+        if (grown == NULL) {
+            perror("Memory allocation failed for tombstones");
+            return;
+        }
+        tombstones = grown;
+        tombstoneCapacity = capacity;
+    }
+    tombstones[tombstoneCount++] = *tombstone;
+    noteLoadedChange(tombstone->sequence, NULL, NULL, NULL);
+}
+
+// The user, board and list the record was deleted from (any of which may be NULL) take its number
+static void recordDeletion(RecordType type, long id, User* user, Board* board, List* list) {
+    Tombstone tombstone = { takeSequence(), id, type };
+    addTombstone(&tombstone);
+    noteLoadedChange(tombstone.sequence, user, board, list);
+}
+
+// The deletion functions are called before the record is freed. Deleting a list or board
+// leaves a tombstone for everything that goes with it, so a reader of the feed never has to
+// know which records belonged to which.
+void recordTaskDeletion(const Task* task) {
+    List* list = task->list;
+    recordDeletion(RECORD_TASK, task->id, list->board->user, list->board, list);
+}
+
+void recordListDeletion(const List* list) {
+    for (const Task* task = list->tasks; task != NULL; task = task->next) {
+        recordTaskDeletion(task);
+    }
+    recordDeletion(RECORD_LIST, list->id, list->board->user, list->board, NULL);
+}
+
+void recordBoardDeletion(const Board* board) {
+    for (const List* list = board->lists; list != NULL; list = list->next) {
+        recordListDeletion(list);
+    }
+    recordDeletion(RECORD_BOARD, board->id, board->user, NULL, NULL);
+}
+
+const Tombstone* getTombstones(size_t* count) {
+    *count = tombstoneCount;
+    return tombstones;
+}
+
+// Keeps the tombstones of the last changes changes when they are pruned
+void setTombstoneRetention(long changes) {
+    tombstoneRetention = changes;
+}
+
+// Drops the tombstones that are older than the retention and that a standby has already been
+// sent, so memory and tombstones.csv stop growing with every deletion ever made. Called by
+// saveAllData before the tombstones are written.
+void pruneTombstones() {
+    long floor = changeSequence - tombstoneRetention;
+    long replicated = replicatedSequence();
+    if (replicated < floor) {
+        floor = replicated;
+    }
+    if (floor <= tombstoneFloor) {
+        return;
+    }
+    size_t pruned = 0;
+    while (pruned < tombstoneCount && tombstones[pruned].sequence <= floor) {
+        pruned++;
+    }
+    tombstoneCount -= pruned;
+    memmove(tombstones, tombstones + pruned, tombstoneCount * sizeof(Tombstone));
+    if (tombstoneCount < tombstoneCapacity / 4) {
+        size_t capacity = tombstoneCount > 32 ? tombstoneCount * 2 : 64;
+        Tombstone* shrunk = realloc(tombstones, capacity * sizeof(Tombstone));
+        if (shrunk != NULL) {
+            tombstones = shrunk;
+            tombstoneCapacity = capacity;
+        }
+    }
+    tombstoneFloor = floor;
+}
+
+// The floor read back from tombstones.csv
+void notePrunedTombstones(long floor) {
+    if (floor > tombstoneFloor) {
+        tombstoneFloor = floor;
+    }
+    noteLoadedChange(floor, NULL, NULL, NULL);
+}
+
+long prunedTombstoneFloor() {
+    return tombstoneFloor;
+}
+
+// An export after since is complete only if no deletion after since was pruned; 0 exports
+// everything there is, for an empty copy. Says so and returns 0 otherwise.
+int changesAvailableSince(long since) {
+    if (since > 0 && since < tombstoneFloor) {
+        printf("Deletions up to sequence %ld are no longer kept. Export from 0 into an empty copy instead.\n",
+               tombstoneFloor);
+        return 0;
+    }
+    return 1;
+}
+
+void freeTombstones() {
+    free(tombstones);
+    tombstones = NULL;
+    tombstoneCount = tombstoneCapacity = 0;
+    tombstoneFloor = 0;
+    changeSequence = 0;
+}
+
+// A tombstone whose record exists again, as a task restored from the archive does
+static int isRecreated(const Tombstone* tombstone) {
+    switch (tombstone->type) {
+        case RECORD_BOARD:
+            return findBoardById(tombstone->id) != NULL;
+        case RECORD_LIST:
+            return findListById(tombstone->id) != NULL;
+        case RECORD_TASK:
+            return findTaskById(tombstone->id) != NULL;
+        default:
+            return 0;
+    }
+}
+
+static void writeChangeFields(DataWriter* writer, long sequence, const char* change, RecordType type) {
+    writeIdField(writer, sequence);
+    writeField(writer, change);
+    writeField(writer, recordFileNames[type]);
+}
+
+// Upserts of the records changed after sequence since, parents first
+static long writeUpserts(DataWriter* writer, const User* users, long since) {
+    long count = 0;
+    for (const User* user = users; user != NULL; user = user->next) {
+        if (user->newestChange <= since) {
+            continue;
+        }
+        if (user->modified > since) {
+            writeChangeFields(writer, user->modified, "upsert", RECORD_USER);
+            writeUserFields(writer, user);
+            endRecord(writer);
+            count++;
+        }
+        for (const Board* board = user->boards; board != NULL; board = board->next) {
+            if (board->newestChange <= since) {
+                continue;
+            }
+            if (board->modified > since) {
+                writeChangeFields(writer, board->modified, "upsert", RECORD_BOARD);
+                writeBoardFields(writer, board);
+                endRecord(writer);
+                count++;
+            }
+            for (const List* list = board->lists; list != NULL; list = list->next) {
+                if (list->newestChange <= since) {
+                    continue;
+                }
+                if (list->modified > since) {
+                    writeChangeFields(writer, list->modified, "upsert", RECORD_LIST);
+                    writeListFields(writer, list);
+                    endRecord(writer);
+                    count++;
+                }
+                for (const Task* task = list->tasks; task != NULL; task = task->next) {
+                    if (task->modified > since) {
+                        writeChangeFields(writer, task->modified, "upsert", RECORD_TASK);
+                        writeTaskFields(writer, task);
+                        endRecord(writer);
+                        count++;
+                    }
+                }
+            }
+        }
+    }
+    return count;
+}
+
+// Deletions after sequence since among deletions, which are in sequence order; with
+// skipRecreated the records that exist again are left out
+static long writeDeletions(DataWriter* writer, const Tombstone* deletions, size_t deletionCount, long since,
+                           int skipRecreated) {
+    long count = 0;
+    size_t first = deletionCount;
+    while (first > 0 && deletions[first - 1].sequence > since) {
+        first--;
+    }
+    for (size_t i = first; i < deletionCount; i++) {
+        const Tombstone* tombstone = &deletions[i];
+        if (skipRecreated && isRecreated(tombstone)) {
+            continue; // Its upsert is newer than the deletion
+        }
+        writeChangeFields(writer, tombstone->sequence, "delete", tombstone->type);
+        writeIdField(writer, tombstone->id);
+        endRecord(writer);
+        count++;
+    }
+    return count;
+}
+
+// Writes the records changed and deleted after sequence since. Each line holds the change's
+// number, "upsert" or "delete", the data file it applies to and then either the whole record,
+// as that file stores it, or the ID of the deleted record. Upserts come parents first, then the
+// deletions in order. Returns the number of changes written.
+long writeChangesSince(DataWriter* writer, const User* users, long since) {
+    long count = writeUpserts(writer, users, since);
+    return count + writeDeletions(writer, tombstones, tombstoneCount, since, 1);
+}
+
+// Copies the tombstones whose records do not exist again, for a read snapshot (snapshot.c);
+// returns 0 if there was no memory for the copy
+int copyLiveTombstones(Tombstone** copy, size_t* count) {
+    *copy = NULL;
+    *count = 0;
+    if (tombstoneCount == 0) {
+        return 1;
+    }
+    *copy = malloc(tombstoneCount * sizeof(Tombstone));
+    if (*copy == NULL) {
+        return 0;
+    }
+    for (size_t i = 0; i < tombstoneCount; i++) {
+        if (!isRecreated(&tombstones[i])) {
+            (*copy)[(*count)++] = tombstones[i];
+        }
+    }
+    return 1;
+}
+
+// Writes the changes after sequence since to fileName, under a header line; see
+// writeChangesSince and writeDeletions. Returns the number of changes written, or -1 if the file
+// could not be written.
+static long exportChanges(const User* users, const Tombstone* deletions, size_t deletionCount, int skipRecreated,
+                          long since, const char* fileName) {
+    DataWriter writer;
+    if (!openDataWriter(&writer, fileName)) {
+        perror("Unable to open the change file for writing");
+        return -1;
+    }
+    writeField(&writer, "Sequence");
+    writeField(&writer, "Change");
+    writeField(&writer, "File");
+    writeField(&writer, "Record");
+    endRecord(&writer);
+
+    long count = writeUpserts(&writer, users, since);
+    count += writeDeletions(&writer, deletions, deletionCount, since, skipRecreated);
+
+    char tempName[FILENAME_MAX];
+    snprintf(tempName, sizeof(tempName), "%s.tmp", fileName);
+    if (!closeDataWriter(&writer) || !MoveFileEx(tempName, fileName, MOVEFILE_REPLACE_EXISTING)) {
+        fprintf(stderr, "Unable to write %s.\n", fileName);
+        remove(tempName);
+        return -1;
+    }
+    return count;
+}
+
+long exportChangesSince(const User* users, long since, const char* fileName) {
+    if (!changesAvailableSince(since)) {
+        return -1;
+    }
+    return exportChanges(users, tombstones, tombstoneCount, 1, since, fileName);
+}
+
+// The same from a read snapshot, whose tombstones were copied without the recreated records.
+// Touches nothing but the snapshot, so it can run on another thread while the model changes.
+long exportSnapshotChanges(const Snapshot* snapshot, long since, const char* fileName) {
+    size_t deletionCount;
+    const Tombstone* deletions = snapshotTombstones(snapshot, &deletionCount);
+    return exportChanges(snapshotUsers(snapshot), deletions, deletionCount, 0, since, fileName);
+}
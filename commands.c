@@ -0,0 +1,613 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <limits.h>
+#include "functions.h"
+
+#define MAX_COMMAND_ARGS 6
+#define MAX_PATH_SEGMENTS 3
+#define MAX_ARCHIVE_DAYS 100000
+
+// One argument of a command; "Work"/"Backlog"/3 has three segments
+typedef struct CommandArg {
+    char* segments[MAX_PATH_SEGMENTS];
+    int segmentCount;
+} CommandArg;
+
+typedef struct Command {
+    const char* name;
+    int minArgs;
+    int maxArgs;
+    void (*run)(CommandContext* context, CommandArg* args, int argCount);
+    const char* usage;
+} Command;
+
+enum { PATH_BOARD = 1, PATH_LIST = 2, PATH_TASK = 3 };
+
+// Resolves a lone "#ID" through the ID index and fills in its parents; the entity must belong
+// to the logged-in user
+static int resolveById(const CommandContext* context, const char* key, int depth,
+                       Board** board, List** list, Task** task) {
+    char* end;
+    long id = strtol(key + 1, &end, 10);
+    *board = NULL;
+    if (*end == '\0' && depth == PATH_TASK && (*task = findTaskById(id)) != NULL) {
+        *list = (*task)->list;
+        *board = (*list)->board;
+    } else if (*end == '\0' && depth == PATH_LIST && (*list = findListById(id)) != NULL) {
+        *board = (*list)->board;
+    } else if (*end == '\0' && depth == PATH_BOARD) {
+        *board = findBoardById(id);
+    }
+    if (*board == NULL || (*board)->user != context->user) {
+        printf("No %s with ID %s.\n", depth == PATH_TASK ? "task" : depth == PATH_LIST ? "list" : "board", key + 1);
+        return 0;
+    }
+    return 1;
+}
+
+// Resolves a path from the right: the last segment names an entity at the given depth and the
+// leading levels that are not written out come from the menu the command was typed in
+static int resolvePath(const CommandContext* context, const CommandArg* arg, int depth,
+                       Board** board, List** list, Task** task) {
+    int missing = depth - arg->segmentCount;
+    int segment = 0;
+    if (missing < 0) {
+        printf("Too many path segments.\n");
+        return 0;
+    }
+    if (arg->segmentCount == 1 && arg->segments[0][0] == '#') {
+        return resolveById(context, arg->segments[0], depth, board, list, task);
+    }
+
+    if (missing >= PATH_BOARD) {
+        *board = context->board;
+        if (*board == NULL) {
+            printf("Open a board first or give the board name.\n");
+            return 0;
+        }
+    } else {
+        *board = findBoard(context->user, arg->segments[segment]);
+        if (*board == NULL) {
+            printf("Board '%s' not found.\n", arg->segments[segment]);
+            return 0;
+        }
+        segment++;
+    }
+    if (depth == PATH_BOARD) {
+        return 1;
+    }
+
+    if (missing >= PATH_LIST) {
+        *list = context->board == *board ? context->list : NULL;
+        if (*list == NULL) {
+            printf("Open a list first or give the list name.\n");
+            return 0;
+        }
+    } else {
+        *list = findList(*board, arg->segments[segment]);
+        if (*list == NULL) {
+            printf("List '%s' not found.\n", arg->segments[segment]);
+            return 0;
+        }
+        segment++;
+    }
+    if (depth == PATH_LIST) {
+        return 1;
+    }
+
+    *task = findTask(*list, arg->segments[segment]);
+    if (*task == NULL) {
+        printf("Task '%s' not found.\n", arg->segments[segment]);
+        return 0;
+    }
+    return 1;
+}
+
+// Resolves everything but the last segment, which names an entity that is about to be created
+static int resolveParent(const CommandContext* context, const CommandArg* arg, int depth,
+                         Board** board, List** list, const char** name) {
+    CommandArg parent = *arg;
+    parent.segmentCount--;
+    *name = arg->segments[arg->segmentCount - 1];
+    Task* unused = NULL;
+    return resolvePath(context, &parent, depth - 1, board, list, &unused);
+}
+
+static void runHelp(CommandContext* context, CommandArg* args, int argCount);
+
+static void runBoards(CommandContext* context, CommandArg* args, int argCount) {
+    displayBoards(context->user);
+}
+
+static void runLists(CommandContext* context, CommandArg* args, int argCount) {
+    Board* board = context->board;
+    List* list = NULL;
+    Task* task = NULL;
+    if (argCount > 0 && !resolvePath(context, &args[0], PATH_BOARD, &board, &list, &task)) {
+        return;
+    }
+    if (board == NULL) {
+        printf("Open a board first or give the board name.\n");
+        return;
+    }
+    displayLists(board);
+}
+
+static void runTasks(CommandContext* context, CommandArg* args, int argCount) {
+    Board* board = context->board;
+    List* list = context->list;
+    Task* task = NULL;
+    if (argCount > 0 && !resolvePath(context, &args[0], PATH_LIST, &board, &list, &task)) {
+        return;
+    }
+    if (list == NULL) {
+        printf("Open a list first or give the list name.\n");
+        return;
+    }
+    displayTasks(list);
+}
+
+static void runMakeBoard(CommandContext* context, CommandArg* args, int argCount) {
+    if (args[0].segmentCount != 1) {
+        printf("Board names cannot contain '/' unless quoted.\n");
+        return;
+    }
+    if (createBoardWithArgs(context->user, args[0].segments[0])) {
+        printf("Board '%s' created successfully.\n", args[0].segments[0]);
+    }
+}
+
+static void runRemoveBoard(CommandContext* context, CommandArg* args, int argCount) {
+    Board* board = NULL;
+    List* list = NULL;
+    Task* task = NULL;
+    if (!resolvePath(context, &args[0], PATH_BOARD, &board, &list, &task)) {
+        return;
+    }
+    if (board == context->board) {
+        printf("Cannot delete the board that is currently open.\n");
+        return;
+    }
+    deleteBoardWithArgs(context->user, board);
+    printf("Board deleted successfully.\n");
+}
+
+static void runMakeList(CommandContext* context, CommandArg* args, int argCount) {
+    Board* board = NULL;
+    List* list = NULL;
+    const char* name;
+    if (!resolveParent(context, &args[0], PATH_LIST, &board, &list, &name)) {
+        return;
+    }
+    if (createListWithArgs(board, name)) {
+        printf("List '%s' created successfully.\n", name);
+    }
+}
+
+static void runRemoveList(CommandContext* context, CommandArg* args, int argCount) {
+    Board* board = NULL;
+    List* list = NULL;
+    Task* task = NULL;
+    if (!resolvePath(context, &args[0], PATH_LIST, &board, &list, &task)) {
+        return;
+    }
+    if (list == context->list) {
+        printf("Cannot delete the list that is currently open.\n");
+        return;
+    }
+    deleteListWithArgs(board, list);
+    printf("List deleted successfully.\n");
+}
+
+static void runAddTask(CommandContext* context, CommandArg* args, int argCount) {
+    Board* board = NULL;
+    List* list = NULL;
+    const char* name;
+    if (!resolveParent(context, &args[0], PATH_TASK, &board, &list, &name)) {
+        return;
+    }
+    const char* priority = args[1].segments[0];
+    const char* date = args[2].segments[0];
+    if (!isValidDate((char*)date)) {
+        printf("Invalid date format. Use YYYY-MM-DD.\n");
+        return;
+    }
+    if (addTaskWithArgs(list, name, priority, date)) {
+        printf("Task '%s' added successfully.\n", name);
+    }
+}
+
+static void runEditTask(CommandContext* context, CommandArg* args, int argCount) {
+    Board* board = NULL;
+    List* list = NULL;
+    Task* task = NULL;
+    if (!resolvePath(context, &args[0], PATH_TASK, &board, &list, &task)) {
+        return;
+    }
+    const char* field = args[1].segments[0];
+    const char* value = args[2].segments[0];
+    int ok;
+    if (strcmp(field, "name") == 0) {
+        ok = editTaskWithArgs(task, value, NULL, NULL);
+    } else if (strcmp(field, "priority") == 0) {
+        ok = editTaskWithArgs(task, NULL, value, NULL);
+    } else if (strcmp(field, "date") == 0 || strcmp(field, "deadline") == 0) {
+        if (!isValidDate((char*)value)) {
+            printf("Invalid date format. Use YYYY-MM-DD.\n");
+            return;
+        }
+        ok = editTaskWithArgs(task, NULL, NULL, value);
+    } else {
+        printf("Unknown field '%s'. Use name, priority or date.\n", field);
+        return;
+    }
+    printf(ok ? "Task updated successfully.\n" : "Unable to update the task.\n");
+}
+
+static void runRemoveTask(CommandContext* context, CommandArg* args, int argCount) {
+    Board* board = NULL;
+    List* list = NULL;
+    Task* task = NULL;
+    if (!resolvePath(context, &args[0], PATH_TASK, &board, &list, &task)) {
+        return;
+    }
+    deleteTaskWithArgs(list, task);
+    printf("Task deleted successfully.\n");
+}
+
+static void runMoveTask(CommandContext* context, CommandArg* args, int argCount) {
+    Board* board = NULL;
+    List* list = NULL;
+    Task* task = NULL;
+    if (!resolvePath(context, &args[0], PATH_TASK, &board, &list, &task)) {
+        return;
+    }
+    // The destination is looked up on the task's own board unless it names a board itself
+    CommandContext taskContext = { context->user, board, NULL };
+    Board* targetBoard = NULL;
+    List* targetList = NULL;
+    Task* unused = NULL;
+    if (!resolvePath(&taskContext, &args[1], PATH_LIST, &targetBoard, &targetList, &unused)) {
+        return;
+    }
+    if (targetList == list) {
+        printf("The task is already in list '%s'.\n", list->name);
+        return;
+    }
+    moveTaskWithArgs(list, task, targetList);
+    printf("Task '%s' moved to list '%s'.\n", task->name, targetList->name);
+}
+
+static void runReorderTask(CommandContext* context, CommandArg* args, int argCount) {
+    Board* board = NULL;
+    List* list = NULL;
+    Task* task = NULL;
+    if (!resolvePath(context, &args[0], PATH_TASK, &board, &list, &task)) {
+        return;
+    }
+    char* end;
+    long position = strtol(args[1].segments[0], &end, 10);
+    if (*end != '\0' || position > INT_MAX || !reorderTaskWithArgs(list, task, (int)position)) {
+        printf("Position must be a number from 1 to the number of tasks in the list.\n");
+        return;
+    }
+    printf("Task '%s' moved to position %ld.\n", task->name, position);
+}
+
+static void runArchive(CommandContext* context, CommandArg* args, int argCount) {
+    if (argCount == 2) {
+        const char* mode = args[0].segmentCount == 1 ? args[0].segments[0] : "";
+        if (strcmp(mode, "older") == 0) {
+            char* end;
+            long days = strtol(args[1].segments[0], &end, 10);
+            if (*end != '\0' || days < 0 || days > MAX_ARCHIVE_DAYS) {
+                printf("Give the age in days, for example 'archive older 90'.\n");
+                return;
+            }
+            int count = archiveTasksOlderThan(context->user, (int)days);
+            printf("Archived %d task(s) whose deadline passed more than %ld days ago.\n", count, days);
+        } else if (strcmp(mode, "search") == 0) {
+            int count = searchArchive(context->user, args[1].segments[0]);
+            if (count < 0) {
+                printf("The archive could not be read.\n");
+            } else if (count == 0) {
+                printf("No archived tasks match '%s'.\n", args[1].segments[0]);
+            }
+        } else {
+            printf("Usage: %s\n", "archive [[board/]list/]task | archive older DAYS | archive search TEXT");
+        }
+        return;
+    }
+
+    Board* board = NULL;
+    List* list = NULL;
+    Task* task = NULL;
+    if (!resolvePath(context, &args[0], PATH_TASK, &board, &list, &task)) {
+        return;
+    }
+    if (archiveTaskWithArgs(list, task)) {
+        printf("Task '%s' archived; 'restore #%ld' brings it back.\n", task->name, task->id);
+    }
+}
+
+static void runRestore(CommandContext* context, CommandArg* args, int argCount) {
+    const char* key = args[0].segments[0];
+    const char* digits = key[0] == '#' ? key + 1 : key;
+    char* end;
+    long id = strtol(digits, &end, 10);
+    if (args[0].segmentCount != 1 || end == digits || *end != '\0') {
+        printf("Give the ID of an archived task, for example 'restore #42'.\n");
+        return;
+    }
+    ArchivedTask* archived = findArchivedTask(context->user, id);
+    if (archived == NULL) {
+        printf("No archived task with ID %ld.\n", id);
+        return;
+    }
+
+    List* list = NULL;
+    if (argCount == 2) {
+        Board* board = NULL;
+        Task* unused = NULL;
+        if (!resolvePath(context, &args[1], PATH_LIST, &board, &list, &unused)) {
+            return;
+        }
+    } else {
+        list = findListById(archived->listId);
+        if (list == NULL || list->board->user != context->user) {
+            printf("The task's list no longer exists; give a list to restore it into.\n");
+            return;
+        }
+    }
+    Task* task = restoreTaskWithArgs(archived, list);
+    printf("Task '%s' (#%ld) restored to list '%s'.\n", task->name, task->id, list->name);
+}
+
+static void runSortTasks(CommandContext* context, CommandArg* args, int argCount) {
+    Board* board = context->board;
+    List* list = context->list;
+    Task* task = NULL;
+    if (argCount == 2 && !resolvePath(context, &args[0], PATH_LIST, &board, &list, &task)) {
+        return;
+    }
+    if (list == NULL) {
+        printf("Open a list first or give the list name.\n");
+        return;
+    }
+    const char* order = args[argCount - 1].segments[0];
+    if (strcmp(order, "priority") == 0) {
+        sortTasks(list, SORT_BY_PRIORITY);
+        printf("Tasks have been sorted by priority.\n");
+    } else if (strcmp(order, "date") == 0) {
+        sortTasks(list, SORT_BY_DATE);
+        printf("Tasks have been sorted by date.\n");
+    } else {
+        printf("Unknown sort order '%s'. Use priority or date.\n", order);
+    }
+}
+
+static void runAllTasks(CommandContext* context, CommandArg* args, int argCount) {
+    const char* order = argCount == 1 ? args[0].segments[0] : "date";
+    if (strcmp(order, "priority") == 0) {
+        showAllTasks(context->user, SORT_BY_PRIORITY);
+    } else if (strcmp(order, "date") == 0) {
+        showAllTasks(context->user, SORT_BY_DATE);
+    } else {
+        printf("Unknown sort order '%s'. Use priority or date.\n", order);
+    }
+}
+
+static void runUpcoming(CommandContext* context, CommandArg* args, int argCount) {
+    showUpcomingTasks(context->user);
+}
+
+static void runSummary(CommandContext* context, CommandArg* args, int argCount) {
+    Board* board = NULL;
+    List* list = NULL;
+    Task* task = NULL;
+    if (argCount > 0 && !resolvePath(context, &args[0], PATH_BOARD, &board, &list, &task)) {
+        return;
+    }
+    printTaskSummary(context->user, board);
+}
+
+// Exports every user's changes, not only the logged-in user's, as it feeds backups of the data
+// files. The export runs on a snapshot in the background and is reported on before a later prompt.
+static void runChangesSince(CommandContext* context, CommandArg* args, int argCount) {
+    char* end;
+    long since = strtol(args[0].segments[0], &end, 10);
+    if (args[0].segmentCount != 1 || *end != '\0' || since < 0) {
+        printf("Give the sequence number of the last export, for example 'changes-since 1200', or 0.\n");
+        return;
+    }
+    const char* fileName = argCount == 2 ? args[1].segments[0] : "changes.csv";
+    if (argCount == 2 && args[1].segmentCount != 1) {
+        printf("Quote file paths that contain '/'.\n");
+        return;
+    }
+    if (!exportLoadedChanges(since, fileName)) {
+        printf("The changes could not be exported.\n");
+        return;
+    }
+    printf("Exporting the changes after sequence %ld, up to sequence %ld, to %s.\n", since, currentChangeSequence(),
+           fileName);
+}
+
+// Reports on every user, not only the logged-in one, like changes-since. A report into a file
+// runs on a snapshot in the background, the same way.
+static void runReport(CommandContext* context, CommandArg* args, int argCount) {
+    ReportType type;
+    if (args[0].segmentCount != 1 || !parseReportType(args[0].segments[0], &type)) {
+        printf("Choose a report: overdue, users or priorities.\n");
+        return;
+    }
+    const char* fileName = argCount == 2 ? args[1].segments[0] : NULL;
+    if (argCount == 2 && args[1].segmentCount != 1) {
+        printf("Quote file paths that contain '/'.\n");
+        return;
+    }
+    if (!reportLoadedData(type, fileName)) {
+        printf("The report could not be made.\n");
+    } else if (fileName != NULL) {
+        printf("Writing the report as of sequence %ld to %s.\n", currentChangeSequence(), fileName);
+    }
+}
+
+// Scrolls the task view of the tasks menu by whole pages; the menu redraws it after the command
+static void scrollTaskView(CommandContext* context, CommandArg* args, int argCount, int direction) {
+    int pages = 1;
+    if (argCount == 1) {
+        char* end;
+        pages = (int)strtol(args[0].segments[0], &end, 10);
+        if (args[0].segmentCount != 1 || *end != '\0' || pages < 1) {
+            printf("Give the number of pages to scroll, for example 'next 3'.\n");
+            return;
+        }
+    }
+    if (context->list == NULL) {
+        printf("Open a list first.\n");
+    } else if (!scrollViewport(direction * pages)) {
+        printf("All tasks are already shown.\n");
+    }
+}
+
+static void runPage(CommandContext* context, CommandArg* args, int argCount) {
+    char* end;
+    long page = strtol(args[0].segments[0], &end, 10);
+    if (args[0].segmentCount != 1 || *end != '\0' || page < 1 || page > INT_MAX) {
+        printf("Give a page number, for example 'page 12'.\n");
+    } else if (context->list == NULL) {
+        printf("Open a list first.\n");
+    } else if (!jumpViewport((int)page)) {
+        printf("All tasks are already shown.\n");
+    }
+}
+
+static void runNextPage(CommandContext* context, CommandArg* args, int argCount) {
+    scrollTaskView(context, args, argCount, 1);
+}
+
+static void runPreviousPage(CommandContext* context, CommandArg* args, int argCount) {
+    scrollTaskView(context, args, argCount, -1);
+}
+
+static void runStats(CommandContext* context, CommandArg* args, int argCount) {
+    printStats(stdout);
+}
+
+static void runSave(CommandContext* context, CommandArg* args, int argCount) {
+    printf(saveLoadedData() ? "Data saved.\n" : "Data could not be saved.\n");
+}
+
+static const Command commands[] = {
+    { "help", 0, 0, runHelp, "help" },
+    { "boards", 0, 0, runBoards, "boards" },
+    { "lists", 0, 1, runLists, "lists [board]" },
+    { "tasks", 0, 1, runTasks, "tasks [[board/]list]" },
+    { "next", 0, 1, runNextPage, "next [pages]" },
+    { "prev", 0, 1, runPreviousPage, "prev [pages]" },
+    { "page", 1, 1, runPage, "page NUMBER" },
+    { "mkboard", 1, 1, runMakeBoard, "mkboard \"name\"" },
+    { "rmboard", 1, 1, runRemoveBoard, "rmboard board" },
+    { "mklist", 1, 1, runMakeList, "mklist [board/]\"name\"" },
+    { "rmlist", 1, 1, runRemoveList, "rmlist [board/]list" },
+    { "add", 3, 3, runAddTask, "add [[board/]list/]\"name\" priority YYYY-MM-DD" },
+    { "edit", 3, 3, runEditTask, "edit [[board/]list/]task name|priority|date value" },
+    { "rm", 1, 1, runRemoveTask, "rm [[board/]list/]task" },
+    { "move", 2, 2, runMoveTask, "move [[board/]list/]task [board/]list" },
+    { "reorder", 2, 2, runReorderTask, "reorder [[board/]list/]task position" },
+    { "sort", 1, 2, runSortTasks, "sort [[board/]list] priority|date" },
+    { "archive", 1, 2, runArchive, "archive [[board/]list/]task | archive older DAYS | archive search TEXT" },
+    { "restore", 1, 2, runRestore, "restore #ID [[board/]list]" },
+    { "all", 0, 1, runAllTasks, "all [priority|date]" },
+    { "upcoming", 0, 0, runUpcoming, "upcoming" },
+    { "summary", 0, 1, runSummary, "summary [board]" },
+    { "save", 0, 0, runSave, "save" },
+    { "changes-since", 1, 2, runChangesSince, "changes-since SEQUENCE [file]" },
+    { "report", 1, 2, runReport, "report overdue|users|priorities [file]" },
+    { "stats", 0, 0, runStats, "stats" },
+};
+
+#define COMMAND_COUNT (sizeof(commands) / sizeof(commands[0]))
+
+static void runHelp(CommandContext* context, CommandArg* args, int argCount) {
+    printf("Commands (boards, lists and tasks are given by number, by name or by #ID; quote names that contain spaces):\n");
+    for (size_t i = 0; i < COMMAND_COUNT; i++) {
+        printf("  %s\n", commands[i].usage);
+    }
+}
+
+// Parses and runs one command line in place; returns 0 if the line was not a valid command
+int executeCommand(CommandContext* context, char* line) {
+    char* rest = line;
+    char* verb = getNextToken(&rest);
+    if (verb == NULL) {
+        return 0;
+    }
+
+    const Command* command = NULL;
+    for (size_t i = 0; i < COMMAND_COUNT; i++) {
+        if (strcmp(commands[i].name, verb) == 0) {
+            command = &commands[i];
+            break;
+        }
+    }
+    if (command == NULL) {
+        printf("Unknown command '%s'. Type 'help' for a list of commands.\n", verb);
+        return 0;
+    }
+
+    CommandArg args[MAX_COMMAND_ARGS];
+    int argCount = 0;
+    char separator = ' ';
+    char* token;
+    while ((token = scanToken(&rest, " /", &separator)) != NULL) {
+        if (argCount == MAX_COMMAND_ARGS) {
+            argCount++; // Too many, reported below
+            break;
+        }
+        CommandArg* arg = &args[argCount++];
+        arg->segmentCount = 0;
+        arg->segments[arg->segmentCount++] = token;
+        // Segments joined by '/' belong to the same argument
+        while (separator == '/' && arg->segmentCount < MAX_PATH_SEGMENTS &&
+               (token = scanToken(&rest, " /", &separator)) != NULL) {
+            arg->segments[arg->segmentCount++] = token;
+        }
+    }
+
+    if (argCount < command->minArgs || argCount > command->maxArgs) {
+        printf("Usage: %s\n", command->usage);
+        return 0;
+    }
+    long long startTicks = statsClock();
+    command->run(context, args, argCount);
+    recordCommandLatency(command->name, startTicks);
+    TRACE_END(startTicks, command->name);
+    return 1;
+}
+
+// Reads a menu line: a number picks a menu option and anything else is run as a command.
+// Returns the option, 0 after a command or an empty line, or -1 at the end of input.
+int readMenuChoice(CommandContext* context) {
+    tickReminders(); // Deadline events that came due since the last prompt
+    finishBackgroundReads(0); // And the reads that finished
+    char* line = readInputLine();
+    if (line == NULL) {
+        return -1;
+    }
+    while (*line == ' ') {
+        line++;
+    }
+    if (*line == '\0') {
+        return 0;
+    }
+    if (isdigit((unsigned char)*line)) {
+        int choice = atoi(line);
+        return choice > 0 ? choice : -2; // Keep 0 for "command handled"
+    }
+    executeCommand(context, line);
+    return 0;
+}
@@ -0,0 +1,209 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "functions.h"
+
+// Block format (LZ77, byte oriented):
+//   sequence := token [literal length bytes] literals [offset (2 bytes, little endian) [match length bytes]]
+// The high nibble of the token is the literal count, the low nibble the match length minus
+// MIN_MATCH; a nibble of 15 is continued by bytes that are added until one is below 255.
+// The last sequence of a block carries literals only. Blocks never refer to other blocks.
+
+#define MIN_MATCH 4
+#define MAX_OFFSET 65535
+#define HASH_BITS 14
+
+static unsigned int read32(const unsigned char* p) {
+    unsigned int value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+static unsigned int hash32(unsigned int value) {
+    return (value * 2654435761u) >> (32 - HASH_BITS);
+}
+
+static unsigned char* writeLength(unsigned char* out, size_t length) {
+    while (length >= 255) {
+        *out++ = 255;
+        length -= 255;
+    }
+    *out++ = (unsigned char)length;
+    return out;
+}
+
+static unsigned char* writeSequence(unsigned char* out, const unsigned char* literals, size_t literalCount,
+                                    size_t offset, size_t matchLength) {
+    unsigned char* token = out++;
+    *token = (unsigned char)((literalCount >= 15 ? 15 : literalCount) << 4);
+    if (literalCount >= 15) {
+        out = writeLength(out, literalCount - 15);
+    }
+    memcpy(out, literals, literalCount);
+    out += literalCount;
+    if (matchLength == 0) {
+        return out; // Final literals-only sequence
+    }
+    *out++ = (unsigned char)(offset & 0xFF);
+    *out++ = (unsigned char)(offset >> 8);
+    size_t extra = matchLength - MIN_MATCH;
+    *token |= (unsigned char)(extra >= 15 ? 15 : extra);
+    if (extra >= 15) {
+        out = writeLength(out, extra - 15);
+    }
+    return out;
+}
+
+// Worst case output size for a block of rawSize bytes that does not compress at all
+size_t compressBound(size_t rawSize) {
+    return rawSize + rawSize / 255 + 16;
+}
+
+// Compresses one block into dst; returns the compressed size, or 0 if the block does not shrink
+size_t compressBlock(const char* src, size_t srcSize, char* dst, size_t dstCapacity) {
+    if (srcSize < MIN_MATCH * 2 || dstCapacity < compressBound(srcSize)) {
+        return 0;
+    }
+    const unsigned char* in = (const unsigned char*)src;
+    const unsigned char* inEnd = in + srcSize;
+    const unsigned char* matchLimit = inEnd - MIN_MATCH;
+    const unsigned char* anchor = in;
+    unsigned char* out = (unsigned char*)dst;
+
+    size_t* table = calloc((size_t)1 << HASH_BITS, sizeof(size_t)); // Position + 1, 0 means empty
+    if (table == NULL) {
+        return 0;
+    }
+
+    const unsigned char* ip = in;
+    while (ip <= matchLimit) {
+        unsigned int h = hash32(read32(ip));
+        size_t candidate = table[h];
+        table[h] = (size_t)(ip - in) + 1;
+
+        if (candidate != 0) {
+            const unsigned char* ref = in + candidate - 1;
+            if ((size_t)(ip - ref) <= MAX_OFFSET && read32(ref) == read32(ip)) {
+                const unsigned char* matchEnd = ip + MIN_MATCH;
+                const unsigned char* refEnd = ref + MIN_MATCH;
+                while (matchEnd < inEnd && *matchEnd == *refEnd) {
+                    matchEnd++;
+                    refEnd++;
+                }
+                out = writeSequence(out, anchor, ip - anchor, ip - ref, matchEnd - ip);
+                // Remember a position inside the match so repeated fields keep matching
+                if (matchEnd - 2 <= matchLimit) {
+                    table[hash32(read32(matchEnd - 2))] = (size_t)(matchEnd - 2 - in) + 1;
+                }
+                ip = matchEnd;
+                anchor = ip;
+                continue;
+            }
+        }
+        ip++;
+    }
+    out = writeSequence(out, anchor, inEnd - anchor, 0, 0);
+    free(table);
+
+    size_t compressedSize = out - (unsigned char*)dst;
+    return compressedSize < srcSize ? compressedSize : 0;
+}
+
+static int readLength(const unsigned char** ip, const unsigned char* inEnd, size_t* length) {
+    unsigned char byte;
+    do {
+        if (*ip >= inEnd) {
+            return 0;
+        }
+        byte = *(*ip)++;
+        *length += byte;
+    } while (byte == 255);
+    return 1;
+}
+
+// Decompresses one block; returns 1 if it decoded to exactly rawSize bytes
+int decompressBlock(const char* src, size_t srcSize, char* dst, size_t rawSize) {
+    const unsigned char* ip = (const unsigned char*)src;
+    const unsigned char* inEnd = ip + srcSize;
+    unsigned char* op = (unsigned char*)dst;
+    unsigned char* outEnd = op + rawSize;
+
+    while (ip < inEnd) {
+        unsigned char token = *ip++;
+        size_t literalCount = token >> 4;
+        if (literalCount == 15 && !readLength(&ip, inEnd, &literalCount)) {
+            return 0;
+        }
+        if (literalCount > (size_t)(inEnd - ip) || literalCount > (size_t)(outEnd - op)) {
+            return 0;
+        }
+        memcpy(op, ip, literalCount);
+        ip += literalCount;
+        op += literalCount;
+        if (ip >= inEnd) {
+            break; // The last sequence has no match
+        }
+
+        if (inEnd - ip < 2) {
+            return 0;
+        }
+        size_t offset = ip[0] | ((size_t)ip[1] << 8);
+        ip += 2;
+        size_t matchLength = token & 15;
+        if (matchLength == 15 && !readLength(&ip, inEnd, &matchLength)) {
+            return 0;
+        }
+        matchLength += MIN_MATCH;
+        if (offset == 0 || offset > (size_t)(op - (unsigned char*)dst) || matchLength > (size_t)(outEnd - op)) {
+            return 0;
+        }
+        const unsigned char* ref = op - offset;
+        while (matchLength--) {
+            *op++ = *ref++; // Byte by byte, the match may overlap its own output
+        }
+    }
+    return op == outEnd;
+}
+
+static void writeUint32(unsigned char* p, unsigned int value) {
+    p[0] = (unsigned char)value;
+    p[1] = (unsigned char)(value >> 8);
+    p[2] = (unsigned char)(value >> 16);
+    p[3] = (unsigned char)(value >> 24);
+}
+
+unsigned int readUint32(const char* p) {
+    const unsigned char* u = (const unsigned char*)p;
+    return u[0] | (u[1] << 8) | (u[2] << 16) | ((unsigned int)u[3] << 24);
+}
+
+int isCompressedData(const char* data, size_t size) {
+    return size >= COMPRESSION_MAGIC_SIZE && memcmp(data, COMPRESSION_MAGIC, COMPRESSION_MAGIC_SIZE) == 0;
+}
+
+// Writes data as a block stored as is, so its text can be found without decoding the file
+int writeStoredBlock(FILE* fp, const char* data, size_t size) {
+    unsigned char header[BLOCK_HEADER_SIZE];
+    writeUint32(header, (unsigned int)size);
+    writeUint32(header + 4, (unsigned int)size);
+    return fwrite(header, 1, sizeof(header), fp) == sizeof(header) && fwrite(data, 1, size, fp) == size;
+}
+
+// Writes one block with its header; blocks that do not shrink are stored as is
+int writeCompressedBlock(FILE* fp, const char* data, size_t size) {
+    size_t capacity = compressBound(size);
+    char* compressed = malloc(capacity);
+    size_t compressedSize = compressed ? compressBlock(data, size, compressed, capacity) : 0;
+    unsigned char header[BLOCK_HEADER_SIZE];
+    writeUint32(header, (unsigned int)size);
+    writeUint32(header + 4, (unsigned int)(compressedSize ? compressedSize : size));
+
+    int ok = fwrite(header, 1, sizeof(header), fp) == sizeof(header);
+    if (compressedSize) {
+        ok = ok && fwrite(compressed, 1, compressedSize, fp) == compressedSize;
+    } else {
+        ok = ok && fwrite(data, 1, size, fp) == size;
+    }
+    free(compressed);
+    return ok;
+}
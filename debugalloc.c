@@ -0,0 +1,179 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <windows.h>
+#define DEBUG_ALLOC_IMPLEMENTATION // Keep the real allocator in this file
+#include "functions.h"
+
+// Tracking allocator for debug builds (-DUTBOARD_DEBUG_ALLOC). functions.h redirects malloc,
+// calloc, realloc, strdup and free here; every block carries a header naming the call site
+// that allocated it, and the live bytes per call site are reported when the process exits.
+#ifdef UTBOARD_DEBUG_ALLOC
+
+#define MAX_ALLOC_SITES 1024
+#define MAX_REPORTED_SITES 20
+
+typedef struct AllocSite {
+    const char* file;
+    int line;
+    size_t liveBytes;
+    size_t liveBlocks;
+    size_t totalBlocks;
+} AllocSite;
+
+// Two pointer-sized words, so the block after it keeps malloc's alignment
+typedef struct AllocHeader {
+    size_t size;
+    AllocSite* site;
+} AllocHeader;
+
+static AllocSite sites[MAX_ALLOC_SITES];
+static AllocSite overflowSite = { "(other sites)", 0, 0, 0, 0 };
+static size_t liveBytes = 0;
+static size_t peakBytes = 0;
+static volatile LONG allocLock = 0; // Spin lock; loader threads allocate concurrently
+static int reportRegistered = 0;
+
+static void lockAllocations() {
+    while (InterlockedCompareExchange(&allocLock, 1, 0) != 0) {
+        Sleep(0);
+    }
+}
+
+static void unlockAllocations() {
+    InterlockedExchangeAdd(&allocLock, -1);
+}
+
+static int compareSitesByLiveBytes(const void* a, const void* b) {
+    const AllocSite* siteA = *(const AllocSite* const*)a;
+    const AllocSite* siteB = *(const AllocSite* const*)b;
+    return siteA->liveBytes < siteB->liveBytes ? 1 : siteA->liveBytes > siteB->liveBytes ? -1 : 0;
+}
+
+static void reportAllocations() {
+    AllocSite* leaking[MAX_ALLOC_SITES + 1];
+    int leakingCount = 0;
+    for (int i = 0; i < MAX_ALLOC_SITES; i++) {
+        if (sites[i].file != NULL && sites[i].liveBlocks > 0) {
+            leaking[leakingCount++] = &sites[i];
+        }
+    }
+    if (overflowSite.liveBlocks > 0) {
+        leaking[leakingCount++] = &overflowSite;
+    }
+    qsort(leaking, leakingCount, sizeof(AllocSite*), compareSitesByLiveBytes);
+
+    fprintf(stderr, "Allocations: peak %lu bytes, still live at exit %lu bytes\n",
+            (unsigned long)peakBytes, (unsigned long)liveBytes);
+    for (int i = 0; i < leakingCount && i < MAX_REPORTED_SITES; i++) {
+        fprintf(stderr, "  %10lu bytes in %6lu blocks  %s:%d (%lu allocated in total)\n",
+                (unsigned long)leaking[i]->liveBytes, (unsigned long)leaking[i]->liveBlocks,
+                leaking[i]->file, leaking[i]->line, (unsigned long)leaking[i]->totalBlocks);
+    }
+}
+
+// Finds or claims the slot for a call site; called with the lock held
+static AllocSite* findSite(const char* file, int line) {
+    size_t hash = ((size_t)file >> 3) * 31 + (size_t)line;
+    for (size_t probe = 0; probe < MAX_ALLOC_SITES; probe++) {
+        AllocSite* site = &sites[(hash + probe) % MAX_ALLOC_SITES];
+        if (site->file == NULL) {
+            site->file = file;
+            site->line = line;
+            return site;
+        }
+        if (site->line == line && (site->file == file || strcmp(site->file, file) == 0)) {
+            return site;
+        }
+    }
+    return &overflowSite;
+}
+
+static void trackBlock(AllocHeader* header, size_t size, const char* file, int line) {
+    lockAllocations();
+    if (!reportRegistered) {
+        reportRegistered = 1;
+        atexit(reportAllocations);
+    }
+    AllocSite* site = findSite(file, line);
+    header->size = size;
+    header->site = site;
+    site->liveBytes += size;
+    site->liveBlocks++;
+    site->totalBlocks++;
+    liveBytes += size;
+    if (liveBytes > peakBytes) {
+        peakBytes = liveBytes;
+    }
+    unlockAllocations();
+}
+
+static void untrackBlock(AllocHeader* header) {
+    lockAllocations();
+    header->site->liveBytes -= header->size;
+    header->site->liveBlocks--;
+    liveBytes -= header->size;
+    unlockAllocations();
+}
+
+void getAllocationTotals(size_t* live, size_t* peak) {
+    lockAllocations();
+    *live = liveBytes;
+    *peak = peakBytes;
+    unlockAllocations();
+}
+
+void* debugMalloc(size_t size, const char* file, int line) {
+    AllocHeader* header = malloc(sizeof(AllocHeader) + size);
+    if (header == NULL) {
+        return NULL;
+    }
+    trackBlock(header, size, file, line);
+    return header + 1;
+}
+
+void* debugCalloc(size_t count, size_t size, const char* file, int line) {
+    if (size != 0 && count > ((size_t)-1 - sizeof(AllocHeader)) / size) {
+        return NULL;
+    }
+    void* block = debugMalloc(count * size, file, line);
+    if (block != NULL) {
+        memset(block, 0, count * size);
+    }
+    return block;
+}
+
+void* debugRealloc(void* block, size_t size, const char* file, int line) {
+    if (block == NULL) {
+        return debugMalloc(size, file, line);
+    }
+    AllocHeader* header = (AllocHeader*)block - 1;
+    untrackBlock(header);
+    AllocHeader* moved = realloc(header, sizeof(AllocHeader) + size);
+    if (moved == NULL) {
+        trackBlock(header, header->size, header->site->file, header->site->line); // Unchanged
+        return NULL;
+    }
+    trackBlock(moved, size, file, line);
+    return moved + 1;
+}
+
+char* debugStrdup(const char* text, const char* file, int line) {
+    size_t size = strlen(text) + 1;
+    char* copy = debugMalloc(size, file, line);
+    if (copy != NULL) {
+        memcpy(copy, text, size);
+    }
+    return copy;
+}
+
+void debugFree(void* block) {
+    if (block == NULL) {
+        return;
+    }
+    AllocHeader* header = (AllocHeader*)block - 1;
+    untrackBlock(header);
+    free(header);
+}
+
+#endif
@@ -2,101 +2,25 @@
 #include <stdlib.h>
 #include <string.h>
 #include <windows.h>
+#include <io.h>
 #include <time.h>
+#include "functions.h"
 
 #define ENTER '\n'
 #define QUOTE '\"'
-
-typedef struct Task {
-    char* name;
-    char* priority;
-    char* date;
-    long id;
-    struct Task* next;
-} Task;
-
-typedef struct List {
-    char* name;
-    long id;
-    struct List* next;
-    Task* tasks;
-} List;
-
-typedef struct Board {
-    char* name;
-    long id;
-    struct Board* next;
-    List* lists;
-} Board;
-
-typedef struct User {
-    char* username;
-    char* password;
-    struct User* next;
-    Board* boards;
-} User;
-
-typedef struct {
-    Task* task;
-    char* boardName;
-    char* listName;
-} TaskInfo;
-
-// Function prototypes
-int isValidDate(char* date);
-void saveAllData(const User* users);
-void saveUsers(const User* user);
-void saveBoards(const User* user);
-void saveLists(const User* users);
-void saveTasks(const User* users);
-char* dynamicFgets(FILE* stream);
-char** parseCSVLine(char* line, int* fieldCount);
-char* dynamicInput();
-void loadAllData(User** users);
-void loadUsers(User** users);
-void loadBoards(User* user);
-void loadLists(Board* board);
-void loadTasks(List* list);
-void freeAllData(User** users);
-void freeUsers(User* user);
-void freeBoards(Board* board);
-void freeLists(List* list);
-void freeTasks(Task* task);
-void boardsMenu(User* user);
-void deleteBoard(User* user);
-void createBoard(User* user);
-void displayBoards(const User* user);
-Board* selectBoard(User* user);
-User* loginWithArgs(User* users, const char* username, const char* password);
-User* signupWithArgs(User** users, const char* username, const char* password);
-char* getNextToken(char** input);
-int userExists(User* users, const char* username);
-void displayLists(const Board* board);
-List* selectList(Board* board);
-void createList(Board* board);
-void deleteList(Board* board);
-void listsMenu(User* user, Board* board);
-void displayTasks(const List* list);
-Task* selectTask(List* list);
-void addTask(List* list);
-void editTask(List* list);
-void deleteTask(List* list);
-void moveTask(Board* board, List* currentList);
-void tasksMenu(User* user, Board* board, List* list);
-void clearScreen();
-int taskDeadlineComparator(const void* a, const void* b);
-char* getCurrentDate();
-void showUpcomingTasks(User* user);
-int compareTasksByPriority(const void* a, const void* b);
-int compareTasksByDate(const void* a, const void* b);
-void sortTasks(List* list, int (*compFunc)(const void*, const void*));
-void sortTasksMenu(List* list);
-void printLogo();
-long generateUniqueId();
-
-// Helper function to parse a CSV line into fields, considering quoted fields with commas
-
+#define LOAD_CHUNK_SIZE (1 << 20) // Data files larger than this are parsed in several chunks
+#define PLAIN_FLUSH_SIZE (1 << 20) // Plain data files are written in pieces of about this size
+#define TASK_PAGE_SIZE 20 // Tasks shown at a time by the merged task view, and by the tasks menu without a console
+#define UPCOMING_TASK_COUNT 3
+#define TASKS_MENU_ROWS 19 // Logo, heading and menu options around the task view
+#define MIN_TASK_VIEW_ROWS 5
+#define SAVE_JOURNAL "save.journal" // Present only while a committed save is being applied
+#define ARCHIVE_MAX_ID "#max" // First field of the record that ends each write of archive.csv
+
+// Splits a CSV line into fields in place. Quoted fields may contain commas, and a doubled
+// quote inside them stands for one quote character.
 char** parseCSVLine(char* line, int* fieldCount) {
+    TRACE_BEGIN(spanStart);
     int capacity = 10; // Initial capacity for the number of fields
     char** fields = (char**)malloc(capacity * sizeof(char*));
     if (fields == NULL) {
@@ -106,51 +30,33 @@ char** parseCSVLine(char* line, int* fieldCount) {
     }
 
     *fieldCount = 0;
-    char* field = line;
-    int inQuotes = 0;
-    int fieldStart = 1; // Flag to indicate the start of a new field
-
-    for (char* p = line; *p; p++) {
-        // Check for quote character
+    char* p = line;
+    while (1) {
+        char* field = p;
+        char* out = p; // Unescaping only ever shortens a field, so it is rewritten in place
         if (*p == QUOTE) {
-            inQuotes = !inQuotes;
-            if (fieldStart) {
-                field = p + 1; // Start after the quote
-            } else if (!inQuotes) {
-                *p = '\0'; // End before the quote
-            }
-            continue; // Skip the quote character
-        }
-
-        // Check for comma separator if not within quotes
-        if (*p == ',' && !inQuotes) {
-            *p = '\0'; // Null-terminate the current field
-            if (*fieldCount >= capacity) {
-                // Resize the fields array if necessary
-                capacity *= 2;
-                char** tempFields = (char**)realloc(fields, capacity * sizeof(char*));
-                if (tempFields == NULL) {
-                    perror("Memory reallocation failed for fields");
-                    free(fields);
-                    *fieldCount = 0;
-                    return NULL;
+            field = out = ++p;
+            while (*p) {
+                if (*p == QUOTE) {
+                    if (p[1] != QUOTE) {
+                        p++; // Closing quote
+                        break;
+                    }
+                    p++; // Doubled quote, keep one
                 }
-                fields = tempFields;
+                *out++ = *p++;
             }
-            fields[(*fieldCount)++] = field;
-            fieldStart = 1;
-            field = p + 1; // Start of the next field
-        } else if (fieldStart) {
-            field = p; // Start of a new field
-            fieldStart = 0;
         }
-    }
+        // Unquoted text, and anything that follows a closing quote, runs up to the next comma
+        while (*p && *p != ',') {
+            *out++ = *p++;
+        }
+        int moreFields = *p == ',';
+        *out = '\0';
 
-    // Capture the last field if the line doesn't end with a comma
-    if (!fieldStart) {
         if (*fieldCount >= capacity) {
-            // Resize the fields array if necessary, adding space for one more field
-            capacity += 1;
+            // Resize the fields array if necessary
+            capacity *= 2;
             char** tempFields = (char**)realloc(fields, capacity * sizeof(char*));
             if (tempFields == NULL) {
                 perror("Memory reallocation failed for fields");
@@ -161,59 +67,117 @@ char** parseCSVLine(char* line, int* fieldCount) {
             fields = tempFields;
         }
         fields[(*fieldCount)++] = field;
+        if (!moreFields) {
+            break;
+        }
+        p++; // Start of the next field
     }
 
+    TRACE_END(spanStart, "parseCSVLine");
     return fields;
 }
 
+static long lastUniqueId = 0;
+
 long generateUniqueId() {
-    static long uniqueId = 0;
-    return ++uniqueId;
+    return ++lastUniqueId;
+}
+
+// Makes sure new IDs never collide with IDs that were loaded from disk
+void seedUniqueId(long maxId) {
+    if (maxId > lastUniqueId) {
+        lastUniqueId = maxId;
+    }
 }
 
+// Starts a new screen with just the logo, for prompts that take over the screen (render.c)
 void clearScreen() {
-    Sleep(1000);
-    system("cls");
+    beginFrame();
     printLogo();
+    presentFrame();
 }
 
-char* dynamicInput() {
-    char* input = NULL;
+static InputBuffer inputBuffer; // Shared by every prompt so reading a line does not allocate
+static FILE* inputRecording = NULL;
+
+// Reads one line into the buffer, reusing its memory; returns NULL at the end of input
+char* readLine(InputBuffer* buffer) {
     int ch;
-    size_t size = 0;
-    size_t length = 0;
+    buffer->length = 0;
+    shipChanges(); // A standby gets what the last action changed before the next one is read
+    markInputRow(); // What is printed after this line is kept on screen by the next frame
 
     // Read characters until ENTER or EOF is encountered
     while ((ch = getchar()) != ENTER && ch != EOF) {
-        // Check if we need to expand the buffer
-        if (length + 1 >= size) { // +1 for the null terminator
-            size_t newSize = size == 0 ? 2 : size * 2; // Double the buffer size
-            char* tempInput = realloc(input, newSize);
-            if (!tempInput) {
-                free(input); // Free the previously allocated memory
-                return NULL; // realloc failed, return NULL
+        // Grow only when the line is longer than any line read before
+        if (buffer->length + 1 >= buffer->capacity) {
+            size_t newCapacity = buffer->capacity == 0 ? 256 : buffer->capacity * 2;
+            char* newData = realloc(buffer->data, newCapacity);
+            if (!newData) {
+                return NULL;
             }
-            input = tempInput;
-            size = newSize;
+            buffer->data = newData;
+            buffer->capacity = newCapacity;
         }
-        input[length++] = (char)ch;
+        buffer->data[buffer->length++] = (char)ch;
     }
-
-    // Null-terminate the input string
-    if (input != NULL) {
-        // Ensure there is space for the null terminator
-        if (length >= size) {
-            char* tempInput = realloc(input, length + 1); // +1 for the null terminator
-            if (!tempInput) {
-                free(input);
-                return NULL;
-            }
-            input = tempInput;
+    if (ch == EOF && buffer->length == 0) {
+        return NULL;
+    }
+    if (buffer->data == NULL) {
+        buffer->data = malloc(256);
+        if (!buffer->data) {
+            return NULL;
         }
-        input[length] = '\0';
+        buffer->capacity = 256;
+    }
+    buffer->data[buffer->length] = '\0';
+    if (inputRecording != NULL) {
+        fprintf(inputRecording, "%s\n", buffer->data);
+        fflush(inputRecording); // Keep the recording usable if the session crashes
+    }
+    return buffer->data;
+}
+
+// Copies every line read from the user to fp, so the session can be replayed later; NULL stops
+void setInputRecording(FILE* fp) {
+    inputRecording = fp;
+}
+
+// Returns the next input line; it stays valid until the next prompt reads input
+char* readInputLine() {
+    return readLine(&inputBuffer);
+}
+
+void freeInputBuffer() {
+    free(inputBuffer.data);
+    inputBuffer.data = NULL;
+    inputBuffer.capacity = 0;
+    inputBuffer.length = 0;
+}
+
+// Reads a numeric choice without allocating; returns -1 at the end of input
+int readChoice() {
+    char* line = readLine(&inputBuffer);
+    return line != NULL ? atoi(line) : -1;
+}
+
+// Reads a board, list or task key (number, name or #ID); returns NULL for 0, an empty line or end of input
+static const char* readSelectionKey() {
+    char* line = readLine(&inputBuffer);
+    if (line == NULL || *line == '\0' || strcmp(line, "0") == 0) {
+        return NULL;
     }
+    return line;
+}
 
-    return input;
+// Returns a copy of the next input line that the caller owns, or NULL if nothing was entered
+char* dynamicInput() {
+    char* line = readLine(&inputBuffer);
+    if (line == NULL || line[0] == '\0') {
+        return NULL;
+    }
+    return strdup(line);
 }
 
 char* dynamicFgets(FILE* stream) {
@@ -243,81 +207,523 @@ char* dynamicFgets(FILE* stream) {
     return line;
 }
 
-void saveAllData(const User* users) {
-    saveUsers(users);
-    saveBoards(users); 
-    saveLists(users);  
-    saveTasks(users);
+static int compressedStorage = 0;
+static int borrowStrings = 0;
+
+// Chooses whether saveAllData writes compressed blocks; loading accepts both formats either way
+void setCompressedStorage(int enabled) {
+    compressedStorage = enabled;
+}
+
+// Chooses whether loaded strings point into the retained file contents instead of being copied
+void setBorrowedStrings(int enabled) {
+    borrowStrings = enabled;
 }
 
-void saveUsers(const User* users) {
-    FILE* fpUsers = fopen("users.csv", "w");
-    if (fpUsers == NULL) {
-        perror("Unable to open users file for writing");
+// Output goes to "<fileName>.tmp" until the save's journal moves it into place. Records that
+// are appended to an existing file leave out its start, the magic of a compressed file.
+static int openWriter(DataWriter* writer, const char* fileName, int compressed, int appending) {
+    char tempName[FILENAME_MAX];
+    snprintf(tempName, sizeof(tempName), "%s.tmp", fileName);
+    writer->fp = fopen(tempName, "wb");
+    if (writer->fp == NULL) {
+        return 0;
+    }
+    setvbuf(writer->fp, NULL, _IONBF, 0); // Whole buffers are handed to fwrite, skip stdio's copy
+    writer->compressed = compressed;
+    writer->capacity = (writer->compressed ? COMPRESSION_BLOCK_SIZE : PLAIN_FLUSH_SIZE) + 4096;
+    writer->buffer = malloc(writer->capacity);
+    if (writer->buffer == NULL) {
+        fclose(writer->fp);
+        return 0;
+    }
+    writer->length = 0;
+    writer->recordFields = 0;
+    writer->failed = 0;
+    if (writer->compressed && !appending) {
+        fwrite(COMPRESSION_MAGIC, 1, COMPRESSION_MAGIC_SIZE, writer->fp);
+    }
+    return 1;
+}
+
+int openDataWriter(DataWriter* writer, const char* fileName) {
+    return openWriter(writer, fileName, compressedStorage, 0);
+}
+
+// Collects records in memory, for the change batches sent to a standby (replica.c); the
+// records stay in writer->buffer until it is closed
+int openMemoryWriter(DataWriter* writer) {
+    writer->fp = NULL;
+    writer->compressed = 0;
+    writer->capacity = 4096;
+    writer->buffer = malloc(writer->capacity);
+    writer->length = 0;
+    writer->recordFields = 0;
+    writer->failed = 0;
+    return writer->buffer != NULL;
+}
+
+// Writes out the buffered records; only called on record boundaries so every block decodes on its own
+static void flushDataWriter(DataWriter* writer) {
+    if (writer->length == 0 || writer->fp == NULL) {
+        return;
+    }
+    int ok;
+    if (writer->compressed) {
+        ok = writeCompressedBlock(writer->fp, writer->buffer, writer->length);
+    } else {
+        ok = fwrite(writer->buffer, 1, writer->length, writer->fp) == writer->length;
+    }
+    if (!ok) {
+        writer->failed = 1;
+    }
+    writer->length = 0;
+}
+
+// Makes room for at least extra more bytes in the buffer
+static int reserveWriter(DataWriter* writer, size_t extra) {
+    if (writer->capacity - writer->length >= extra) {
+        return 1;
+    }
+    size_t newCapacity = writer->capacity * 2 + extra;
+    char* newBuffer = realloc(writer->buffer, newCapacity);
+    if (newBuffer == NULL) {
+        perror("Memory allocation failed for writer buffer");
+        writer->failed = 1;
+        return 0;
+    }
+    writer->buffer = newBuffer;
+    writer->capacity = newCapacity;
+    return 1;
+}
+
+// Appends a quoted field, doubling any quote inside it
+void writeField(DataWriter* writer, const char* text) {
+    size_t length = strlen(text);
+    if (!reserveWriter(writer, length * 2 + 3)) {
+        return;
+    }
+    char* out = writer->buffer + writer->length;
+    if (writer->recordFields++ > 0) {
+        *out++ = ',';
+    }
+    *out++ = QUOTE;
+    const char* quote = memchr(text, QUOTE, length);
+    if (quote == NULL) {
+        memcpy(out, text, length); // The common case: nothing to escape
+        out += length;
+    } else {
+        for (const char* p = text; *p; p++) {
+            if (*p == QUOTE) {
+                *out++ = QUOTE;
+            }
+            *out++ = *p;
+        }
+    }
+    *out++ = QUOTE;
+    writer->length = out - writer->buffer;
+}
+
+// Appends a quoted ID without going through printf
+void writeIdField(DataWriter* writer, long value) {
+    char digits[24];
+    int count = 0;
+    unsigned long magnitude = value < 0 ? 0UL - (unsigned long)value : (unsigned long)value;
+    do {
+        digits[count++] = (char)('0' + magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude != 0);
+    if (value < 0) {
+        digits[count++] = '-';
+    }
+    if (!reserveWriter(writer, count + 3)) {
+        return;
+    }
+    char* out = writer->buffer + writer->length;
+    if (writer->recordFields++ > 0) {
+        *out++ = ',';
+    }
+    *out++ = QUOTE;
+    while (count > 0) {
+        *out++ = digits[--count];
+    }
+    *out++ = QUOTE;
+    writer->length = out - writer->buffer;
+}
+
+// Finishes the current record; full buffers are written out here, on a record boundary
+void endRecord(DataWriter* writer) {
+    if (!reserveWriter(writer, 1)) {
+        return;
+    }
+    writer->buffer[writer->length++] = '\n';
+    writer->recordFields = 0;
+    if (writer->length >= (writer->compressed ? COMPRESSION_BLOCK_SIZE : PLAIN_FLUSH_SIZE)) {
+        flushDataWriter(writer);
+    }
+}
+
+int closeDataWriter(DataWriter* writer) {
+    flushDataWriter(writer);
+    int ok = !writer->failed;
+    if (writer->fp != NULL) {
+        ok = !ferror(writer->fp) && ok;
+        ok = _commit(_fileno(writer->fp)) == 0 && ok; // On disk before it is renamed into place
+        ok = fclose(writer->fp) == 0 && ok;
+    }
+    free(writer->buffer);
+    writer->buffer = NULL;
+    return ok;
+}
+
+static const char* dataFileNames[] = { "users.csv", "boards.csv", "lists.csv", "tasks.csv", "tombstones.csv", "archive.csv" };
+static StringPool stringPool; // Long strings stored outside the loader
+static User** dataRoot = NULL; // Head of the user list that loadAllData filled in
+
+// Archived tasks are kept out of the working set and out of the four data files. archive.csv
+// is read only when the archive is searched, restored from or has to be rewritten; saves
+// append the newly archived tasks to it.
+static ArchivedTask* archivedTasks = NULL; // Not yet saved, plus archive.csv once loaded
+static int archiveLoaded = 0;
+static int archiveRewrite = 0; // A task in archive.csv was restored, so the file is rewritten
+static int archiveWritten = 0; // archive.csv.tmp belongs to the save in progress
+static long archiveAppendFrom = -1; // Size of archive.csv the temp file goes after, -1 to replace it
+static long archiveMaxId = 0; // Largest task ID ever archived
+static int saveArchive();
+static void archiveSaved();
+static void freeArchive();
+static void seedArchivedIds();
+
+// Whether fileName names one of the data files, their temp files or the save journal, which
+// reads and exports must not write over; any directory counts, as the session may be run there
+int isDataFileName(const char* fileName) {
+    const char* base = fileName;
+    for (const char* c = fileName; *c != '\0'; c++) {
+        if (*c == '/' || *c == '\\' || *c == ':') {
+            base = c + 1;
+        }
+    }
+    char name[FILENAME_MAX];
+    snprintf(name, sizeof(name), "%s", base);
+    size_t length = strlen(name);
+    if (length > 4 && _stricmp(name + length - 4, ".tmp") == 0) {
+        name[length - 4] = '\0';
+    }
+    if (_stricmp(name, SAVE_JOURNAL) == 0) {
+        return 1;
+    }
+    for (size_t i = 0; i < sizeof(dataFileNames) / sizeof(dataFileNames[0]); i++) {
+        if (_stricmp(name, dataFileNames[i]) == 0) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// Removes the temp files of a save that did not reach its commit point
+static void discardTempFiles() {
+    for (size_t i = 0; i < sizeof(dataFileNames) / sizeof(dataFileNames[0]); i++) {
+        char tempName[FILENAME_MAX];
+        snprintf(tempName, sizeof(tempName), "%s.tmp", dataFileNames[i]);
+        remove(tempName);
+    }
+}
+
+// Appends NAME.tmp to NAME, first cutting NAME back to size, the length it had when the save
+// wrote the temp file, so that the step can be redone
+static int appendTempFile(const char* name, long size) {
+    char tempName[FILENAME_MAX];
+    snprintf(tempName, sizeof(tempName), "%s.tmp", name);
+    FILE* temp = fopen(tempName, "rb");
+    if (temp == NULL) {
+        return 1; // Already appended
+    }
+    FILE* fp = fopen(name, "r+b");
+    int ok = fp != NULL && fseek(fp, 0, SEEK_END) == 0 && ftell(fp) >= size &&
+             _chsize_s(_fileno(fp), size) == 0 && fseek(fp, 0, SEEK_END) == 0;
+    char buffer[16384];
+    size_t length;
+    while (ok && (length = fread(buffer, 1, sizeof(buffer), temp)) > 0) {
+        ok = fwrite(buffer, 1, length, fp) == length;
+    }
+    ok = ok && !ferror(temp) && fflush(fp) == 0 && _commit(_fileno(fp)) == 0;
+    if (fp != NULL) {
+        ok = fclose(fp) == 0 && ok;
+    }
+    fclose(temp);
+    if (!ok) {
+        fprintf(stderr, "Unable to append to %s.\n", name);
+        return 0;
+    }
+    remove(tempName);
+    return 1;
+}
+
+// Carries out a committed save: every "replace NAME" line of the journal moves NAME.tmp over
+// NAME and every "append NAME SIZE" line adds it to the end of NAME. A step whose temp file is
+// gone was done before, so an interrupted save can be applied again. The journal is removed
+// once every step succeeded; returns 0 if one failed.
+static int applySaveJournal() {
+    FILE* fp = fopen(SAVE_JOURNAL, "rb");
+    if (fp == NULL) {
+        return 1; // No committed save is pending
+    }
+    int ok = 1;
+    char line[128];
+    while (fgets(line, sizeof(line), fp) != NULL) {
+        char name[64];
+        long size;
+        if (sscanf(line, "append %63s %ld", name, &size) == 2) {
+            ok = appendTempFile(name, size) && ok;
+            continue;
+        }
+        if (sscanf(line, "replace %63s", name) != 1) {
+            continue;
+        }
+        char tempName[FILENAME_MAX];
+        snprintf(tempName, sizeof(tempName), "%s.tmp", name);
+        FILE* temp = fopen(tempName, "rb");
+        if (temp == NULL) {
+            continue; // Already in place
+        }
+        fclose(temp);
+        if (!MoveFileEx(tempName, name, MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH)) {
+            fprintf(stderr, "Unable to replace %s.\n", name);
+            ok = 0;
+        }
+    }
+    fclose(fp);
+    if (ok) {
+        remove(SAVE_JOURNAL);
+    }
+    return ok;
+}
+
+// The commit point of a save. The journal naming every written temp file is flushed to disk
+// and renamed into place in one step, after all the temp files are complete: a save that
+// stops before the rename leaves the previous files, one that stops after it is finished by
+// the next load.
+static int commitSave() {
+    FILE* fp = fopen(SAVE_JOURNAL ".tmp", "wb");
+    if (fp == NULL) {
+        perror("Unable to open the save journal for writing");
+        return 0;
+    }
+    for (int i = 0; i < 5; i++) {
+        fprintf(fp, "replace %s\n", dataFileNames[i]);
+    }
+    if (archiveWritten && archiveAppendFrom >= 0) {
+        fprintf(fp, "append archive.csv %ld\n", archiveAppendFrom);
+    } else if (archiveWritten) {
+        fprintf(fp, "replace archive.csv\n");
+    }
+    int ok = fflush(fp) == 0 && _commit(_fileno(fp)) == 0;
+    ok = fclose(fp) == 0 && ok;
+    if (!ok || !MoveFileEx(SAVE_JOURNAL ".tmp", SAVE_JOURNAL, MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH)) {
+        remove(SAVE_JOURNAL ".tmp");
+        discardTempFiles();
+        fprintf(stderr, "Unable to commit the save, the previous data files were kept.\n");
+        return 0;
+    }
+    if (!applySaveJournal()) {
+        fprintf(stderr, "The save was committed but not fully applied; the next start finishes it.\n");
+        return 0;
+    }
+    return 1;
+}
+
+// Finishes a save that was committed but interrupted, and drops the temp files of one that
+// never reached its commit point
+static void recoverDataFiles() {
+    if (!applySaveJournal()) {
+        fprintf(stderr, "Unable to finish the interrupted save, some data files may be out of date.\n");
         return;
     }
+    discardTempFiles();
+}
+
+// Writes all the data files as one unit: either every file is replaced or none is
+int saveAllData(const User* users) {
+    long long startTicks = statsClock();
+    int ok = saveUsers(users);
+    ok = saveBoards(users) && ok;
+    ok = saveLists(users) && ok;
+    ok = saveTasks(users) && ok;
+    pruneTombstones();
+    ok = saveTombstones() && ok;
+    ok = saveArchive() && ok;
+    if (!ok) {
+        discardTempFiles();
+        fprintf(stderr, "Saving failed, the previous data files were kept.\n");
+    } else if ((ok = commitSave())) {
+        archiveSaved();
+    }
+    archiveWritten = 0;
+    recordTiming(TIMER_SAVE, startTicks);
+    TRACE_END(startTicks, "saveAllData");
+    return ok;
+}
+
+// Saves everything that was loaded at startup, including users who signed up since
+int saveLoadedData() {
+    if (dataRoot == NULL) {
+        return 0;
+    }
+    return saveAllData(*dataRoot);
+}
+
+// Exports the changes made to everything that was loaded after sequence since, from a snapshot
+// in the background (snapshot.c); returns 0 if the export could not be started
+int exportLoadedChanges(long since, const char* fileName) {
+    if (dataRoot == NULL || !changesAvailableSince(since)) {
+        return 0;
+    }
+    return startBackgroundExport(*dataRoot, since, fileName);
+}
+
+// Prints a report over everything that was loaded, on a worker per core (reports.c), or writes
+// it to fileName from a snapshot in the background. Returns 0 if the report could not be made
+// or started.
+int reportLoadedData(ReportType type, const char* fileName) {
+    if (dataRoot == NULL) {
+        return 0;
+    }
+    if (fileName != NULL) {
+        return startBackgroundReport(*dataRoot, type, fileName);
+    }
+    return printReport(*dataRoot, type, getCoreCount(), stdout);
+}
+
+// The fields of one record as its data file stores them; the change feed writes the same fields
+void writeUserFields(DataWriter* writer, const User* user) {
+    writeField(writer, user->username);
+    writeField(writer, user->password);
+    writeIdField(writer, user->modified);
+}
+
+void writeBoardFields(DataWriter* writer, const Board* board) {
+    writeIdField(writer, board->id);
+    writeField(writer, board->name);
+    writeField(writer, board->user->username);
+    writeIdField(writer, board->modified);
+}
+
+void writeListFields(DataWriter* writer, const List* list) {
+    writeIdField(writer, list->id);
+    writeField(writer, list->name);
+    writeIdField(writer, list->board->id);
+    writeIdField(writer, list->modified);
+}
+
+void writeTaskFields(DataWriter* writer, const Task* task) {
+    writeIdField(writer, task->id);
+    writeField(writer, task->name);
+    writeField(writer, task->priority);
+    writeField(writer, task->date);
+    writeIdField(writer, task->list->id);
+    writeField(writer, task->position);
+    writeIdField(writer, task->modified);
+}
+
+int saveUsers(const User* users) {
+    TRACE_BEGIN(spanStart);
+    DataWriter writer;
+    if (!openDataWriter(&writer, "users.csv")) {
+        perror("Unable to open users file for writing");
+        return 0;
+    }
     // Write header
-    fprintf(fpUsers, "\"Username\",\"Password\"\n");
+    writeField(&writer, "Username");
+    writeField(&writer, "Password");
+    writeField(&writer, "Modified");
+    endRecord(&writer);
     // Iterate over all users and write their data to the file
     while (users != NULL) {
-        fprintf(fpUsers, "\"%s\",\"%s\"\n", users->username, users->password);
+        writeUserFields(&writer, users);
+        endRecord(&writer);
         users = users->next;
     }
-    fclose(fpUsers);
+    int ok = closeDataWriter(&writer);
+    TRACE_END(spanStart, "saveUsers");
+    return ok;
 }
 
-void saveBoards(const User* users) {
-    FILE* fpBoards = fopen("boards.csv", "w");
-    if (fpBoards == NULL) {
+int saveBoards(const User* users) {
+    TRACE_BEGIN(spanStart);
+    DataWriter writer;
+    if (!openDataWriter(&writer, "boards.csv")) {
         perror("Unable to open boards file for writing");
-        return;
+        return 0;
     }
     // Write header
-    fprintf(fpBoards, "\"Board ID\",\"Board Name\",\"Username\"\n");
+    writeField(&writer, "Board ID");
+    writeField(&writer, "Board Name");
+    writeField(&writer, "Username");
+    writeField(&writer, "Modified");
+    endRecord(&writer);
     // Iterate over all users and their boards and write them to the file
     while (users != NULL) {
         const Board* board = users->boards;
         while (board != NULL) {
-            fprintf(fpBoards, "\"%ld\",\"%s\",\"%s\"\n", board->id, board->name, users->username);
+            writeBoardFields(&writer, board);
+            endRecord(&writer);
             board = board->next;
         }
         users = users->next;
     }
-    fclose(fpBoards);
+    int ok = closeDataWriter(&writer);
+    TRACE_END(spanStart, "saveBoards");
+    return ok;
 }
 
-void saveLists(const User* users) {
-    FILE* fpLists = fopen("lists.csv", "w");
-    if (fpLists == NULL) {
+int saveLists(const User* users) {
+    TRACE_BEGIN(spanStart);
+    DataWriter writer;
+    if (!openDataWriter(&writer, "lists.csv")) {
         perror("Unable to open lists file for writing");
-        return;
+        return 0;
     }
     // Write header
-    fprintf(fpLists, "\"List ID\",\"List Name\",\"Board ID\"\n");
+    writeField(&writer, "List ID");
+    writeField(&writer, "List Name");
+    writeField(&writer, "Board ID");
+    writeField(&writer, "Modified");
+    endRecord(&writer);
     // Iterate over all users, their boards, and lists, and write them to the file
     while (users != NULL) {
         const Board* board = users->boards;
         while (board != NULL) {
             const List* list = board->lists;
             while (list != NULL) {
-                fprintf(fpLists, "\"%ld\",\"%s\",\"%ld\"\n", list->id, list->name, board->id);
+                writeListFields(&writer, list);
+                endRecord(&writer);
                 list = list->next;
             }
             board = board->next;
         }
         users = users->next;
     }
-    fclose(fpLists);
+    int ok = closeDataWriter(&writer);
+    TRACE_END(spanStart, "saveLists");
+    return ok;
 }
 
-void saveTasks(const User* users) {
-    FILE* fpTasks = fopen("tasks.csv", "w");
-    if (fpTasks == NULL) {
+int saveTasks(const User* users) {
+    TRACE_BEGIN(spanStart);
+    DataWriter writer;
+    if (!openDataWriter(&writer, "tasks.csv")) {
         perror("Unable to open tasks file for writing");
-        return;
+        return 0;
     }
     // Write header
-    fprintf(fpTasks, "\"Task ID\",\"Task Name\",\"Priority\",\"Date\",\"List ID\"\n");
+    writeField(&writer, "Task ID");
+    writeField(&writer, "Task Name");
+    writeField(&writer, "Priority");
+    writeField(&writer, "Date");
+    writeField(&writer, "List ID");
+    writeField(&writer, "Position");
+    writeField(&writer, "Modified");
+    endRecord(&writer);
     // Iterate over all users, their boards, lists, and tasks, and write them to the file
     while (users != NULL) {
         const Board* board = users->boards;
@@ -326,8 +732,8 @@ void saveTasks(const User* users) {
             while (list != NULL) {
                 const Task* task = list->tasks;
                 while (task != NULL) {
-                    fprintf(fpTasks, "\"%ld\",\"%s\",\"%s\",\"%s\",\"%ld\"\n",
-                            task->id, task->name, task->priority, task->date, list->id);
+                    writeTaskFields(&writer, task);
+                    endRecord(&writer);
                     task = task->next;
                 }
                 list = list->next;
@@ -336,204 +742,801 @@ void saveTasks(const User* users) {
         }
         users = users->next;
     }
-    fclose(fpTasks);
+    int ok = closeDataWriter(&writer);
+    TRACE_END(spanStart, "saveTasks");
+    return ok;
 }
 
-void loadUsers(User** users) {
-    FILE* fpUsers = fopen("users.csv", "r");
-    if (fpUsers == NULL) {
-        perror("Unable to open users file for reading");
-        return;
+// Deletions for the change feed, oldest first; see changes.c
+int saveTombstones() {
+    DataWriter writer;
+    if (!openDataWriter(&writer, "tombstones.csv")) {
+        perror("Unable to open tombstones file for writing");
+        return 0;
+    }
+    writeField(&writer, "Sequence");
+    writeField(&writer, "File");
+    writeField(&writer, "ID");
+    endRecord(&writer);
+    if (prunedTombstoneFloor() > 0) {
+        writeIdField(&writer, prunedTombstoneFloor()); // Older tombstones were pruned
+        writeField(&writer, "pruned");
+        writeIdField(&writer, 0);
+        endRecord(&writer);
+    }
+    size_t count;
+    const Tombstone* tombstones = getTombstones(&count);
+    for (size_t i = 0; i < count; i++) {
+        writeIdField(&writer, tombstones[i].sequence);
+        writeField(&writer, recordFileName(tombstones[i].type));
+        writeIdField(&writer, tombstones[i].id);
+        endRecord(&writer);
+    }
+    return closeDataWriter(&writer);
+}
+
+typedef struct BoardRecord {
+    Board* board;
+    const char* username; // Points into the file buffer until linking is done
+} BoardRecord;
+
+typedef struct ListRecord {
+    List* list;
+    long boardId;
+} ListRecord;
+
+typedef struct TaskRecord {
+    Task* task;
+    long listId;
+} TaskRecord;
+
+typedef struct ArchiveRecord {
+    Task* task;
+    long listId;
+    const char* username; // Points into the file buffer until linking is done
+} ArchiveRecord;
+
+// One compressed block that is decoded and parsed as its own chunk
+typedef struct BlockJob {
+    LoadChunk* chunk;
+    const char* source;   // Stored bytes inside the compressed file buffer
+    size_t sourceSize;
+    char* target;         // Where the block decodes to inside the raw buffer
+    size_t rawSize;
+    int isFirst;          // The first block starts with the header line
+    const char* fileName;
+} BlockJob;
+
+typedef struct DataFile {
+    const char* fileName;
+    const char* label;
+    void (*parse)(LoadChunk* chunk);
+    int optional;         // A missing file is not an error
+    char* data;           // Whole file contents (decompressed), null-terminated
+    size_t size;
+    char* compressedData; // Raw file bytes when the file is block compressed
+    BlockJob* blocks;
+    LoadChunk* chunks;
+    int chunkCount;
+    ThreadPool* pool;
+    BorrowedRegion* region; // Reserved before parsing when strings are borrowed
+    int failed;             // Could not be read into memory
+} DataFile;
+
+// Returns the next record of the chunk, null-terminated in place, or NULL at the end of the chunk
+static char* nextRecord(LoadChunk* chunk) {
+    if (chunk->begin >= chunk->end) {
+        return NULL;
+    }
+    char* line = chunk->begin;
+    char* newline = memchr(line, '\n', chunk->end - line);
+    char* lineEnd = newline ? newline : chunk->end;
+    chunk->begin = newline ? newline + 1 : chunk->end;
+    if (lineEnd > line && lineEnd[-1] == '\r') {
+        lineEnd--;
     }
+    *lineEnd = '\0';
+    return line;
+}
 
-    // Skip the header line
-    char* line = dynamicFgets(fpUsers);
-    free(line); // Free the header line
+static int appendRecord(LoadChunk* chunk, const void* record, size_t recordSize) {
+    if (chunk->recordCount >= chunk->recordCapacity) {
+        size_t newCapacity = chunk->recordCapacity == 0 ? 64 : chunk->recordCapacity * 2;
+        void* newRecords = realloc(chunk->records, newCapacity * recordSize);
+        if (newRecords == NULL) {
+            perror("Memory allocation failed for records");
+            return 0;
+        }
+        chunk->records = newRecords;
+        chunk->recordCapacity = newCapacity;
+    }
+    memcpy((char*)chunk->records + chunk->recordCount * recordSize, record, recordSize);
+    chunk->recordCount++;
+    return 1;
+}
+
+// Points a field at its text in the load buffer when borrowing, otherwise stores a copy
+static void loadString(LoadChunk* chunk, char** field, char* storage, size_t storageSize, char* text) {
+    if (chunk->borrow) {
+        *field = text;
+        chunk->borrowedStrings++;
+    } else {
+        *field = NULL;
+        storeString(&chunk->strings, field, storage, storageSize, text);
+    }
+}
+
+// Lets go of a string loadString set, for a record the chunk could not keep. Borrowed strings
+// only become references on the load buffer once the whole file is parsed.
+static void unloadString(LoadChunk* chunk, char* text, const char* storage) {
+    if (chunk->borrow && text != storage) {
+        chunk->borrowedStrings--;
+    } else {
+        releaseString(text, storage);
+    }
+}
 
-    while ((line = dynamicFgets(fpUsers)) != NULL) {
+static void unloadTask(LoadChunk* chunk, Task* task) {
+    unloadString(chunk, task->name, task->nameStorage);
+    unloadString(chunk, task->priority, task->priorityStorage);
+    unloadString(chunk, task->date, task->dateStorage);
+    unloadString(chunk, task->position, task->positionStorage);
+    free(task);
+}
+
+static void noteId(LoadChunk* chunk, long id) {
+    if (id > chunk->maxId) {
+        chunk->maxId = id;
+    }
+}
+
+void loadUsers(LoadChunk* chunk) {
+    char* line;
+    TRACE_BEGIN(spanStart);
+    while ((line = nextRecord(chunk)) != NULL) {
+        if (*line == '\0') {
+            continue; // Skip blank lines
+        }
         int fieldCount = 0;
         char** fields = parseCSVLine(line, &fieldCount);
+        if (fields == NULL) {
+            chunk->failed = 1;
+            break;
+        }
 
         if (fieldCount >= 2) {
             User* newUser = (User*)malloc(sizeof(User));
             if (newUser == NULL) {
                 perror("Memory allocation failed for newUser");
+                chunk->failed = 1;
+                free(fields);
                 break; // Exit the loop if memory allocation fails
             }
-            newUser->username = strdup(fields[0]);
-            newUser->password = strdup(fields[1]);
-            newUser->boards = NULL; // Initialize boards to NULL
-            newUser->next = *users; // Link the new user to the head of the list
-            *users = newUser;       // Update the head of the list to the new user
+            loadString(chunk, &newUser->username, NULL, 0, fields[0]);
+            loadString(chunk, &newUser->password, NULL, 0, fields[1]);
+            newUser->modified = fieldCount >= 3 ? strtol(fields[2], NULL, 10) : 0;
+            newUser->newestChange = 0;
+            newUser->boards = NULL; // Boards are attached when linking
+            newUser->next = NULL;
+            memset(&newUser->counts, 0, sizeof(TaskCounts));
+            initIndex(&newUser->boardsByName);
+            initIndex(&newUser->listsByName);
+            newUser->snapshotCopy = NULL;
+            if (!appendRecord(chunk, &newUser, sizeof(User*))) {
+                unloadString(chunk, newUser->username, NULL);
+                unloadString(chunk, newUser->password, NULL);
+                free(newUser);
+                chunk->failed = 1;
+                free(fields);
+                break;
+            }
         } else {
             // Handle the case where the expected number of fields is not met
-            fprintf(stderr, "Invalid record format in users.csv: %s", line);
+            fprintf(stderr, "Invalid record format in users.csv: %s\n", line);
         }
-
-        // Free the dynamically allocated fields
-        
-        free(line);
+        free(fields);
     }
-    fclose(fpUsers);
+    TRACE_END(spanStart, "loadUsers");
 }
 
-void loadBoards(User* user) {
-    FILE* fpBoards = fopen("boards.csv", "r");
-    if (fpBoards == NULL) {
-        perror("Unable to open boards file for reading");
-        return;
-    }
-
-    // Skip the header line
-    char* line = dynamicFgets(fpBoards);
-    free(line); // Free the header line
-
-    while ((line = dynamicFgets(fpBoards)) != NULL) {
+void loadBoards(LoadChunk* chunk) {
+    char* line;
+    TRACE_BEGIN(spanStart);
+    while ((line = nextRecord(chunk)) != NULL) {
+        if (*line == '\0') {
+            continue;
+        }
         int fieldCount = 0;
         char** fields = parseCSVLine(line, &fieldCount);
+        if (fields == NULL) {
+            chunk->failed = 1;
+            break;
+        }
 
         if (fieldCount >= 3) {
-            // Check if the username matches
-            if (strcmp(user->username, fields[2]) == 0) {
-                Board* newBoard = (Board*)malloc(sizeof(Board));
-                if (newBoard == NULL) {
-                    perror("Memory allocation failed for newBoard");
-                    break;
-                }
-                newBoard->id = strtol(fields[0], NULL, 10);
-                newBoard->name = strdup(fields[1]);
-                newBoard->lists = NULL;
-                newBoard->next = user->boards;
-                user->boards = newBoard;
+            Board* newBoard = (Board*)malloc(sizeof(Board));
+            if (newBoard == NULL) {
+                perror("Memory allocation failed for newBoard");
+                chunk->failed = 1;
+                free(fields);
+                break;
+            }
+            newBoard->id = strtol(fields[0], NULL, 10);
+            loadString(chunk, &newBoard->name, newBoard->nameStorage, BOARD_NAME_INLINE, fields[1]);
+            newBoard->modified = fieldCount >= 4 ? strtol(fields[3], NULL, 10) : 0;
+            newBoard->newestChange = 0;
+            newBoard->lists = NULL;
+            newBoard->next = NULL;
+            newBoard->user = NULL;
+            memset(&newBoard->counts, 0, sizeof(TaskCounts));
+            noteId(chunk, newBoard->id);
+            BoardRecord record = { newBoard, fields[2] };
+            if (!appendRecord(chunk, &record, sizeof(BoardRecord))) {
+                unloadString(chunk, newBoard->name, newBoard->nameStorage);
+                free(newBoard);
+                chunk->failed = 1;
+                free(fields);
+                break;
             }
         } else {
-            fprintf(stderr, "Invalid record format in boards.csv: %s", line);
+            fprintf(stderr, "Invalid record format in boards.csv: %s\n", line);
         }
-
-        // Free the dynamically allocated fields
-        
-        free(line);
+        free(fields);
     }
-    fclose(fpBoards);
+    TRACE_END(spanStart, "loadBoards");
 }
 
-void loadLists(Board* board) {
-    FILE* fpLists = fopen("lists.csv", "r");
-    if (fpLists == NULL) {
-        perror("Unable to open lists file for reading");
-        return;
-    }
-
-    // Skip the header line
-    char* line = dynamicFgets(fpLists);
-    free(line); // Free the header line
-
-    while ((line = dynamicFgets(fpLists)) != NULL) {
+void loadLists(LoadChunk* chunk) {
+    char* line;
+    TRACE_BEGIN(spanStart);
+    while ((line = nextRecord(chunk)) != NULL) {
+        if (*line == '\0') {
+            continue;
+        }
         int fieldCount = 0;
         char** fields = parseCSVLine(line, &fieldCount);
+        if (fields == NULL) {
+            chunk->failed = 1;
+            break;
+        }
 
         if (fieldCount >= 3) {
-            // Check if the board ID matches
-            long boardId = strtol(fields[2], NULL, 10);
-            if (board->id == boardId) {
-                List* newList = (List*)malloc(sizeof(List));
-                if (newList == NULL) {
-                    perror("Memory allocation failed for newList");
-                    break;
-                }
-                newList->id = strtol(fields[0], NULL, 10);
-                newList->name = strdup(fields[1]);
-                newList->tasks = NULL;
-                newList->next = board->lists;
-                board->lists = newList;
+            List* newList = (List*)malloc(sizeof(List));
+            if (newList == NULL) {
+                perror("Memory allocation failed for newList");
+                chunk->failed = 1;
+                free(fields);
+                break;
+            }
+            newList->id = strtol(fields[0], NULL, 10);
+            loadString(chunk, &newList->name, newList->nameStorage, LIST_NAME_INLINE, fields[1]);
+            newList->modified = fieldCount >= 4 ? strtol(fields[3], NULL, 10) : 0;
+            newList->newestChange = 0;
+            newList->tasks = NULL;
+            newList->next = NULL;
+            newList->board = NULL;
+            memset(&newList->counts, 0, sizeof(TaskCounts));
+            initTaskOrder(newList);
+            noteId(chunk, newList->id);
+            ListRecord record = { newList, strtol(fields[2], NULL, 10) };
+            if (!appendRecord(chunk, &record, sizeof(ListRecord))) {
+                unloadString(chunk, newList->name, newList->nameStorage);
+                free(newList);
+                chunk->failed = 1;
+                free(fields);
+                break;
             }
         } else {
-            fprintf(stderr, "Invalid record format in lists.csv: %s", line);
+            fprintf(stderr, "Invalid record format in lists.csv: %s\n", line);
         }
-
-        // Free the dynamically allocated fields
-        
-        free(line);
+        free(fields);
     }
-    fclose(fpLists);
+    TRACE_END(spanStart, "loadLists");
 }
 
-void loadTasks(List* list) {
-    FILE* fpTasks = fopen("tasks.csv", "r");
-    if (fpTasks == NULL) {
-        perror("Unable to open tasks file for reading");
-        return;
+// Builds a task from the columns tasks.csv and archive.csv share
+static Task* newLoadedTask(LoadChunk* chunk, char** fields, int fieldCount) {
+    Task* newTask = (Task*)malloc(sizeof(Task));
+    if (newTask == NULL) {
+        perror("Memory allocation failed for newTask");
+        return NULL;
     }
+    newTask->id = strtol(fields[0], NULL, 10);
+    loadString(chunk, &newTask->name, newTask->nameStorage, TASK_NAME_INLINE, fields[1]);
+    loadString(chunk, &newTask->priority, newTask->priorityStorage, PRIORITY_INLINE, fields[2]);
+    char date[DATE_INLINE];
+    if (normalizeDate(fields[3], date) && strcmp(date, fields[3]) != 0) {
+        strcpy(newTask->dateStorage, date); // Saved unpadded by an older version
+        newTask->date = newTask->dateStorage;
+    } else {
+        loadString(chunk, &newTask->date, newTask->dateStorage, DATE_INLINE, fields[3]);
+    }
+    if (fieldCount >= 6) {
+        loadString(chunk, &newTask->position, newTask->positionStorage, POSITION_INLINE, fields[5]);
+    } else {
+        // Written before position keys existed; linkLoadedData assigns one
+        newTask->positionStorage[0] = '\0';
+        newTask->position = newTask->positionStorage;
+    }
+    newTask->modified = 0;
+    newTask->next = NULL;
+    newTask->list = NULL;
+    newTask->reminder = NULL;
+    noteId(chunk, newTask->id);
+    return newTask;
+}
 
-    // Skip the header line
-    char* line = dynamicFgets(fpTasks);
-    free(line); // Free the header line
-
-    while ((line = dynamicFgets(fpTasks)) != NULL) {
+void loadTasks(LoadChunk* chunk) {
+    char* line;
+    TRACE_BEGIN(spanStart);
+    while ((line = nextRecord(chunk)) != NULL) {
+        if (*line == '\0') {
+            continue;
+        }
         int fieldCount = 0;
         char** fields = parseCSVLine(line, &fieldCount);
+        if (fields == NULL) {
+            chunk->failed = 1;
+            break;
+        }
 
         if (fieldCount >= 5) {
-            // Check if the list ID matches
-            long listId = strtol(fields[4], NULL, 10);
-            if (list->id == listId) {
-                Task* newTask = (Task*)malloc(sizeof(Task));
-                if (newTask == NULL) {
-                    perror("Memory allocation failed for newTask");
-                    break;
-                }
-                newTask->id = strtol(fields[0], NULL, 10);
-                newTask->name = strdup(fields[1]);
-                newTask->priority = strdup(fields[2]);
-                newTask->date = strdup(fields[3]);
-                newTask->next = list->tasks;
-                list->tasks = newTask;
+            Task* newTask = newLoadedTask(chunk, fields, fieldCount);
+            if (newTask == NULL) {
+                chunk->failed = 1;
+                free(fields);
+                break;
+            }
+            if (fieldCount >= 7) {
+                newTask->modified = strtol(fields[6], NULL, 10);
+            }
+            TaskRecord record = { newTask, strtol(fields[4], NULL, 10) };
+            if (!appendRecord(chunk, &record, sizeof(TaskRecord))) {
+                unloadTask(chunk, newTask);
+                chunk->failed = 1;
+                free(fields);
+                break;
             }
         } else {
-            fprintf(stderr, "Invalid record format in tasks.csv: %s", line);
+            fprintf(stderr, "Invalid record format in tasks.csv: %s\n", line);
         }
-
-        // Free the dynamically allocated fields
-        
-        free(line);
+        free(fields);
     }
-    fclose(fpTasks);
+    TRACE_END(spanStart, "loadTasks");
 }
 
-void loadAllData(User** users) {
-    // Load users
-    loadUsers(users);
-
-    // Load boards for each user
-    for (User* currentUser = *users; currentUser != NULL; currentUser = currentUser->next) {
-        loadBoards(currentUser);
-    }
+// Same columns as tasks.csv plus the owner, since the task's list may be deleted later
+void loadArchivedTasks(LoadChunk* chunk) {
+    char* line;
+    while ((line = nextRecord(chunk)) != NULL) {
+        if (*line == '\0') {
+            continue;
+        }
+        int fieldCount = 0;
+        char** fields = parseCSVLine(line, &fieldCount);
+        if (fields == NULL) {
+            chunk->failed = 1;
+            break;
+        }
 
-    // Load lists for each board of each user
-    for (User* currentUser = *users; currentUser != NULL; currentUser = currentUser->next) {
-        for (Board* currentBoard = currentUser->boards; currentBoard != NULL; currentBoard = currentBoard->next) {
-            loadLists(currentBoard);
+        if (fieldCount >= 1 && strcmp(fields[0], ARCHIVE_MAX_ID) == 0) {
+            // Read at startup by seedArchivedIds
+        } else if (fieldCount >= 7) {
+            Task* newTask = newLoadedTask(chunk, fields, fieldCount);
+            if (newTask == NULL) {
+                chunk->failed = 1;
+                free(fields);
+                break;
+            }
+            ArchiveRecord record = { newTask, strtol(fields[4], NULL, 10), fields[6] };
+            if (!appendRecord(chunk, &record, sizeof(ArchiveRecord))) {
+                unloadTask(chunk, newTask);
+                chunk->failed = 1;
+                free(fields);
+                break;
+            }
+        } else {
+            fprintf(stderr, "Invalid record format in archive.csv: %s\n", line);
         }
+        free(fields);
     }
+}
 
-    // Load tasks for each list of each board of each user
-    for (User* currentUser = *users; currentUser != NULL; currentUser = currentUser->next) {
-        for (Board* currentBoard = currentUser->boards; currentBoard != NULL; currentBoard = currentBoard->next) {
-            for (List* currentList = currentBoard->lists; currentList != NULL; currentList = currentList->next) {
-                loadTasks(currentList);
+// Sequence, data file and ID of each deletion the change feed still carries. The "pruned"
+// record is kept as a tombstone of type RECORD_TYPES until linkLoadedData takes its floor.
+void loadTombstones(LoadChunk* chunk) {
+    char* line;
+    while ((line = nextRecord(chunk)) != NULL) {
+        if (*line == '\0') {
+            continue;
+        }
+        int fieldCount = 0;
+        char** fields = parseCSVLine(line, &fieldCount);
+        if (fields == NULL) {
+            chunk->failed = 1;
+            break;
+        }
+        int type = fieldCount >= 3 ? recordTypeOf(fields[1]) : -1;
+        if (fieldCount >= 2 && strcmp(fields[1], "pruned") == 0) {
+            type = RECORD_TYPES;
+        }
+        if (type >= 0) {
+            Tombstone tombstone = { strtol(fields[0], NULL, 10), fieldCount >= 3 ? strtol(fields[2], NULL, 10) : 0,
+                                    (RecordType)type };
+            if (!appendRecord(chunk, &tombstone, sizeof(Tombstone))) {
+                chunk->failed = 1;
+                free(fields);
+                break;
             }
+        } else {
+            fprintf(stderr, "Invalid record format in tombstones.csv: %s\n", line);
         }
+        free(fields);
     }
 }
 
-void freeTasks(Task* task) {
-    while (task != NULL) {
-        Task* currentTask = task;
-        task = task->next; // Move to the next task before freeing the current one
-        free(currentTask->name);
-        free(currentTask->priority);
-        free(currentTask->date);
-        free(currentTask); // Free the task structure itself
+static void parseChunkJob(void* arg) {
+    LoadChunk* chunk = (LoadChunk*)arg;
+    chunk->parse(chunk);
+    releaseStringPool(&chunk->strings);
+}
+
+static void decompressChunkJob(void* arg) {
+    BlockJob* block = (BlockJob*)arg;
+    LoadChunk* chunk = block->chunk;
+    int ok;
+    if (block->sourceSize == block->rawSize) {
+        memcpy(block->target, block->source, block->rawSize); // Stored uncompressed
+        ok = 1;
+    } else {
+        ok = decompressBlock(block->source, block->sourceSize, block->target, block->rawSize);
+    }
+    if (!ok) {
+        fprintf(stderr, "Corrupted block in %s, its records were skipped.\n", block->fileName);
+        return;
+    }
+
+    chunk->begin = block->target;
+    chunk->end = block->target + block->rawSize;
+    if (block->isFirst) {
+        // Skip the header line
+        char* newline = memchr(chunk->begin, '\n', block->rawSize);
+        chunk->begin = newline ? newline + 1 : chunk->end;
+    }
+    parseChunkJob(chunk);
+}
+
+// Lays out the blocks of a compressed file and queues one decode-and-parse job per block
+static void scheduleCompressedChunks(DataFile* file) {
+    file->compressedData = file->data;
+    file->data = NULL;
+    const char* source = file->compressedData;
+    size_t fileSize = file->size;
+    file->size = 0;
+
+    // First pass: validate block headers and add up the decoded size
+    int blockCount = 0;
+    size_t rawTotal = 0;
+    size_t pos = COMPRESSION_MAGIC_SIZE;
+    while (pos + BLOCK_HEADER_SIZE <= fileSize) {
+        size_t rawSize = readUint32(source + pos);
+        size_t storedSize = readUint32(source + pos + 4);
+        if (storedSize > fileSize - pos - BLOCK_HEADER_SIZE || storedSize > rawSize) {
+            fprintf(stderr, "Truncated block in %s, later records were skipped.\n", file->fileName);
+            break;
+        }
+        blockCount++;
+        rawTotal += rawSize;
+        pos += BLOCK_HEADER_SIZE + storedSize;
+    }
+
+    file->data = malloc(rawTotal + 1);
+    file->chunks = calloc(blockCount ? blockCount : 1, sizeof(LoadChunk));
+    file->blocks = calloc(blockCount ? blockCount : 1, sizeof(BlockJob));
+    if (file->data == NULL || file->chunks == NULL || file->blocks == NULL) {
+        perror("Memory allocation failed for decompression");
+        file->failed = 1;
+        return;
+    }
+    file->size = rawTotal;
+    file->data[rawTotal] = '\0';
+
+    // Second pass: every block decodes into its own slice of the raw buffer
+    char* target = file->data;
+    pos = COMPRESSION_MAGIC_SIZE;
+    for (int i = 0; i < blockCount; i++) {
+        BlockJob* block = &file->blocks[i];
+        block->rawSize = readUint32(source + pos);
+        block->sourceSize = readUint32(source + pos + 4);
+        block->source = source + pos + BLOCK_HEADER_SIZE;
+        block->target = target;
+        block->isFirst = i == 0;
+        block->fileName = file->fileName;
+        block->chunk = &file->chunks[i];
+        block->chunk->parse = file->parse;
+        block->chunk->borrow = file->region != NULL;
+        target += block->rawSize;
+        pos += BLOCK_HEADER_SIZE + block->sourceSize;
+    }
+    file->chunkCount = blockCount;
+    for (int i = 0; i < blockCount; i++) {
+        submitJob(file->pool, decompressChunkJob, &file->blocks[i]);
+    }
+}
+
+// Reads a whole data file and hands its chunks to the pool for parsing
+static void loadDataFileJob(void* arg) {
+    DataFile* file = (DataFile*)arg;
+    FILE* fp = fopen(file->fileName, "rb");
+    if (fp == NULL && file->optional) {
+        return;
+    }
+    if (fp == NULL) {
+        char message[64];
+        snprintf(message, sizeof(message), "Unable to open %s file for reading", file->label);
+        perror(message);
+        return;
+    }
+    fseek(fp, 0, SEEK_END);
+    long fileSize = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    if (fileSize < 0) {
+        perror("Unable to read data file");
+        file->failed = 1;
+        fclose(fp);
+        return;
+    }
+
+    file->data = malloc((size_t)fileSize + 1); // +1 so the last record can be null-terminated in place
+    if (file->data == NULL) {
+        perror("Memory allocation failed for file buffer");
+        file->failed = 1;
+        fclose(fp);
+        return;
+    }
+    file->size = fread(file->data, 1, (size_t)fileSize, fp);
+    file->data[file->size] = '\0';
+    fclose(fp);
+    if (borrowStrings) {
+        file->region = reserveBorrowedRegion(); // Strings are copied if this fails
+    }
+
+    if (isCompressedData(file->data, file->size)) {
+        scheduleCompressedChunks(file);
+        return;
+    }
+
+    // Skip the header line
+    char* dataEnd = file->data + file->size;
+    char* cursor = memchr(file->data, '\n', file->size);
+    if (cursor == NULL) {
+        return; // Header only, or empty file
+    }
+    cursor++;
+
+    // Split the records into chunks that end on line boundaries
+    size_t maxChunks = (size_t)(dataEnd - cursor) / LOAD_CHUNK_SIZE + 1;
+    file->chunks = calloc(maxChunks, sizeof(LoadChunk));
+    if (file->chunks == NULL) {
+        perror("Memory allocation failed for chunks");
+        file->failed = 1;
+        return;
+    }
+    while (cursor < dataEnd && (size_t)file->chunkCount < maxChunks) {
+        LoadChunk* chunk = &file->chunks[file->chunkCount++];
+        char* chunkEnd = dataEnd;
+        if ((size_t)(dataEnd - cursor) > LOAD_CHUNK_SIZE) {
+            char* newline = memchr(cursor + LOAD_CHUNK_SIZE, '\n', dataEnd - (cursor + LOAD_CHUNK_SIZE));
+            if (newline != NULL) {
+                chunkEnd = newline + 1;
+            }
+        }
+        chunk->begin = cursor;
+        chunk->end = chunkEnd;
+        chunk->parse = file->parse;
+        chunk->borrow = file->region != NULL;
+        cursor = chunkEnd;
+    }
+    for (int i = 0; i < file->chunkCount; i++) {
+        submitJob(file->pool, parseChunkJob, &file->chunks[i]);
+    }
+}
+
+// Keeps the file's contents for as long as loaded strings point into it
+static void retainBorrowedStrings(DataFile* file) {
+    long borrowed = 0;
+    for (int c = 0; c < file->chunkCount; c++) {
+        borrowed += file->chunks[c].borrowedStrings;
+    }
+    if (borrowed > 0) {
+        retainBorrowedBuffer(file->region, file->data, file->size + 1, borrowed);
+        file->region = NULL;
+        file->data = NULL;
+    }
+}
+
+// Whether some of the file's records were dropped for want of memory rather than being invalid
+static int loadFailed(const DataFile* file) {
+    for (int c = 0; c < file->chunkCount; c++) {
+        if (file->chunks[c].failed) {
+            return 1;
+        }
+    }
+    return file->failed;
+}
+
+static void releaseDataFile(DataFile* file) {
+    for (int c = 0; c < file->chunkCount; c++) {
+        free(file->chunks[c].records);
+    }
+    free(file->chunks);
+    free(file->blocks);
+    free(file->compressedData);
+    free(file->data);
+    free(file->region); // Reserved but no string borrowed from the buffer
+}
+
+// Attaches tasks to lists, lists to boards and boards to users by ID, in file order
+static void orderLoadedTasks(List* list);
+
+static void linkLoadedData(User** users, DataFile* files) {
+    long maxId = 0;
+
+    DataFile* userFile = &files[0];
+    for (int c = 0; c < userFile->chunkCount; c++) {
+        User** records = (User**)userFile->chunks[c].records;
+        for (size_t i = 0; i < userFile->chunks[c].recordCount; i++) {
+            User* newUser = records[i];
+            newUser->next = *users; // Link the new user to the head of the list
+            *users = newUser;
+            indexUser(newUser);
+            noteLoadedChange(newUser->modified, newUser, NULL, NULL);
+        }
+    }
+
+    DataFile* boardFile = &files[1];
+    for (int c = 0; c < boardFile->chunkCount; c++) {
+        BoardRecord* records = (BoardRecord*)boardFile->chunks[c].records;
+        for (size_t i = 0; i < boardFile->chunks[c].recordCount; i++) {
+            Board* newBoard = records[i].board;
+            User* owner = findUserByName(records[i].username);
+            if (owner == NULL) {
+                fprintf(stderr, "Skipping board '%s': user '%s' not found.\n", newBoard->name, records[i].username);
+                freeBoards(newBoard);
+                continue;
+            }
+            newBoard->user = owner;
+            newBoard->next = owner->boards;
+            owner->boards = newBoard;
+            indexBoard(newBoard);
+            noteLoadedChange(newBoard->modified, owner, newBoard, NULL);
+        }
+        if (boardFile->chunks[c].maxId > maxId) {
+            maxId = boardFile->chunks[c].maxId;
+        }
+    }
+
+    DataFile* listFile = &files[2];
+    for (int c = 0; c < listFile->chunkCount; c++) {
+        ListRecord* records = (ListRecord*)listFile->chunks[c].records;
+        for (size_t i = 0; i < listFile->chunks[c].recordCount; i++) {
+            List* newList = records[i].list;
+            Board* board = findBoardById(records[i].boardId);
+            if (board == NULL) {
+                fprintf(stderr, "Skipping list '%s': board %ld not found.\n", newList->name, records[i].boardId);
+                freeLists(newList);
+                continue;
+            }
+            newList->board = board;
+            newList->next = board->lists;
+            board->lists = newList;
+            indexList(newList);
+            noteLoadedChange(newList->modified, board->user, board, newList);
+        }
+        if (listFile->chunks[c].maxId > maxId) {
+            maxId = listFile->chunks[c].maxId;
+        }
+    }
+
+    DataFile* taskFile = &files[3];
+    for (int c = 0; c < taskFile->chunkCount; c++) {
+        TaskRecord* records = (TaskRecord*)taskFile->chunks[c].records;
+        for (size_t i = 0; i < taskFile->chunks[c].recordCount; i++) {
+            Task* newTask = records[i].task;
+            List* list = findListById(records[i].listId);
+            if (list == NULL) {
+                fprintf(stderr, "Skipping task '%s': list %ld not found.\n", newTask->name, records[i].listId);
+                freeTasks(newTask);
+                continue;
+            }
+            newTask->list = list;
+            newTask->next = list->tasks;
+            list->tasks = newTask;
+            indexTask(newTask);
+            countTask(newTask);
+            scheduleReminder(newTask);
+            noteLoadedChange(newTask->modified, list->board->user, list->board, list);
+        }
+        if (taskFile->chunks[c].maxId > maxId) {
+            maxId = taskFile->chunks[c].maxId;
+        }
+    }
+
+    // Before any task positions are renumbered below, so new change numbers follow the loaded ones
+    DataFile* tombstoneFile = &files[4];
+    for (int c = 0; c < tombstoneFile->chunkCount; c++) {
+        Tombstone* records = (Tombstone*)tombstoneFile->chunks[c].records;
+        for (size_t i = 0; i < tombstoneFile->chunks[c].recordCount; i++) {
+            if (records[i].type == RECORD_TYPES) {
+                notePrunedTombstones(records[i].sequence);
+            } else {
+                addTombstone(&records[i]);
+            }
+        }
+    }
+    for (User* user = *users; user != NULL; user = user->next) {
+        for (Board* board = user->boards; board != NULL; board = board->next) {
+            for (List* list = board->lists; list != NULL; list = list->next) {
+                orderLoadedTasks(list);
+            }
+        }
+    }
+
+    seedUniqueId(maxId);
+}
+
+// Returns 0 if some records could not be loaded; what was loaded is still linked so it can be
+// freed, but must not be saved over the data files
+int loadAllData(User** users) {
+    long long startTicks = statsClock();
+    dataRoot = users;
+    recoverDataFiles();
+    DataFile files[] = {
+        { "users.csv", "users", loadUsers },
+        { "boards.csv", "boards", loadBoards },
+        { "lists.csv", "lists", loadLists },
+        { "tasks.csv", "tasks", loadTasks },
+        { "tombstones.csv", "tombstones", loadTombstones, 1 },
+    };
+    int fileCount = sizeof(files) / sizeof(files[0]);
+
+    // Read and parse all the files concurrently, large files in several chunks
+    ThreadPool* pool = createThreadPool(getCoreCount());
+    for (int i = 0; i < fileCount; i++) {
+        files[i].pool = pool;
+        submitJob(pool, loadDataFileJob, &files[i]);
+    }
+    waitForJobs(pool);
+    destroyThreadPool(pool);
+
+    for (int i = 0; i < fileCount; i++) {
+        retainBorrowedStrings(&files[i]);
+    }
+    linkLoadedData(users, files);
+    seedArchivedIds();
+    int loaded = 1;
+    for (int i = 0; i < fileCount; i++) {
+        if (loadFailed(&files[i])) {
+            fprintf(stderr, "Unable to load every record of %s.\n", files[i].fileName);
+            loaded = 0;
+        }
+        releaseDataFile(&files[i]);
+    }
+    recordTiming(TIMER_LOAD, startTicks);
+    TRACE_END(startTicks, "loadAllData");
+    return loaded;
+}
+
+void freeTasks(Task* task) {
+    while (task != NULL) {
+        Task* currentTask = task;
+        task = task->next; // Move to the next task before freeing the current one
+        releaseString(currentTask->name, currentTask->nameStorage);
+        releaseString(currentTask->priority, currentTask->priorityStorage);
+        releaseString(currentTask->date, currentTask->dateStorage);
+        releaseString(currentTask->position, currentTask->positionStorage);
+        cancelReminder(currentTask);
+        free(currentTask); // Free the task structure itself
     }
 }
 
@@ -542,7 +1545,8 @@ void freeLists(List* list) {
         List* currentList = list;
         list = list->next; // Move to the next list before freeing the current one
         freeTasks(currentList->tasks); // Free all tasks in the list
-        free(currentList->name);
+        freeTaskOrder(currentList);
+        releaseString(currentList->name, currentList->nameStorage);
         free(currentList); // Free the list structure itself
     }
 }
@@ -552,7 +1556,7 @@ void freeBoards(Board* board) {
         Board* currentBoard = board;
         board = board->next; // Move to the next board before freeing the current one
         freeLists(currentBoard->lists); // Free all lists in the board
-        free(currentBoard->name);
+        releaseString(currentBoard->name, currentBoard->nameStorage);
         free(currentBoard); // Free the board structure itself
     }
 }
@@ -562,6 +1566,11 @@ void freeUsers(User* user) {
         User* currentUser = user;
         user = user->next; // Move to the next user before freeing the current one
         freeBoards(currentUser->boards); // Free all boards for the user
+        releaseString(currentUser->username, NULL);
+        releaseString(currentUser->password, NULL);
+        freeIndex(&currentUser->boardsByName);
+        freeIndex(&currentUser->listsByName);
+        dropSnapshotCopy(currentUser); // Snapshots that hold the copy keep it
         free(currentUser); // Free the user structure itself
     }
 }
@@ -570,63 +1579,75 @@ void freeAllData(User** users) {
     if (users != NULL) {
         freeUsers(*users); // Free all users and their associated data
         *users = NULL; // Set the users list head to NULL
+        clearEntityIndexes();
+        freeArchive();
+        archiveMaxId = 0;
+        freeTombstones();
+        releaseStringPool(&stringPool); // Strings still in use keep their block alive
+        if (dataRoot == users) {
+            dataRoot = NULL; // The head may be a local that is about to go away
+        }
     }
 }
 
 // Function to check if a username already exists in the list of users
 int userExists(User* users, const char* username) {
-    while (users != NULL) {
-        if (strcmp(users->username, username) == 0) {
-            return 1; // User exists
-        }
-        users = users->next;
-    }
-    return 0; // User does not exist
+    return findUserByName(username) != NULL;
 }
 
-// Function to handle user signup with command line arguments
-User* signupWithArgs(User** users, const char* username, const char* password) {
-    if (userExists(*users, username)) {
-        printf("Username is already taken.\n");
-        return NULL;
-    }
-
+// Creates the user at the head of the list; the name must not be taken
+static User* linkNewUser(User** users, const char* username, const char* password) {
     User* newUser = malloc(sizeof(User));
     if (!newUser) {
         printf("Failed to allocate memory for new user.\n");
         return NULL;
     }
 
-    newUser->username = strdup(username);
-    newUser->password = strdup(password);
+    newUser->username = newUser->password = NULL;
     newUser->boards = NULL; // Initialize boards to NULL
-
-    if (!newUser->username || !newUser->password) {
+    newUser->newestChange = 0;
+    memset(&newUser->counts, 0, sizeof(TaskCounts));
+    initIndex(&newUser->boardsByName);
+    initIndex(&newUser->listsByName);
+    newUser->snapshotCopy = NULL;
+
+    if (!storeString(&stringPool, &newUser->username, NULL, 0, username) ||
+        !storeString(&stringPool, &newUser->password, NULL, 0, password)) {
         printf("Failed to duplicate username or password.\n");
-        free(newUser->username); // Safe to call free on NULL
-        free(newUser->password);
+        releaseString(newUser->username, NULL); // Safe to call on NULL
+        releaseString(newUser->password, NULL);
         free(newUser);
         return NULL;
     }
 
     newUser->next = *users;
     *users = newUser;
+    indexUser(newUser);
+    touchUser(newUser);
+    return newUser;
+}
 
-    printf("Signup successful.\n");
+// Function to handle user signup with command line arguments
+User* signupWithArgs(User** users, const char* username, const char* password) {
+    if (userExists(*users, username)) {
+        printf("Username is already taken.\n");
+        return NULL;
+    }
+    User* newUser = linkNewUser(users, username, password);
+    if (newUser != NULL) {
+        printf("Signup successful.\n");
+    }
     return newUser;
 }
 
 // Function to handle user login with command line arguments
 User* loginWithArgs(User* users, const char* username, const char* password) {
-    User* currentUser = users;
-    while (currentUser != NULL) {
-        if (strcmp(currentUser->username, username) == 0 &&strcmp(currentUser->password, password) == 0) {
-            // Authentication successful
-            printf("Login successful. Welcome, %s!\n", username);
-            clearScreen();
-            return currentUser; // Return the authenticated user
-        }
-        currentUser = currentUser->next;
+    User* currentUser = findUserByName(username);
+    if (currentUser != NULL && strcmp(currentUser->password, password) == 0) {
+        // Authentication successful
+        printf("Login successful. Welcome, %s!\n", username);
+        clearScreen();
+        return currentUser; // Return the authenticated user
     }
 
     printf("Login failed. Please try again.\n");
@@ -634,144 +1655,206 @@ User* loginWithArgs(User* users, const char* username, const char* password) {
     return NULL; // Authentication failed
 }
 
-char* getNextToken(char** input) {
+// Reads signup/login commands until exit or the end of input, running the boards menu for each user
+void runSession(User** users) {
+    while (1) {
+        printf("Enter command (signup or login), followed by username and password in quotes if containing spaces, or 'exit' to quit:\n");
+        printf("> ");
+        char* input = readInputLine();  // Reuses one buffer for every command
+        char* rest = input;  // Initialize rest to the start of input
+
+        if (input == NULL || strncmp(input, "exit", 4) == 0) {
+            break;
+        }
+
+        long long commandStart = statsClock();
+        User* loggedInUser = NULL;
+        char* command = getNextToken(&rest);  // Extract command
+
+        if (command && (strcmp(command, "signup") == 0 || strcmp(command, "login") == 0)) {
+            char* username = getNextToken(&rest);  // Extract username
+            char* password = getNextToken(&rest);  // Extract password
+
+            if (username && password) {
+                if (strcmp(command, "signup") == 0) {
+                    loggedInUser = signupWithArgs(users, username, password);
+                    recordActionLatency("signup", commandStart);
+                } else if (strcmp(command, "login") == 0) {
+                    loggedInUser = loginWithArgs(*users, username, password);
+                    recordActionLatency("login", commandStart);
+                }
+            } else {
+                printf("Invalid format. Please follow the '<command> \"<username>\" \"<password>\"' format.\n");
+            }
+        } else {
+            printf("Unknown command. Please use 'signup' or 'login'.\n");
+        }
+
+        if (loggedInUser) {
+            boardsMenu(loggedInUser);
+            clearScreen();
+        }
+    }
+}
+
+// Scans the next token: quoted with "..." or <...>, or unquoted up to a space or one of stopChars.
+// The character that ended the token is stored in separator ('\0' at the end of the input).
+char* scanToken(char** input, const char* stopChars, char* separator) {
     char* start = *input;
     char* end;
-    char* token;
+    char ended = '\0';
 
     // Skip leading spaces
     while (*start && *start == ' ') start++;
 
-    if (*start == '<') {  // Quoted token
+    if (*start == '<' || *start == QUOTE) {  // Quoted token
+        char closing = *start == '<' ? '>' : QUOTE;
         start++;  // Skip the opening quote
-        end = strchr(start, '>');  // Find the closing quote
-        if (end) {
-            *end = '\0';  // Terminate the token
-            *input = end + 2;  // Move past the closing quote and space
-        } else {
+        end = strchr(start, closing);  // Find the closing quote
+        if (end == NULL) {
             // Handle error: unmatched quote
             printf("Error: Unmatched quote.\n");
             return NULL;
         }
-        token = start;
+        *end++ = '\0';  // Terminate the token
+        if (*end == ' ' || (*end != '\0' && strchr(stopChars, *end) != NULL)) {
+            ended = *end++;  // Move past the separator that follows the closing quote
+        }
+        *input = end;
     } else {  // Unquoted token
-        end = strchr(start, ' ');  // Find the next space
-        if (end) {
+        end = start + strcspn(start, stopChars);  // Find the next separator
+        ended = *end;
+        if (*end) {
             *end = '\0';  // Terminate the token
-            *input = end + 1;  // Move past the space
+            *input = end + 1;  // Move past the separator
         } else {
-            *input = start + strlen(start);  // No more tokens
+            *input = end;  // No more tokens
         }
-        token = start;
     }
 
-    return (*token == '\0') ? NULL : token;
+    if (separator != NULL) {
+        *separator = ended;
+    }
+    return (*start == '\0') ? NULL : start;
+}
+
+char* getNextToken(char** input) {
+    return scanToken(input, " ", NULL);
 }
 
 void displayBoards(const User* user) {
-    printf("Available Boards:\n");
+    screenPrintf("Available Boards:\n");
     const Board* currentBoard = user->boards;
     int boardCount = 0;
     while (currentBoard != NULL) {
-        printf("%d. %s\n", ++boardCount, currentBoard->name);
+        screenPrintf("%d. %s (#%ld)\n", ++boardCount, currentBoard->name, currentBoard->id);
         currentBoard = currentBoard->next;
     }
     if (boardCount == 0) {
-        printf("No boards available.\n");
+        screenPrintf("No boards available.\n");
     }
 }
 
 Board* selectBoard(User* user) {
-    printf("Enter the number of the board to select, or 0 to go back: ");
-    int choice = atoi(dynamicInput());
+    printf("Enter the number, name or #ID of the board to select, or 0 to go back: ");
+    const char* key = readSelectionKey();
+    Board* selected = key != NULL ? findBoard(user, key) : NULL;
+    return selected; // NULL when nothing or an unknown board was chosen
+}
+
+// Resolves a board by its 1-based position, by "#ID" or by its name
+Board* findBoard(User* user, const char* key) {
+    char* end;
+    if (key[0] == '#') {
+        Board* board = findBoardById(strtol(key + 1, &end, 10));
+        return board != NULL && *end == '\0' && board->user == user ? board : NULL;
+    }
+    long position = strtol(key, &end, 10);
+    if (*key == '\0' || *end != '\0') {
+        return findBoardByName(user, key);
+    }
     int boardIndex = 1;
-    Board* currentBoard = user->boards;
-    while (currentBoard != NULL) {
-        if (boardIndex == choice) {
-            return currentBoard; // Return the selected board
+    for (Board* board = user->boards; board != NULL; board = board->next, boardIndex++) {
+        if (boardIndex == position) {
+            return board;
         }
-        boardIndex++;
-        currentBoard = currentBoard->next;
     }
-    clearScreen();
-    return NULL; // No board selected or invalid choice
+    return NULL;
+}
+
+static Board* linkNewBoard(User* user, const char* name, long id) {
+    Board* newBoard = malloc(sizeof(Board));
+    if (newBoard != NULL) {
+        newBoard->name = NULL;
+    }
+    if (newBoard == NULL || !storeString(&stringPool, &newBoard->name, newBoard->nameStorage, BOARD_NAME_INLINE, name)) {
+        printf("Failed to allocate memory for new board.\n");
+        free(newBoard);
+        return NULL;
+    }
+    // Prepend the new board
+    newBoard->lists = NULL;
+    newBoard->newestChange = 0;
+    memset(&newBoard->counts, 0, sizeof(TaskCounts));
+    newBoard->next = user->boards;
+    newBoard->id = id;
+    newBoard->user = user;
+    user->boards = newBoard;
+    indexBoard(newBoard);
+    touchBoard(newBoard);
+    return newBoard;
+}
+
+Board* createBoardWithArgs(User* user, const char* name) {
+    return linkNewBoard(user, name, generateUniqueId());
 }
 
 void createBoard(User* user) {
     printf("Enter the name of the new board: ");
     char* boardName = dynamicInput();
     if (boardName != NULL && boardName[0] != '\0') {
-        // Create and prepend the new board
-        Board* newBoard = malloc(sizeof(Board));
-        newBoard->name = boardName;
-        newBoard->lists = NULL;
-        newBoard->next = user->boards;
-        newBoard->id = generateUniqueId();
-        user->boards = newBoard;
-        printf("Board '%s' created successfully.\n", boardName);
+        if (createBoardWithArgs(user, boardName)) {
+            printf("Board '%s' created successfully.\n", boardName);
+        }
     } else {
         printf("Board creation cancelled.\n");
-        free(boardName); // Free the input if the user entered an empty name
     }
+    free(boardName);
+}
+
+// Unlinks the board from the user and frees it with all of its lists and tasks
+void deleteBoardWithArgs(User* user, Board* board) {
+    Board** link = &user->boards;
+    while (*link != NULL && *link != board) {
+        link = &(*link)->next;
+    }
+    if (*link == NULL) {
+        return;
+    }
+    *link = board->next; // Bypass the board
+    board->next = NULL;
+    unindexBoard(board);
+    uncountBoard(board);
+    recordBoardDeletion(board);
+    freeBoards(board);
 }
 
 void deleteBoard(User* user) {
     displayBoards(user); // Show all boards
-    printf("Enter the number of the board to delete, or 0 to cancel: ");
-    int choice = atoi(dynamicInput());
-    int boardIndex = 1;
-    Board* currentBoard = user->boards;
-    Board* prevBoard = NULL;
-    while (currentBoard != NULL) {
-        if (boardIndex == choice) {
-            // Found the board to delete
-            if (prevBoard == NULL) {
-                user->boards = currentBoard->next; // Board is the head of the user
-            } else {
-                prevBoard->next = currentBoard->next; // Bypass the current board
-            }
-            // Delete all lists in the board
-            while (currentBoard->lists != NULL) {
-                List* listToDelete = currentBoard->lists;
-                currentBoard->lists = listToDelete->next;
-                // Delete all tasks in the list
-                while (listToDelete->tasks != NULL) {
-                    Task* taskToDelete = listToDelete->tasks;
-                    listToDelete->tasks = taskToDelete->next;
-                    free(taskToDelete->name);
-                    free(taskToDelete->priority);
-                    free(taskToDelete->date);
-                    free(taskToDelete);
-                }
-                free(listToDelete->name);
-                free(listToDelete);
-            }
-            free(currentBoard->name);
-            free(currentBoard);
-            printf("Board deleted successfully.\n");
-            return;
-        }
-        prevBoard = currentBoard;
-        currentBoard = currentBoard->next;
-        boardIndex++;
+    printf("Enter the number, name or #ID of the board to delete, or 0 to cancel: ");
+    const char* key = readSelectionKey();
+    if (key == NULL) {
+        return;
     }
-    if (choice != 0) {
+    Board* selected = findBoard(user, key);
+    if (selected == NULL) {
         printf("Board not found.\n");
+        return;
     }
+    deleteBoardWithArgs(user, selected);
+    printf("Board deleted successfully.\n");
 }
 
-// Helper function to compare two tasks by their deadline.
-int taskDeadlineComparator(const void* a, const void* b) {
-    const TaskInfo* infoA = (const TaskInfo*)a;
-    const Task* taskA = infoA->task;
-
-    const TaskInfo* infoB = (const TaskInfo*)b;
-    const Task* taskB = infoB->task;
-
-    return strcmp(taskA->date, taskB->date); // Ascending order
-}
-
-
 char* getCurrentDate() {
     time_t now = time(NULL);
     struct tm* now_tm = localtime(&now);
@@ -782,199 +1865,276 @@ char* getCurrentDate() {
     return currentDate;
 }
 
-void showUpcomingTasks(User* user) {
+// Shows the user's next few deadlines after today; the merge stops once they have been found
+void showUpcomingTasks(const User* user) {
     if (user == NULL || user->boards == NULL) {
         fprintf(stderr, "User or boards is NULL.\n");
         return;
     }
 
+    long long startTicks = statsClock();
     char* currentDate = getCurrentDate();
-    TaskInfo* upcomingTasks = NULL;
-    size_t taskCount = 0;
+    TaskMerge merge;
+    if (currentDate == NULL || !startTaskMerge(&merge, user, SORT_BY_DATE, currentDate)) {
+        fprintf(stderr, "Failed to allocate memory for upcomingTasks.\n");
+        free(currentDate);
+        return;
+    }
 
-    // Iterate over all boards
-    for (Board* board = user->boards; board != NULL; board = board->next) {
-        // Iterate over all lists in the current board
-        if (board->lists == NULL) continue;
-        for (List* list = board->lists; list != NULL; list = list->next) {
-            // Iterate over all tasks in the current list
-            if (list->tasks == NULL) continue;
-            for (Task* task = list->tasks; task != NULL; task = task->next) {
-                // Check if the task's date is later than the current date
-                if (strcmp(task->date, currentDate) > 0) {
-                    // Reallocate memory for the upcomingTasks array
-                    upcomingTasks = realloc(upcomingTasks, (taskCount + 1) * sizeof(TaskInfo));
-                    if (upcomingTasks == NULL) {
-                        fprintf(stderr, "Failed to allocate memory for upcomingTasks.\n");
-                        return;
-                    }
+    int shown = 0;
+    Task* task;
+    while (shown < UPCOMING_TASK_COUNT && (task = nextMergedTask(&merge)) != NULL) {
+        screenPrintf("%d) Task: %s, Priority: %s, Deadline: %s, Board: %s, List: %s\n", ++shown, task->name,
+               task->priority, task->date, task->list->board->name, task->list->name);
+    }
+    if (merge.failed) {
+        fprintf(stderr, "Failed to allocate memory for upcomingTasks.\n");
+    }
 
-                    // Add the current task to the upcomingTasks array
-                    upcomingTasks[taskCount].task = malloc(sizeof(Task));
-                    *(upcomingTasks[taskCount].task) = *task; // Copy the task
-                    upcomingTasks[taskCount].boardName = strdup(board->name); // Copy the board name
-                    upcomingTasks[taskCount].listName = strdup(list->name); // Copy the list name
-                    taskCount++;
-                }
+    endTaskMerge(&merge);
+    free(currentDate);
+    recordTiming(TIMER_UPCOMING, startTicks);
+    TRACE_END(startTicks, "showUpcomingTasks");
+}
+
+// Pages through every task the user has, across all boards and lists, in the given order
+void showAllTasks(const User* user, TaskSortMode mode) {
+    TaskMerge merge;
+    if (!startTaskMerge(&merge, user, mode, NULL)) {
+        perror("Memory allocation failed for the task view");
+        return;
+    }
+
+    int shown = 0;
+    Task* task;
+    while ((task = nextMergedTask(&merge)) != NULL) {
+        if (shown > 0 && shown % TASK_PAGE_SIZE == 0) {
+            printf("-- %d tasks shown; press Enter for more or type q to stop: ", shown);
+            char* answer = readInputLine();
+            if (answer == NULL || answer[0] == 'q') {
+                break;
             }
         }
+        printf("%d. %s (#%ld) - Priority: %s, Deadline: %s, Board: %s, List: %s\n", ++shown, task->name,
+               task->id, task->priority, task->date, task->list->board->name, task->list->name);
+    }
+    if (merge.failed) {
+        perror("Memory allocation failed for the task view");
     }
+    if (shown == 0) {
+        printf("No tasks available.\n");
+    }
+    endTaskMerge(&merge);
+}
 
-    // Sort the upcomingTasks array by task deadline
-    qsort(upcomingTasks, taskCount, sizeof(TaskInfo), taskDeadlineComparator);
+static const char* boardsMenuActions[] = { NULL, "open board", "create board", "delete board", "exit boards" };
+static const char* listsMenuActions[] = { NULL, "open list", "create list", "delete list", "exit lists" };
+static const char* tasksMenuActions[] = { NULL, "add task", "edit task", "delete task", "move task",
+                                          "sort tasks", "bulk tasks", "exit tasks" };
 
-    // Print out the upcoming tasks
-    for (size_t i = 0; i < taskCount && i < 3; i++) {
-        printf("%d) Task: %s, Priority: %s, Deadline: %s, Board: %s, List: %s\n", i+1, upcomingTasks[i].task->name, upcomingTasks[i].task->priority, upcomingTasks[i].task->date, upcomingTasks[i].boardName, upcomingTasks[i].listName);
-    }
+#define MENU_ACTION_COUNT(actions) (int)(sizeof(actions) / sizeof(actions[0]))
 
-    // Free the allocated memory
-    for (size_t i = 0; i < taskCount; i++) {
-        free(upcomingTasks[i].task);
-        free(upcomingTasks[i].boardName);
-        free(upcomingTasks[i].listName);
+// Options that open a nested menu are timed up to the selection, before the nested menu runs
+static void recordMenuAction(const char** actions, int actionCount, int choice, long long startTicks) {
+    if (choice > 0 && choice < actionCount) {
+        recordActionLatency(actions[choice], startTicks);
     }
-    free(upcomingTasks);
-    free(currentDate);
 }
 
 void boardsMenu(User* user) {
+    CommandContext context = { user, NULL, NULL };
     int choice;
     do {
+        beginFrame();
+        printLogo();
         showUpcomingTasks(user);
-        printf("1. View Boards\n2. Create Board\n3. Delete Board\n4. Exit\nChoose an option: ");
-        choice = atoi(dynamicInput());
+        screenPrintf("1. View Boards\n2. Create Board\n3. Delete Board\n4. Exit\n");
+        presentFrame();
+        printf("Choose an option or type a command ('help' lists them): ");
+        choice = readMenuChoice(&context);
+        if (choice == -1) {
+            choice = 4; // End of input
+        }
 
+        long long actionStart = statsClock();
         switch (choice) {
+            case 0:
+                break; // A command was run instead
             case 1:
-                clearScreen();
+                beginFrame();
+                printLogo();
                 displayBoards(user);
+                presentFrame();
                 Board* selectedBoard = selectBoard(user);
+                recordMenuAction(boardsMenuActions, MENU_ACTION_COUNT(boardsMenuActions), choice, actionStart);
                 if (selectedBoard) {
-                    clearScreen();
                     listsMenu(user, selectedBoard);
                 }
                 break;
             case 2:
                 clearScreen();
                 createBoard(user);
-                clearScreen();
                 break;
             case 3:
                 clearScreen();
                 deleteBoard(user);
-                clearScreen();
                 break;
             case 4:
                 printf("Exiting to main menu.\n");
-                clearScreen();
                 break;
             default:
                 printf("Invalid option. Please try again.\n");
-                clearScreen();
                 break;
         }
+        if (choice != 0) {
+            TRACE_MENU_END(actionStart, "boardsMenu", choice);
+        }
+        if (choice != 1) {
+            recordMenuAction(boardsMenuActions, MENU_ACTION_COUNT(boardsMenuActions), choice, actionStart);
+        }
     } while (choice != 4);
 }
 
 void displayLists(const Board* board) {
-    printf("Available Lists on Board '%s':\n", board->name);
+    screenPrintf("Available Lists on Board '%s':\n", board->name);
     const List* currentList = board->lists;
     int listCount = 0;
     while (currentList != NULL) {
-        printf("%d. %s\n", ++listCount, currentList->name);
+        screenPrintf("%d. %s (#%ld)\n", ++listCount, currentList->name, currentList->id);
         currentList = currentList->next;
     }
     if (listCount == 0) {
-        printf("No lists available.\n");
+        screenPrintf("No lists available.\n");
     }
 }
 
 List* selectList(Board* board) {
-    printf("Enter the number of the list to select, or 0 to go back: ");
-    int choice = atoi(dynamicInput());
+    printf("Enter the number, name or #ID of the list to select, or 0 to go back: ");
+    const char* key = readSelectionKey();
+    List* selected = key != NULL ? findList(board, key) : NULL;
+    return selected; // NULL when nothing or an unknown list was chosen
+}
+
+// Resolves a list by its 1-based position, by "#ID" or by its name
+List* findList(Board* board, const char* key) {
+    char* end;
+    if (key[0] == '#') {
+        List* list = findListById(strtol(key + 1, &end, 10));
+        return list != NULL && *end == '\0' && list->board == board ? list : NULL;
+    }
+    long position = strtol(key, &end, 10);
+    if (*key == '\0' || *end != '\0') {
+        return findListByName(board, key);
+    }
     int listIndex = 1;
-    List* currentList = board->lists;
-    while (currentList != NULL) {
-        if (listIndex == choice) {
-            return currentList; // Return the selected list
+    for (List* list = board->lists; list != NULL; list = list->next, listIndex++) {
+        if (listIndex == position) {
+            return list;
         }
-        listIndex++;
-        currentList = currentList->next;
     }
-    clearScreen();
-    return NULL; // No list selected or invalid choice
+    return NULL;
+}
+
+static List* linkNewList(Board* board, const char* name, long id) {
+    List* newList = malloc(sizeof(List));
+    if (newList != NULL) {
+        newList->name = NULL;
+    }
+    if (newList == NULL || !storeString(&stringPool, &newList->name, newList->nameStorage, LIST_NAME_INLINE, name)) {
+        printf("Failed to allocate memory for new list.\n");
+        free(newList);
+        return NULL;
+    }
+    // Prepend the new list
+    newList->tasks = NULL;
+    newList->newestChange = 0;
+    memset(&newList->counts, 0, sizeof(TaskCounts));
+    initTaskOrder(newList);
+    newList->next = board->lists;
+    newList->id = id;
+    newList->board = board;
+    board->lists = newList;
+    indexList(newList);
+    touchList(newList);
+    return newList;
+}
+
+List* createListWithArgs(Board* board, const char* name) {
+    return linkNewList(board, name, generateUniqueId());
 }
 
 void createList(Board* board) {
     printf("Enter the name of the new list: ");
     char* listName = dynamicInput();
     if (listName != NULL && listName[0] != '\0') {
-        // Create and prepend the new list
-        List* newList = malloc(sizeof(List));
-        newList->name = listName;
-        newList->tasks = NULL;
-        newList->next = board->lists; 
-        newList->id = generateUniqueId();
-        board->lists = newList;
-        printf("List '%s' created successfully.\n", listName);
+        if (createListWithArgs(board, listName)) {
+            printf("List '%s' created successfully.\n", listName);
+        }
     } else {
         printf("List creation cancelled.\n");
-        free(listName); // Free the input if the user entered an empty name
     }
+    free(listName);
+}
+
+// Unlinks the list from the board and frees it with all of its tasks
+void deleteListWithArgs(Board* board, List* list) {
+    List** link = &board->lists;
+    while (*link != NULL && *link != list) {
+        link = &(*link)->next;
+    }
+    if (*link == NULL) {
+        return;
+    }
+    *link = list->next; // Bypass the list
+    list->next = NULL;
+    unindexList(list);
+    uncountList(list);
+    recordListDeletion(list);
+    freeLists(list);
 }
 
 void deleteList(Board* board) {
     displayLists(board); // Show all lists
-    printf("Enter the number of the list to delete, or 0 to cancel: ");
-    int choice = atoi(dynamicInput());
-    int listIndex = 1;
-    List* currentList = board->lists;
-    List* prevList = NULL;
-    while (currentList != NULL) {
-        if (listIndex == choice) {
-            // Found the list to delete
-            if (prevList == NULL) {
-                board->lists = currentList->next; // List is the head of the board
-            } else {
-                prevList->next = currentList->next; // Bypass the current list
-            }
-            // Delete all tasks in the list
-            while (currentList->tasks != NULL) {
-                Task* taskToDelete = currentList->tasks;
-                currentList->tasks = taskToDelete->next;
-                free(taskToDelete->name);
-                free(taskToDelete->priority);
-                free(taskToDelete->date);
-                free(taskToDelete);
-            }
-            free(currentList->name);
-            free(currentList);
-            printf("List deleted successfully.\n");
-            return;
-        }
-        prevList = currentList;
-        currentList = currentList->next;
-        listIndex++;
+    printf("Enter the number, name or #ID of the list to delete, or 0 to cancel: ");
+    const char* key = readSelectionKey();
+    if (key == NULL) {
+        return;
     }
-    if (choice != 0) {
+    List* selected = findList(board, key);
+    if (selected == NULL) {
         printf("List not found.\n");
+        return;
     }
+    deleteListWithArgs(board, selected);
+    printf("List deleted successfully.\n");
 }
 
 void listsMenu(User* user, Board* board) {
+    CommandContext context = { user, board, NULL };
     int choice;
     do {
-        printf("1. View Lists\n2. Create List\n3. Delete List\n4. Exit\nChoose an option: ");
-        choice = atoi(dynamicInput());
+        beginFrame();
+        printLogo();
+        screenPrintf("1. View Lists\n2. Create List\n3. Delete List\n4. Exit\n");
+        presentFrame();
+        printf("Choose an option or type a command: ");
+        choice = readMenuChoice(&context);
+        if (choice == -1) {
+            choice = 4; // End of input
+        }
 
+        long long actionStart = statsClock();
         switch (choice) {
+            case 0:
+                break; // A command was run instead
             case 1: {
-                clearScreen();
+                beginFrame();
+                printLogo();
                 displayLists(board);
+                presentFrame();
                 List* selectedList = selectList(board);
+                recordMenuAction(listsMenuActions, MENU_ACTION_COUNT(listsMenuActions), choice, actionStart);
                 if (selectedList) {
-                    clearScreen();
                     tasksMenu(user, board, selectedList);
                 }
                 break;
@@ -982,30 +2142,51 @@ void listsMenu(User* user, Board* board) {
             case 2:
                 clearScreen();
                 createList(board);
-                clearScreen();
                 break;
             case 3:
                 clearScreen();
                 deleteList(board);
-                clearScreen();
                 break;
             case 4:
                 printf("Exiting to board menu.\n");
-                clearScreen();
                 break;
             default:
                 printf("Invalid option. Please try again.\n");
-                clearScreen();
                 break;
         }
+        if (choice != 0) {
+            TRACE_MENU_END(actionStart, "listsMenu", choice);
+        }
+        if (choice != 1) {
+            recordMenuAction(listsMenuActions, MENU_ACTION_COUNT(listsMenuActions), choice, actionStart);
+        }
     } while (choice != 4);
 }
 
-int isValidDate(char* date) {
-    int yyyy, mm, dd;
-    if (sscanf(date, "%4d-%2d-%2d", &yyyy, &mm, &dd) != 3) {
-        return 0; // Incorrect format
+// The one date parser: reads "YYYY-MM-DD", also accepting one-digit months and days, and
+// returns 0 unless the text is a real calendar date. Runs for every task on load and sort, so
+// the digits are read directly rather than with sscanf.
+int parseDate(const char* text, int* year, int* month, int* day) {
+    int parts[3];
+    for (int i = 0; i < 3; i++) {
+        int digits = 0;
+        int value = 0;
+        while (*text >= '0' && *text <= '9' && digits < (i == 0 ? 4 : 2)) {
+            value = value * 10 + (*text++ - '0');
+            digits++;
+        }
+        if (i == 0 ? digits != 4 : digits == 0) {
+            return 0; // Incorrect format
+        }
+        parts[i] = value;
+        if (i < 2 && *text++ != '-') {
+            return 0;
+        }
     }
+    if (*text != '\0') {
+        return 0;
+    }
+    int yyyy = parts[0], mm = parts[1], dd = parts[2];
     if (yyyy < 1000 || yyyy > 9999 || mm < 1 || mm > 12 || dd < 1 || dd > 31) {
         return 0; // Invalid date
     }
@@ -1018,37 +2199,278 @@ int isValidDate(char* date) {
             return 0; // February has 28 days (29 in a leap year)
         }
     }
+    *year = yyyy;
+    *month = mm;
+    *day = dd;
     return 1; // Valid date
 }
 
-void displayTasks(const List* list) {
-    printf("Tasks in List '%s':\n", list->name);
+int isValidDate(char* date) {
+    int year, month, day;
+    return parseDate(date, &year, &month, &day);
+}
+
+// Writes a valid date as zero-padded "YYYY-MM-DD" (11 bytes), the only form that is stored, so
+// dates compare as text; returns 0 if text is not a date
+int normalizeDate(const char* text, char* date) {
+    int year, month, day;
+    if (!parseDate(text, &year, &month, &day)) {
+        return 0;
+    }
+    snprintf(date, 11, "%04d-%02d-%02d", year, month, day);
+    return 1;
+}
+
+void displayTasks(const List* list) {
+    screenPrintf("Tasks in List '%s':\n", list->name);
     const Task* currentTask = list->tasks;
     int taskCount = 0;
     while (currentTask != NULL) {
-        printf("%d. %s - Priority: %s, Deadline: %s\n", ++taskCount, currentTask->name, currentTask->priority, currentTask->date);
+        screenPrintf("%d. %s (#%ld) - Priority: %s, Deadline: %s\n", ++taskCount, currentTask->name, currentTask->id, currentTask->priority, currentTask->date);
         currentTask = currentTask->next;
     }
     if (taskCount == 0) {
-        printf("No tasks available.\n");
+        screenPrintf("No tasks available.\n");
+    }
+}
+
+// Shows the page of tasks the viewport is on, sized to the window when there is a console to
+// size it by. Numbers are positions in the whole list, so they can be typed on any page, and the
+// page is found through the list's positional index: drawing it costs the page, not the list.
+void displayTaskView(List* list) {
+    int total = (int)list->counts.total;
+    int screen = screenRows();
+    int rows = screen > 0 ? screen - TASKS_MENU_ROWS : TASK_PAGE_SIZE;
+    if (rows < MIN_TASK_VIEW_ROWS) {
+        rows = MIN_TASK_VIEW_ROWS; // Taller than the window, so printed rather than drawn
+    }
+    int first = placeViewport(total, rows);
+    if (total <= rows) {
+        displayTasks(list);
+        return;
+    }
+    int last = first + rows < total ? first + rows : total;
+    screenPrintf("Tasks in List '%s' (page %d of %d, %d-%d of %d; next, prev, page N):\n", list->name,
+                 first / rows + 1, (total + rows - 1) / rows, first + 1, last, total);
+    const Task* currentTask = taskAtPosition(list, first);
+    for (int number = first + 1; currentTask != NULL && number <= last; currentTask = currentTask->next) {
+        screenPrintf("%d. %s (#%ld) - Priority: %s, Deadline: %s\n", number++, currentTask->name, currentTask->id, currentTask->priority, currentTask->date);
     }
 }
 
 Task* selectTask(List* list) {
-    displayTasks(list); // Show all tasks
-    printf("Enter the number of the task to select, or 0 to go back: ");
-    int choice = atoi(dynamicInput());
-    int taskIndex = 1;
-    Task* currentTask = list->tasks;
-    while (currentTask != NULL) {
-        if (taskIndex == choice) {
-            return currentTask; // Return the selected task
+    displayTaskView(list);
+    printf("Enter the number, name or #ID of the task to select, or 0 to go back: ");
+    const char* key = readSelectionKey();
+    Task* selected = key != NULL ? findTask(list, key) : NULL;
+    return selected; // NULL when nothing or an unknown task was chosen
+}
+
+// Resolves a task by its 1-based position, by "#ID" or by its name
+Task* findTask(List* list, const char* key) {
+    char* end;
+    if (key[0] == '#') {
+        Task* task = findTaskById(strtol(key + 1, &end, 10));
+        return task != NULL && *end == '\0' && task->list == list ? task : NULL;
+    }
+    long position = strtol(key, &end, 10);
+    if (*key != '\0' && *end == '\0') {
+        return taskAtPosition(list, position - 1);
+    }
+    for (Task* task = list->tasks; task != NULL; task = task->next) {
+        if (strcmp(task->name, key) == 0) {
+            return task;
         }
-        taskIndex++;
-        currentTask = currentTask->next;
     }
-    clearScreen();
-    return NULL; // No task selected or invalid choice
+    return NULL;
+}
+
+// Gives the task a key between its new neighbours' keys; NULL stands for an end of the list
+static int setTaskPosition(Task* task, const char* before, const char* after) {
+    char* key = positionBetween(before, after);
+    if (key == NULL) {
+        return 0;
+    }
+    int ok = storeString(&stringPool, &task->position, task->positionStorage, POSITION_INLINE, key);
+    free(key);
+    return ok;
+}
+
+// Gives every task of the list a fresh key in its current order
+static void renumberTaskPositions(List* list) {
+    char key[POSITION_INTEGER_SIZE] = "";
+    for (Task* task = list->tasks; task != NULL; task = task->next) {
+        if (!nextPosition(key) ||
+            !storeString(&stringPool, &task->position, task->positionStorage, POSITION_INLINE, key)) {
+            fprintf(stderr, "Unable to store the task positions of list '%s'.\n", list->name);
+            return;
+        }
+        touchTask(task);
+    }
+}
+
+// A task with the given fields that is not linked anywhere yet; a NULL position is made up
+// to put the task at the head of list
+static Task* allocateTask(List* list, const char* name, const char* priority, const char* date, const char* position) {
+    Task* newTask = malloc(sizeof(Task));
+    if (newTask == NULL) {
+        printf("Failed to allocate memory for new task.\n");
+        return NULL;
+    }
+    newTask->name = newTask->priority = newTask->date = newTask->position = NULL;
+    newTask->reminder = NULL;
+    char padded[DATE_INLINE];
+    if (normalizeDate(date, padded)) {
+        date = padded;
+    }
+    if (!storeString(&stringPool, &newTask->name, newTask->nameStorage, TASK_NAME_INLINE, name) ||
+        !storeString(&stringPool, &newTask->priority, newTask->priorityStorage, PRIORITY_INLINE, priority) ||
+        !storeString(&stringPool, &newTask->date, newTask->dateStorage, DATE_INLINE, date) ||
+        !(position != NULL
+              ? storeString(&stringPool, &newTask->position, newTask->positionStorage, POSITION_INLINE, position)
+              : setTaskPosition(newTask, NULL, list->tasks ? list->tasks->position : NULL))) {
+        printf("Failed to allocate memory for new task.\n");
+        releaseString(newTask->name, newTask->nameStorage);
+        releaseString(newTask->priority, newTask->priorityStorage);
+        releaseString(newTask->date, newTask->dateStorage);
+        releaseString(newTask->position, newTask->positionStorage);
+        free(newTask);
+        return NULL;
+    }
+    return newTask;
+}
+
+Task* addTaskWithArgs(List* list, const char* name, const char* priority, const char* date) {
+    Task* newTask = allocateTask(list, name, priority, date, NULL);
+    if (newTask == NULL) {
+        return NULL;
+    }
+    // Prepend the new task
+    newTask->next = list->tasks;
+    newTask->id = generateUniqueId();
+    newTask->list = list;
+    list->tasks = newTask;
+    taskOrderChanged(list);
+    indexTask(newTask);
+    countTask(newTask);
+    scheduleReminder(newTask);
+    touchTask(newTask);
+    return newTask;
+}
+
+// Replaces the fields that are not NULL; returns 0 if the new deadline is not a valid date
+int editTaskWithArgs(Task* task, const char* name, const char* priority, const char* date) {
+    if (date != NULL && !isValidDate((char*)date)) {
+        return 0;
+    }
+    int recount = task->list != NULL && (priority != NULL || date != NULL);
+    if (recount) {
+        uncountTask(task);
+    }
+    int stored = 1;
+    if (name != NULL) {
+        stored = storeString(&stringPool, &task->name, task->nameStorage, TASK_NAME_INLINE, name);
+    }
+    if (stored && priority != NULL) {
+        stored = storeString(&stringPool, &task->priority, task->priorityStorage, PRIORITY_INLINE, priority);
+    }
+    if (stored && date != NULL) {
+        char padded[DATE_INLINE];
+        normalizeDate(date, padded); // Checked above
+        stored = storeString(&stringPool, &task->date, task->dateStorage, DATE_INLINE, padded);
+    }
+    if (recount) {
+        countTask(task); // A field that failed to store keeps its old value
+    }
+    if (!stored) {
+        return 0;
+    }
+    if (date != NULL) {
+        scheduleReminder(task);
+    }
+    if (task->list != NULL) {
+        touchTask(task);
+    }
+    return 1;
+}
+
+// Unlinks the task from the list and frees it
+void deleteTaskWithArgs(List* list, Task* task) {
+    Task** link = &list->tasks;
+    while (*link != NULL && *link != task) {
+        link = &(*link)->next;
+    }
+    if (*link == NULL) {
+        return;
+    }
+    *link = task->next; // Bypass the task
+    task->next = NULL;
+    taskOrderChanged(list);
+    unindexTask(task);
+    uncountTask(task);
+    recordTaskDeletion(task);
+    freeTasks(task);
+}
+
+// Moves the task to the head of the target list
+void moveTaskWithArgs(List* currentList, Task* task, List* targetList) {
+    if (currentList == targetList) {
+        return;
+    }
+    Task** link = &currentList->tasks;
+    while (*link != NULL && *link != task) {
+        link = &(*link)->next;
+    }
+    if (*link == NULL) {
+        return;
+    }
+    *link = task->next; // Remove the task from the current list
+    uncountTask(task);
+    task->next = targetList->tasks;
+    task->list = targetList;
+    targetList->tasks = task;
+    taskOrderChanged(currentList);
+    taskOrderChanged(targetList);
+    countTask(task);
+    if (!setTaskPosition(task, NULL, task->next ? task->next->position : NULL)) {
+        renumberTaskPositions(targetList);
+    }
+    touchTask(task);
+}
+
+// Moves the task to the given 1-based position within its list; only the task's key changes.
+// Returns 0 if the position is outside the list.
+int reorderTaskWithArgs(List* list, Task* task, int position) {
+    int taskCount = 0;
+    for (Task* current = list->tasks; current != NULL; current = current->next) {
+        taskCount++;
+    }
+    if (position < 1 || position > taskCount) {
+        return 0;
+    }
+    Task** link = &list->tasks;
+    while (*link != NULL && *link != task) {
+        link = &(*link)->next;
+    }
+    if (*link == NULL) {
+        return 0;
+    }
+    *link = task->next; // Unlink, then find the gap the task goes into
+
+    Task* previous = NULL;
+    link = &list->tasks;
+    for (int i = 1; i < position; i++) {
+        previous = *link;
+        link = &(*link)->next;
+    }
+    task->next = *link;
+    *link = task;
+    taskOrderChanged(list);
+    if (!setTaskPosition(task, previous ? previous->position : NULL, task->next ? task->next->position : NULL)) {
+        renumberTaskPositions(list);
+    }
+    touchTask(task);
+    return 1;
 }
 
 void addTask(List* list) {
@@ -1079,16 +2501,12 @@ void addTask(List* list) {
         }
     } while (!isValidDate(deadline));
 
-    // Create and prepend the new task
-    Task* newTask = malloc(sizeof(Task));
-    newTask->name = taskName;
-    newTask->priority = priority;
-    newTask->date = deadline;
-    newTask->next = list->tasks;
-    newTask->id = generateUniqueId();
-    list->tasks = newTask;
-
-    printf("Task '%s' added successfully.\n", taskName);
+    if (addTaskWithArgs(list, taskName, priority, deadline)) {
+        printf("Task '%s' added successfully.\n", taskName);
+    }
+    free(taskName);
+    free(priority);
+    free(deadline);
 }
 
 void editTask(List* list) {
@@ -1099,22 +2517,24 @@ void editTask(List* list) {
         printf("Enter the new name of the task or 'exit' to keep current: ");
         char* newName = dynamicInput();
         if (newName != NULL && strcmp(newName, "exit") != 0 && newName[0] != '\0') {
-            free(selectedTask->name);
-            selectedTask->name = newName;
-            printf("Task name updated successfully.\n");
-        } else {
-            free(newName); // No change made, free the input
+            if (editTaskWithArgs(selectedTask, newName, NULL, NULL)) {
+                printf("Task name updated successfully.\n");
+            } else {
+                printf("Unable to update the task name.\n");
+            }
         }
+        free(newName);
 
         printf("Enter the new priority (low, medium, high) or 'exit' to keep current: ");
         char* newPriority = dynamicInput();
         if (newPriority != NULL && strcmp(newPriority, "exit") != 0 && newPriority[0] != '\0') {
-            free(selectedTask->priority);
-            selectedTask->priority = newPriority;
-            printf("Task priority updated successfully.\n");
-        } else {
-            free(newPriority); // No change made, free the input
+            if (editTaskWithArgs(selectedTask, NULL, newPriority, NULL)) {
+                printf("Task priority updated successfully.\n");
+            } else {
+                printf("Unable to update the task priority.\n");
+            }
         }
+        free(newPriority);
 
         char* newDeadline;
         do {
@@ -1128,73 +2548,42 @@ void editTask(List* list) {
         } while (1);
 
         if (newDeadline != NULL && strcmp(newDeadline, "exit") != 0 && newDeadline[0] != '\0') {
-            free(selectedTask->date);
-            selectedTask->date = newDeadline;
-            printf("Task deadline updated successfully.\n");
-        } else {
-            free(newDeadline); // No change made, free the input
+            if (editTaskWithArgs(selectedTask, NULL, NULL, newDeadline)) {
+                printf("Task deadline updated successfully.\n");
+            } else {
+                printf("Unable to update the task deadline.\n");
+            }
         }
+        free(newDeadline);
     } else {
         printf("Task editing cancelled.\n");
     }
 }
 
 void deleteTask(List* list) {
-    displayTasks(list); // Show all tasks
-    printf("Enter the number of the task to delete, or 0 to cancel: ");
-    int choice = atoi(dynamicInput());
-    int taskIndex = 1;
-    Task* currentTask = list->tasks;
-    Task* prevTask = NULL;
-    while (currentTask != NULL) {
-        if (taskIndex == choice) {
-            // Found the task to delete
-            if (prevTask == NULL) {
-                list->tasks = currentTask->next; // Task is the head of the list
-            } else {
-                prevTask->next = currentTask->next; // Bypass the current task
-            }
-            free(currentTask->name);
-            free(currentTask->priority);
-            free(currentTask->date);
-            free(currentTask);
-            printf("Task deleted successfully.\n");
-            return;
-        }
-        prevTask = currentTask;
-        currentTask = currentTask->next;
-        taskIndex++;
+    displayTaskView(list);
+    printf("Enter the number, name or #ID of the task to delete, or 0 to cancel: ");
+    const char* key = readSelectionKey();
+    if (key == NULL) {
+        return;
     }
-    if (choice != 0) {
+    Task* selected = findTask(list, key);
+    if (selected == NULL) {
         printf("Task not found.\n");
+        return;
     }
+    deleteTaskWithArgs(list, selected);
+    printf("Task deleted successfully.\n");
 }
 
 void moveTask(Board* board, List* currentList) {
     Task* selectedTask = selectTask(currentList);
     if (selectedTask) {
-        printf("Select the destination list number or '0' to cancel: ");
+        printf("Select the destination list or '0' to cancel: ");
         displayLists(board);
         List* targetList = selectList(board);
         if (targetList && targetList != currentList) {
-            // Remove the task from the current list
-            if (currentList->tasks == selectedTask) {
-                // The task to move is the first task in the current list
-                currentList->tasks = selectedTask->next;
-            } else {
-                // Find the task before the selected task
-                Task* prevTask = currentList->tasks;
-                while (prevTask && prevTask->next != selectedTask) {
-                    prevTask = prevTask->next;
-                }
-                if (prevTask) {
-                    prevTask->next = selectedTask->next;
-                }
-            }
-            // Add the task to the target list
-            selectedTask->next = targetList->tasks;
-            targetList->tasks = selectedTask;
-
+            moveTaskWithArgs(currentList, selectedTask, targetList);
             printf("Task '%s' moved to list '%s'.\n", selectedTask->name, targetList->name);
         } else {
             printf("Task move cancelled.\n");
@@ -1202,32 +2591,786 @@ void moveTask(Board* board, List* currentList) {
     }
 }
 
-// Comparison function for sorting tasks by priority
-int compareTasksByPriority(const void* a, const void* b) {
-    const Task* taskA = *(const Task**)a;
-    const Task* taskB = *(const Task**)b;
-    const char* priorities[] = { "low", "medium", "high" };
+int taskMatchesFilter(const Task* task, const TaskFilter* filter) {
+    if (filter->priority != NULL && strcmp(task->priority, filter->priority) != 0) {
+        return 0;
+    }
+    if (filter->fromDate != NULL && strcmp(task->date, filter->fromDate) < 0) {
+        return 0;
+    }
+    if (filter->toDate != NULL && strcmp(task->date, filter->toDate) > 0) {
+        return 0;
+    }
+    if (filter->nameMatch != NULL && strstr(task->name, filter->nameMatch) == NULL) {
+        return 0;
+    }
+    return 1;
+}
 
-    int priorityA = 0, priorityB = 0;
-    for (int i = 0; i < 3; i++) {
-        if (strcmp(taskA->priority, priorities[i]) == 0) priorityA = i;
-        if (strcmp(taskB->priority, priorities[i]) == 0) priorityB = i;
+// Unlinks every matching task in one pass and returns them as a chain in their original order
+static Task* detachMatchingTasks(List* list, const TaskFilter* filter, int* count) {
+    Task* detached = NULL;
+    Task** detachedTail = &detached;
+    Task** link = &list->tasks;
+    while (*link != NULL) {
+        Task* task = *link;
+        if (taskMatchesFilter(task, filter)) {
+            *link = task->next; // Bypass the matching task
+            task->next = NULL;
+            *detachedTail = task;
+            detachedTail = &task->next;
+            (*count)++;
+        } else {
+            link = &task->next;
+        }
+    }
+    if (detached != NULL) {
+        taskOrderChanged(list);
+    }
+    return detached;
+}
+
+int bulkDeleteTasks(List* list, const TaskFilter* filter) {
+    int count = 0;
+    Task* deleted = detachMatchingTasks(list, filter, &count);
+    for (Task* task = deleted; task != NULL; task = task->next) {
+        unindexTask(task);
+        uncountTask(task);
+        recordTaskDeletion(task);
+    }
+    freeTasks(deleted);
+    return count;
+}
+
+// Gives a chain of tasks keys that keep their order and sort ahead of after, working backwards
+// from after so the keys at the front of a list stay short
+static int positionTasksBefore(Task* chain, int count, const char* after) {
+    Task** tasks = malloc(count * sizeof(Task*));
+    if (tasks == NULL) {
+        return 0;
+    }
+    int i = 0;
+    for (Task* task = chain; i < count; task = task->next) {
+        tasks[i++] = task;
     }
+    for (i = count - 1; i >= 0; i--) {
+        if (!setTaskPosition(tasks[i], NULL, after)) {
+            break;
+        }
+        after = tasks[i]->position;
+    }
+    free(tasks);
+    return i < 0;
+}
 
-    return priorityB - priorityA; // Descending order
+// Moves matching tasks to the head of the target list, keeping their relative order
+int bulkMoveTasks(List* list, List* targetList, const TaskFilter* filter) {
+    if (list == targetList) {
+        return 0;
+    }
+    int count = 0;
+    Task* moved = detachMatchingTasks(list, filter, &count);
+    if (moved != NULL) {
+        Task* last = moved;
+        for (Task* task = moved; task != NULL; task = task->next) {
+            uncountTask(task);
+            task->list = targetList;
+            countTask(task);
+            touchTask(task);
+            last = task;
+        }
+        last->next = targetList->tasks;
+        targetList->tasks = moved;
+        taskOrderChanged(targetList);
+        if (!positionTasksBefore(moved, count, last->next ? last->next->position : NULL)) {
+            renumberTaskPositions(targetList);
+        }
+    }
+    return count;
 }
 
-// Comparison function for sorting tasks by date
-int compareTasksByDate(const void* a, const void* b) {
-    const Task* taskA = *(const Task**)a;
-    const Task* taskB = *(const Task**)b;
+int bulkSetPriority(List* list, const TaskFilter* filter, const char* priority) {
+    int count = 0;
+    for (Task* task = list->tasks; task != NULL; task = task->next) {
+        if (taskMatchesFilter(task, filter) && strcmp(task->priority, priority) != 0) {
+            uncountTask(task);
+            int stored = storeString(&stringPool, &task->priority, task->priorityStorage, PRIORITY_INLINE, priority);
+            countTask(task);
+            touchTask(task);
+            if (!stored) {
+                break;
+            }
+            count++;
+        }
+    }
+    return count;
+}
 
-    // Assuming date is in "YYYY-MM-DD" format, lexicographical comparison is sufficient
-    return strcmp(taskA->date, taskB->date); // Ascending order
+// Links the task into the list where its key belongs, before any task with the same key;
+// returns the task before it
+static Task* linkTaskByPosition(List* list, Task* task) {
+    Task* previous = NULL;
+    Task** link = &list->tasks;
+    while (*link != NULL && strcmp((*link)->position, task->position) < 0) {
+        previous = *link;
+        link = &(*link)->next;
+    }
+    task->next = *link;
+    task->list = list;
+    *link = task;
+    taskOrderChanged(list);
+    return previous;
 }
 
-// Function to sort tasks in a list based on the given comparison function
-void sortTasks(List* list, int (*compFunc)(const void*, const void*)) {
+// Links the task into the list where its key belongs, with a new key if that one is taken
+static void insertTaskByPosition(List* list, Task* task) {
+    Task* previous = linkTaskByPosition(list, task);
+    if (!isValidPosition(task->position) || (task->next != NULL && strcmp(task->next->position, task->position) == 0)) {
+        if (!setTaskPosition(task, previous ? previous->position : NULL, task->next ? task->next->position : NULL)) {
+            renumberTaskPositions(list);
+        }
+    }
+}
+
+// Wraps an unlinked task for the archive; returns 0 if there is no memory for it
+static int addToArchive(List* list, Task* task) {
+    ArchivedTask* archived = malloc(sizeof(ArchivedTask));
+    if (archived == NULL) {
+        perror("Memory allocation failed for archived task");
+        return 0;
+    }
+    unindexTask(task);
+    uncountTask(task);
+    cancelReminder(task);
+    recordTaskDeletion(task);
+    archived->task = task;
+    archived->listId = list->id;
+    archived->owner = list->board->user;
+    archived->saved = 0;
+    archived->next = archivedTasks;
+    archivedTasks = archived;
+    task->next = NULL;
+    task->list = NULL;
+    return 1;
+}
+
+// Takes the task out of the working set; it is written to archive.csv by the next save
+int archiveTaskWithArgs(List* list, Task* task) {
+    Task** link = &list->tasks;
+    while (*link != NULL && *link != task) {
+        link = &(*link)->next;
+    }
+    if (*link == NULL) {
+        return 0;
+    }
+    *link = task->next;
+    taskOrderChanged(list);
+    if (!addToArchive(list, task)) {
+        insertTaskByPosition(list, task);
+        return 0;
+    }
+    return 1;
+}
+
+// Archives the user's tasks whose deadline passed more than days days ago; returns how many
+int archiveTasksOlderThan(User* user, int days) {
+    time_t cutoff = time(NULL) - (time_t)(days + 1) * 24 * 60 * 60;
+    char lastDate[11]; // Latest deadline that is old enough
+    strftime(lastDate, sizeof(lastDate), "%Y-%m-%d", localtime(&cutoff));
+    TaskFilter filter = { NULL, NULL, lastDate, NULL };
+
+    int archivedCount = 0;
+    for (Board* board = user->boards; board != NULL; board = board->next) {
+        for (List* list = board->lists; list != NULL; list = list->next) {
+            int count = 0;
+            Task* task = detachMatchingTasks(list, &filter, &count);
+            while (task != NULL) {
+                Task* next = task->next;
+                if (addToArchive(list, task)) {
+                    archivedCount++;
+                } else {
+                    insertTaskByPosition(list, task);
+                }
+                task = next;
+            }
+        }
+    }
+    return archivedCount;
+}
+
+// Reads archive.csv into memory, in front of the tasks archived this session; returns 0 if
+// the file exists but could not be read
+static int loadArchive() {
+    if (archiveLoaded) {
+        return 1;
+    }
+    FILE* fp = fopen("archive.csv", "rb");
+    if (fp == NULL) {
+        archiveLoaded = 1; // Nothing has been archived yet
+        return 1;
+    }
+    fclose(fp);
+
+    TRACE_BEGIN(spanStart);
+    DataFile file = { "archive.csv", "archive", loadArchivedTasks };
+    file.pool = createThreadPool(getCoreCount());
+    submitJob(file.pool, loadDataFileJob, &file);
+    waitForJobs(file.pool);
+    destroyThreadPool(file.pool);
+    if (file.data == NULL) {
+        releaseDataFile(&file);
+        return 0;
+    }
+    retainBorrowedStrings(&file);
+    if (loadFailed(&file)) {
+        // archive.csv is rewritten from what is in memory, so part of it must not be kept
+        for (int c = 0; c < file.chunkCount; c++) {
+            ArchiveRecord* records = (ArchiveRecord*)file.chunks[c].records;
+            for (size_t i = 0; i < file.chunks[c].recordCount; i++) {
+                freeTasks(records[i].task);
+            }
+        }
+        releaseDataFile(&file);
+        return 0;
+    }
+
+    long maxId = 0;
+    ArchivedTask* loaded = NULL;
+    ArchivedTask** tail = &loaded;
+    for (int c = 0; c < file.chunkCount; c++) {
+        ArchiveRecord* records = (ArchiveRecord*)file.chunks[c].records;
+        for (size_t i = 0; i < file.chunks[c].recordCount; i++) {
+            User* owner = findUserByName(records[i].username);
+            ArchivedTask* archived = owner != NULL ? malloc(sizeof(ArchivedTask)) : NULL;
+            if (archived == NULL) {
+                fprintf(stderr, "Skipping archived task '%s': user '%s' not found.\n", records[i].task->name, records[i].username);
+                freeTasks(records[i].task);
+                continue;
+            }
+            archived->task = records[i].task;
+            archived->listId = records[i].listId;
+            archived->owner = owner;
+            archived->saved = 1;
+            archived->next = NULL;
+            *tail = archived;
+            tail = &archived->next;
+        }
+        if (file.chunks[c].maxId > maxId) {
+            maxId = file.chunks[c].maxId;
+        }
+    }
+    *tail = archivedTasks;
+    archivedTasks = loaded;
+    seedUniqueId(maxId); // New tasks must not take the ID of an archived one
+    if (maxId > archiveMaxId) {
+        archiveMaxId = maxId;
+    }
+    releaseDataFile(&file);
+    archiveLoaded = 1;
+    TRACE_END(spanStart, "loadArchive");
+    return 1;
+}
+
+static void writeArchivedTask(DataWriter* writer, const ArchivedTask* archived) {
+    const Task* task = archived->task;
+    writeIdField(writer, task->id);
+    writeField(writer, task->name);
+    writeField(writer, task->priority);
+    writeField(writer, task->date);
+    writeIdField(writer, archived->listId);
+    writeField(writer, task->position);
+    writeField(writer, archived->owner->username);
+    endRecord(writer);
+    if (task->id > archiveMaxId) {
+        archiveMaxId = task->id;
+    }
+}
+
+// Every write of archive.csv ends with a record of the largest task ID ever archived. It is
+// stored as plain text even in a compressed file, so startup can read it from the last bytes.
+static void writeArchiveMaxId(DataWriter* writer) {
+    flushDataWriter(writer);
+    writeField(writer, ARCHIVE_MAX_ID);
+    writeIdField(writer, archiveMaxId);
+    endRecord(writer);
+    if (writer->compressed) {
+        if (!writeStoredBlock(writer->fp, writer->buffer, writer->length)) {
+            writer->failed = 1;
+        }
+        writer->length = 0;
+    }
+}
+
+// Seeds IDs from the record at the end of archive.csv, so that new tasks do not take the ID of
+// an archived one while the archive itself is not loaded
+static void seedArchivedIds() {
+    FILE* fp = fopen("archive.csv", "rb");
+    if (fp == NULL) {
+        return;
+    }
+    char tail[64];
+    fseek(fp, 0, SEEK_END);
+    long size = ftell(fp);
+    fseek(fp, size > (long)sizeof(tail) ? size - (long)sizeof(tail) : 0, SEEK_SET);
+    size_t length = fread(tail, 1, sizeof(tail) - 1, fp);
+    fclose(fp);
+    tail[length] = '\0';
+    const char marker[] = "\"" ARCHIVE_MAX_ID "\",\"";
+    size_t markerLength = sizeof(marker) - 1;
+    for (size_t i = length >= markerLength ? length - markerLength + 1 : 0; i-- > 0;) {
+        if (memcmp(tail + i, marker, markerLength) == 0) {
+            archiveMaxId = strtol(tail + i + markerLength, NULL, 10);
+            seedUniqueId(archiveMaxId);
+            return;
+        }
+    }
+}
+
+// Adds the tasks archived since the last save to the end of archive.csv, in the format the
+// file already has
+static int appendArchive(int compressed) {
+    DataWriter writer;
+    if (!openWriter(&writer, "archive.csv", compressed, 1)) {
+        perror("Unable to open archive file for writing");
+        return 0;
+    }
+    archiveWritten = 1;
+    for (const ArchivedTask* archived = archivedTasks; archived != NULL; archived = archived->next) {
+        if (!archived->saved) {
+            writeArchivedTask(&writer, archived);
+        }
+    }
+    writeArchiveMaxId(&writer);
+    return closeDataWriter(&writer);
+}
+
+static int saveArchive() {
+    int unsaved = 0;
+    for (const ArchivedTask* archived = archivedTasks; archived != NULL; archived = archived->next) {
+        unsaved += !archived->saved;
+    }
+    if (!archiveRewrite && unsaved == 0) {
+        return 1;
+    }
+    archiveAppendFrom = -1;
+    FILE* fp = fopen("archive.csv", "rb");
+    if (fp != NULL && !archiveRewrite) {
+        char magic[COMPRESSION_MAGIC_SIZE];
+        size_t length = fread(magic, 1, sizeof(magic), fp);
+        fseek(fp, 0, SEEK_END);
+        archiveAppendFrom = ftell(fp);
+        fclose(fp);
+        return appendArchive(isCompressedData(magic, length));
+    }
+    if (fp != NULL) {
+        fclose(fp);
+    }
+    if (!loadArchive()) {
+        fprintf(stderr, "Unable to read archive.csv, so it was not rewritten.\n");
+        return 0;
+    }
+    DataWriter writer;
+    if (!openDataWriter(&writer, "archive.csv")) {
+        perror("Unable to open archive file for writing");
+        return 0;
+    }
+    archiveWritten = 1;
+    writeField(&writer, "Task ID");
+    writeField(&writer, "Task Name");
+    writeField(&writer, "Priority");
+    writeField(&writer, "Date");
+    writeField(&writer, "List ID");
+    writeField(&writer, "Position");
+    writeField(&writer, "Username");
+    endRecord(&writer);
+    for (const ArchivedTask* archived = archivedTasks; archived != NULL; archived = archived->next) {
+        writeArchivedTask(&writer, archived);
+    }
+    writeArchiveMaxId(&writer);
+    return closeDataWriter(&writer);
+}
+
+// After a committed save every archived task is in archive.csv. Tasks that were appended while
+// the archive was not loaded are let go of; loadArchive reads them back from the file.
+static void archiveSaved() {
+    archiveRewrite = 0;
+    if (archiveLoaded) {
+        for (ArchivedTask* archived = archivedTasks; archived != NULL; archived = archived->next) {
+            archived->saved = 1;
+        }
+        return;
+    }
+    freeArchive();
+}
+
+static void freeArchive() {
+    while (archivedTasks != NULL) {
+        ArchivedTask* archived = archivedTasks;
+        archivedTasks = archived->next;
+        freeTasks(archived->task);
+        free(archived);
+    }
+    archiveLoaded = 0;
+    archiveRewrite = 0;
+}
+
+// Prints the user's archived tasks whose name contains text; returns how many matched, or -1
+// if the archive could not be read
+int searchArchive(const User* user, const char* text) {
+    if (!loadArchive()) {
+        return -1;
+    }
+    int count = 0;
+    for (const ArchivedTask* archived = archivedTasks; archived != NULL; archived = archived->next) {
+        const Task* task = archived->task;
+        if (archived->owner != user || strstr(task->name, text) == NULL) {
+            continue;
+        }
+        const List* list = findListById(archived->listId);
+        printf("%s (#%ld) - Priority: %s, Deadline: %s, List: %s\n", task->name, task->id, task->priority, task->date,
+               list != NULL && list->board->user == user ? list->name : "(deleted)");
+        count++;
+    }
+    return count;
+}
+
+ArchivedTask* findArchivedTask(const User* user, long id) {
+    if (!loadArchive()) {
+        return NULL;
+    }
+    for (ArchivedTask* archived = archivedTasks; archived != NULL; archived = archived->next) {
+        if (archived->owner == user && archived->task->id == id) {
+            return archived;
+        }
+    }
+    return NULL;
+}
+
+// Puts an archived task back into a list, at its old place if the list still has room for it
+Task* restoreTaskWithArgs(ArchivedTask* archived, List* list) {
+    ArchivedTask** link = &archivedTasks;
+    while (*link != NULL && *link != archived) {
+        link = &(*link)->next;
+    }
+    if (*link == NULL) {
+        return NULL;
+    }
+    *link = archived->next;
+    Task* task = archived->task;
+    if (archived->saved) {
+        archiveRewrite = 1; // The task has to leave archive.csv
+    }
+    free(archived);
+    if (findTaskById(task->id) != NULL) {
+        task->id = generateUniqueId(); // The ID was reused while the task was archived
+    }
+    insertTaskByPosition(list, task);
+    indexTask(task);
+    countTask(task);
+    scheduleReminder(task);
+    touchTask(task);
+    return task;
+}
+
+// Applying the change feed of a primary on a standby (replica.c). The records come as
+// writeChangesSince writes them, parents first, and each is applied under the primary's number
+// for it, so the records, their IDs and the tombstones come out as the primary has them.
+
+// Starts the model over empty, for the full copy a primary sends when it connects
+void resetReplicatedData(User** users) {
+    freeAllData(users);
+    dataRoot = users;
+}
+
+// Fields: username, password
+static int applyUserUpsert(char** fields, int fieldCount) {
+    if (fieldCount < 2) {
+        return 0;
+    }
+    User* user = findUserByName(fields[0]);
+    if (user == NULL) {
+        return linkNewUser(dataRoot, fields[0], fields[1]) != NULL;
+    }
+    if (strcmp(user->password, fields[1]) != 0) {
+        storeString(&stringPool, &user->password, NULL, 0, fields[1]);
+    }
+    touchUser(user);
+    return 1;
+}
+
+// Fields: ID, name, username of the owner. Boards and lists are never renamed or moved, so an
+// upsert of one that exists only takes the number.
+static int applyBoardUpsert(char** fields, int fieldCount) {
+    if (fieldCount < 3) {
+        return 0;
+    }
+    long id = strtol(fields[0], NULL, 10);
+    Board* board = findBoardById(id);
+    if (board != NULL) {
+        touchBoard(board);
+        return 1;
+    }
+    User* owner = findUserByName(fields[2]);
+    if (owner == NULL) {
+        return 0;
+    }
+    seedUniqueId(id);
+    return linkNewBoard(owner, fields[1], id) != NULL;
+}
+
+// Fields: ID, name, board ID
+static int applyListUpsert(char** fields, int fieldCount) {
+    if (fieldCount < 3) {
+        return 0;
+    }
+    long id = strtol(fields[0], NULL, 10);
+    List* list = findListById(id);
+    if (list != NULL) {
+        touchList(list);
+        return 1;
+    }
+    Board* board = findBoardById(strtol(fields[2], NULL, 10));
+    if (board == NULL) {
+        return 0;
+    }
+    seedUniqueId(id);
+    return linkNewList(board, fields[1], id) != NULL;
+}
+
+// Fields: ID, name, priority, deadline, list ID, position. A task whose list or position changed
+// is linked in again by its new key and keeps it: while the primary's renumbered keys come in
+// one by one a key may for a moment equal one that is about to change.
+static int applyTaskUpsert(char** fields, int fieldCount) {
+    if (fieldCount < 6) {
+        return 0;
+    }
+    long id = strtol(fields[0], NULL, 10);
+    List* list = findListById(strtol(fields[4], NULL, 10));
+    if (list == NULL) {
+        return 0;
+    }
+    Task* task = findTaskById(id);
+    if (task == NULL) {
+        task = allocateTask(list, fields[1], fields[2], fields[3], fields[5]);
+        if (task == NULL) {
+            return 0;
+        }
+        seedUniqueId(id);
+        task->id = id;
+        linkTaskByPosition(list, task);
+        indexTask(task);
+        countTask(task);
+        scheduleReminder(task);
+        touchTask(task);
+        return 1;
+    }
+    if (!editTaskWithArgs(task, strcmp(task->name, fields[1]) != 0 ? fields[1] : NULL,
+                          strcmp(task->priority, fields[2]) != 0 ? fields[2] : NULL,
+                          strcmp(task->date, fields[3]) != 0 ? fields[3] : NULL)) {
+        return 0;
+    }
+    if (task->list != list || strcmp(task->position, fields[5]) != 0) {
+        List* oldList = task->list;
+        Task** link = &oldList->tasks;
+        while (*link != NULL && *link != task) {
+            link = &(*link)->next;
+        }
+        if (*link == NULL) {
+            return 0; // Not in the list it points at; leave it be rather than corrupt the list
+        }
+        *link = task->next;
+        taskOrderChanged(oldList);
+        uncountTask(task);
+        if (!storeString(&stringPool, &task->position, task->positionStorage, POSITION_INLINE, fields[5])) {
+            insertTaskByPosition(oldList, task);
+            countTask(task);
+            return 0;
+        }
+        linkTaskByPosition(list, task);
+        countTask(task);
+    }
+    touchTask(task);
+    return 1;
+}
+
+// Deletes the record if it is here; the tombstone is kept either way
+static void applyDeletion(RecordType type, long sequence, long id) {
+    Task* task;
+    List* list;
+    Board* board;
+    switch (type) {
+        case RECORD_TASK:
+            if ((task = findTaskById(id)) != NULL) {
+                deleteTaskWithArgs(task->list, task);
+                return;
+            }
+            break;
+        case RECORD_LIST:
+            if ((list = findListById(id)) != NULL) {
+                deleteListWithArgs(list->board, list);
+                return;
+            }
+            break;
+        case RECORD_BOARD:
+            if ((board = findBoardById(id)) != NULL) {
+                deleteBoardWithArgs(board->user, board);
+                return;
+            }
+            break;
+        default:
+            break;
+    }
+    // Made and deleted before this standby was following, or deleted with its parent already
+    Tombstone tombstone = { sequence, id, type };
+    addTombstone(&tombstone);
+}
+
+// Applies one line of the change feed, split into fields; returns 0 if it could not be applied
+int applyChangeRecord(char** fields, int fieldCount) {
+    if (fieldCount < 4) {
+        return 0;
+    }
+    long sequence = strtol(fields[0], NULL, 10);
+    int type = recordTypeOf(fields[2]);
+    char** record = fields + 3;
+    int recordFields = fieldCount - 3;
+    if (type < 0) {
+        return 0;
+    }
+    int ok = 1;
+    beginReplayedChange(sequence);
+    if (strcmp(fields[1], "delete") == 0) {
+        applyDeletion((RecordType)type, sequence, strtol(record[0], NULL, 10));
+    } else if (strcmp(fields[1], "upsert") != 0) {
+        ok = 0;
+    } else if (type == RECORD_USER) {
+        ok = applyUserUpsert(record, recordFields);
+    } else if (type == RECORD_BOARD) {
+        ok = applyBoardUpsert(record, recordFields);
+    } else if (type == RECORD_LIST) {
+        ok = applyListUpsert(record, recordFields);
+    } else {
+        ok = applyTaskUpsert(record, recordFields);
+    }
+    endReplayedChange();
+    return ok;
+}
+
+static int countMatchingTasks(const List* list, const TaskFilter* filter) {
+    int count = 0;
+    for (const Task* task = list->tasks; task != NULL; task = task->next) {
+        count += taskMatchesFilter(task, filter);
+    }
+    return count;
+}
+
+// Reads one optional filter value; returns NULL when the user leaves it empty. Dates come
+// back zero-padded like the stored ones, which the filter compares them with as text.
+static char* readFilterValue(const char* prompt, int isDate) {
+    while (1) {
+        printf("%s", prompt);
+        char* value = dynamicInput();
+        if (value == NULL || value[0] == '\0') {
+            free(value);
+            return NULL;
+        }
+        if (!isDate) {
+            return value;
+        }
+        char date[11];
+        if (normalizeDate(value, date)) {
+            free(value);
+            return strdup(date);
+        }
+        printf("Invalid date format. Please try again.\n");
+        free(value);
+    }
+}
+
+void bulkTasksMenu(Board* board, List* list) {
+    TaskFilter filter;
+    printf("Filter tasks (leave a field empty to match any value):\n");
+    char* priority = readFilterValue("Priority (low, medium, high): ", 0);
+    char* fromDate = readFilterValue("Deadline from (YYYY-MM-DD): ", 1);
+    char* toDate = readFilterValue("Deadline to (YYYY-MM-DD): ", 1);
+    char* nameMatch = readFilterValue("Name contains: ", 0);
+    filter.priority = priority;
+    filter.fromDate = fromDate;
+    filter.toDate = toDate;
+    filter.nameMatch = nameMatch;
+
+    printf("Apply to:\n1) This list\n2) Every list on board '%s'\nChoose an option: ", board->name);
+    int wholeBoard = readChoice() == 2;
+
+    int matching = 0;
+    for (List* current = wholeBoard ? board->lists : list; current != NULL; current = wholeBoard ? current->next : NULL) {
+        matching += countMatchingTasks(current, &filter);
+    }
+    printf("%d matching task(s).\n1) Move\n2) Delete\n3) Change priority\n4) Cancel\nChoose an option: ", matching);
+    int action = readChoice();
+
+    List* targetList = NULL;
+    char* newPriority = NULL;
+    if (matching == 0) {
+        action = 4;
+    } else if (action == 1) {
+        displayLists(board);
+        targetList = selectList(board);
+        if (targetList == NULL) {
+            action = 4;
+        }
+    } else if (action == 3) {
+        newPriority = readFilterValue("New priority (low, medium, high): ", 0);
+        if (newPriority == NULL) {
+            action = 4;
+        }
+    }
+
+    int changed = 0;
+    if (action >= 1 && action <= 3) {
+        for (List* current = wholeBoard ? board->lists : list; current != NULL; current = wholeBoard ? current->next : NULL) {
+            if (action == 1) {
+                changed += bulkMoveTasks(current, targetList, &filter);
+            } else if (action == 2) {
+                changed += bulkDeleteTasks(current, &filter);
+            } else {
+                changed += bulkSetPriority(current, &filter, newPriority);
+            }
+        }
+        // The whole batch lands on disk together
+        if (saveLoadedData()) {
+            printf("%d task(s) updated and saved.\n", changed);
+        } else {
+            printf("%d task(s) updated.\n", changed);
+        }
+    } else {
+        printf("Bulk action cancelled.\n");
+    }
+
+    free(priority);
+    free(fromDate);
+    free(toDate);
+    free(nameMatch);
+    free(newPriority);
+}
+
+typedef struct PositionedTask {
+    Task* task;
+    int index; // Place in the list before sorting, so tasks with the same key keep their order
+} PositionedTask;
+
+static int comparePositionedTasks(const void* a, const void* b) {
+    const PositionedTask* taskA = (const PositionedTask*)a;
+    const PositionedTask* taskB = (const PositionedTask*)b;
+    int order = strcmp(taskA->task->position, taskB->task->position);
+    if (order != 0) {
+        return order;
+    }
+    return taskA->index - taskB->index;
+}
+
+// Sorts the tasks of a list by position key and gives them fresh keys in the new order
+static void orderTasks(List* list) {
     // Count the number of tasks
     int taskCount = 0;
     for (Task* task = list->tasks; task != NULL; task = task->next) {
@@ -1239,25 +3382,98 @@ void sortTasks(List* list, int (*compFunc)(const void*, const void*)) {
     }
 
     // Convert linked list to array
-    Task** tasksArray = malloc(taskCount * sizeof(Task*));
+    PositionedTask* tasksArray = malloc(taskCount * sizeof(PositionedTask));
+    if (tasksArray == NULL) {
+        perror("Memory allocation failed for sorting");
+        renumberTaskPositions(list); // Keep the order the file had
+        return;
+    }
     Task* current = list->tasks;
     for (int i = 0; i < taskCount; i++) {
-        tasksArray[i] = current;
+        tasksArray[i].task = current;
+        tasksArray[i].index = i;
         current = current->next;
     }
 
     // Sort the array of tasks
-    qsort(tasksArray, taskCount, sizeof(Task*), compFunc);
+    qsort(tasksArray, taskCount, sizeof(PositionedTask), comparePositionedTasks);
 
     // Rebuild the linked list from the sorted array
-    list->tasks = tasksArray[0];
+    list->tasks = tasksArray[0].task;
     for (int i = 0; i < taskCount - 1; i++) {
-        tasksArray[i]->next = tasksArray[i + 1];
+        tasksArray[i].task->next = tasksArray[i + 1].task;
     }
-    tasksArray[taskCount - 1]->next = NULL;
+    tasksArray[taskCount - 1].task->next = NULL;
+    taskOrderChanged(list);
 
     // Free the array
     free(tasksArray);
+    renumberTaskPositions(list);
+}
+
+// Sorts by priority (then deadline) or by deadline; tasks that tie keep their current order
+void sortTasks(List* list, TaskSortMode mode) {
+    long long startTicks = statsClock();
+    if (list->tasks == NULL || list->tasks->next == NULL) {
+        return; // No need to sort if there's 0 or 1 task
+    }
+
+    // Sort the list's positional index in place: it is often up to date already, as paging
+    // through the list builds it, and afterwards it holds the new order without a rebuild
+    size_t taskCount = 0;
+    Task** tasksArray = listTaskOrder(list, &taskCount);
+    if (tasksArray == NULL || !sortTaskArray(tasksArray, taskCount, mode)) {
+        perror("Memory allocation failed for sorting");
+        return;
+    }
+
+    // Relink and renumber in the same pass, so each task is visited once after the sort. The
+    // keys count up in a stack buffer and are short enough to live in the task itself.
+    list->tasks = tasksArray[0];
+    char key[POSITION_INTEGER_SIZE] = "";
+    int keysStored = 1;
+    for (size_t i = 0; i < taskCount; i++) {
+        Task* task = tasksArray[i];
+        task->next = i + 1 < taskCount ? tasksArray[i + 1] : NULL;
+        if (keysStored && (!nextPosition(key) ||
+                           !storeString(&stringPool, &task->position, task->positionStorage, POSITION_INLINE, key))) {
+            fprintf(stderr, "Unable to store the task positions of list '%s'.\n", list->name);
+            keysStored = 0;
+        }
+        touchTask(task);
+    }
+    recordTiming(TIMER_SORT, startTicks);
+    TRACE_END(startTicks, "sortTasks");
+}
+
+// Loading prepends, so each list arrives in reverse file order. Puts it back in key order, and
+// gives the list new keys if any are missing (older files) or malformed.
+static void orderLoadedTasks(List* list) {
+    Task* ordered = NULL;
+    while (list->tasks != NULL) {
+        Task* task = list->tasks;
+        list->tasks = task->next;
+        task->next = ordered;
+        ordered = task;
+    }
+    list->tasks = ordered;
+    taskOrderChanged(list);
+
+    int inOrder = 1;
+    const char* previous = NULL;
+    for (Task* task = list->tasks; task != NULL; task = task->next) {
+        if (!isValidPosition(task->position)) {
+            renumberTaskPositions(list); // Keep the order the file had
+            return;
+        }
+        if (previous != NULL && strcmp(previous, task->position) >= 0) {
+            inOrder = 0;
+        }
+        previous = task->position;
+    }
+    if (!inOrder) {
+        orderTasks(list);
+    }
 }
 
 void sortTasksMenu(List* list) {
@@ -1267,15 +3483,15 @@ void sortTasksMenu(List* list) {
     }
 
     printf("Sort tasks by:\n1) Priority (High to Low)\n2) Date (Nearest to Furthest)\n3) Cancel\nChoose an option: ");
-    int sortChoice = atoi(dynamicInput());
+    int sortChoice = readChoice();
 
     switch (sortChoice) {
         case 1:
-            sortTasks(list, compareTasksByPriority);
+            sortTasks(list, SORT_BY_PRIORITY);
             printf("Tasks have been sorted by priority.\n");
             break;
         case 2:
-            sortTasks(list, compareTasksByDate);
+            sortTasks(list, SORT_BY_DATE);
             printf("Tasks have been sorted by date.\n");
             break;
         case 3:
@@ -1288,58 +3504,73 @@ void sortTasksMenu(List* list) {
 }
 
 void tasksMenu(User* user, Board* board, List* list)  {
+    CommandContext context = { user, board, list };
     int choice;
+    resetViewport();
     do {
-        displayTasks(list); // Show all tasks at the top of the menu
-        printf("1. Add Task\n2. Edit Task\n3. Delete Task\n4. Move Task\n5. Sort Tasks\n6. Exit\nChoose an option: ");
-        choice = atoi(dynamicInput());
+        long long drawStart = statsClock();
+        beginFrame();
+        printLogo();
+        displayTaskView(list);
+        screenPrintf("1. Add Task\n2. Edit Task\n3. Delete Task\n4. Move Task\n5. Sort Tasks\n6. Bulk Actions\n7. Exit\n");
+        presentFrame();
+        recordActionLatency("show tasks", drawStart);
+        printf("Choose an option or type a command: ");
+        choice = readMenuChoice(&context);
+        if (choice == -1) {
+            choice = 7; // End of input
+        }
 
+        long long actionStart = statsClock();
         switch (choice) {
+            case 0:
+                break; // A command was run instead
             case 1:
                 clearScreen();
                 addTask(list);
-                clearScreen();
                 break;
             case 2:
                 clearScreen();
                 editTask(list);
-                clearScreen();
                 break;
             case 3:
                 clearScreen();
                 deleteTask(list);
-                clearScreen();
                 break;
             case 4:
                 clearScreen();
-                moveTask(board, list);
-                clearScreen(); // 'user' should be passed to tasksMenu or retrieved from the list
+                moveTask(board, list); // 'user' should be passed to tasksMenu or retrieved from the list
                 break;
             case 5:
                 clearScreen();
                 sortTasksMenu(list); // Call the sortTasksMenu function
-                clearScreen();
                 break;
             case 6:
-                printf("Exiting to list menu.\n");
                 clearScreen();
+                bulkTasksMenu(board, list);
+                break;
+            case 7:
+                printf("Exiting to list menu.\n");
                 break;
             default:
                 printf("Invalid option. Please try again.\n");
-                clearScreen();
                 break;
         }
-    } while (choice != 6);
+        if (choice != 0) {
+            TRACE_MENU_END(actionStart, "tasksMenu", choice);
+        }
+        recordMenuAction(tasksMenuActions, MENU_ACTION_COUNT(tasksMenuActions), choice, actionStart);
+    } while (choice != 7);
 }
 
 void printLogo() {
-    printf("################################################################################################### \n");
-    printf("  _    _   ___________    _______       ________          ___         ______          _______       \n");
-    printf(" | |  | | ||___   ___|| ||       ))   ||        ||       // \\\\       ||     ))      ||       ))     \n");
-    printf(" | |  | |      | |      ||        ))  ||        ||      //   \\\\      ||      ))     ||        ))    \n");
-    printf(" | |  | |      | |      ||_______))   ||        ||     //     \\\\     ||_____))      ||         ))   \n");
-    printf(" | |  | |      | |      ||       ))   ||        ||    //_______\\\\    ||     \\\\      ||         ))   \n");
-    printf(" | |__| |      | |      ||        ))  ||        ||   //         \\\\   ||      \\\\     ||        ))    \n");
-    printf(" \\\\____//      |_|      ||_______))   ||________||  //           \\\\  ||       \\\\    ||_______))     \n");
-    printf("\n################################################################################################### \n\n");
+    screenPrintf("################################################################################################### \n");
+    screenPrintf("  _    _   ___________    _______       ________          ___         ______          _______       \n");
+    screenPrintf(" | |  | | ||___   ___|| ||       ))   ||        ||       // \\\\       ||     ))      ||       ))     \n");
+    screenPrintf(" | |  | |      | |      ||        ))  ||        ||      //   \\\\      ||      ))     ||        ))    \n");
+    screenPrintf(" | |  | |      | |      ||_______))   ||        ||     //     \\\\     ||_____))      ||         ))   \n");
+    screenPrintf(" | |  | |      | |      ||       ))   ||        ||    //_______\\\\    ||     \\\\      ||         ))   \n");
+    screenPrintf(" | |__| |      | |      ||        ))  ||        ||   //         \\\\   ||      \\\\     ||        ))    \n");
+    screenPrintf(" \\\\____//      |_|      ||_______))   ||________||  //           \\\\  ||       \\\\    ||_______))     \n");
+    screenPrintf("\n################################################################################################### \n\n");
 }
\ No newline at end of file
@@ -6,58 +6,305 @@
 #include <errno.h>
 #include <time.h>
 
+// Debug builds (-DUTBOARD_DEBUG_ALLOC) route every allocation through the tracking allocator in
+// debugalloc.c, which reports live bytes per call site at exit. Include this header last.
+#ifdef UTBOARD_DEBUG_ALLOC
+void* debugMalloc(size_t size, const char* file, int line);
+void* debugCalloc(size_t count, size_t size, const char* file, int line);
+void* debugRealloc(void* block, size_t size, const char* file, int line);
+char* debugStrdup(const char* text, const char* file, int line);
+void debugFree(void* block);
+void getAllocationTotals(size_t* live, size_t* peak);
+#ifndef DEBUG_ALLOC_IMPLEMENTATION
+#define malloc(size) debugMalloc(size, __FILE__, __LINE__)
+#define calloc(count, size) debugCalloc(count, size, __FILE__, __LINE__)
+#define realloc(block, size) debugRealloc(block, size, __FILE__, __LINE__)
+#define strdup(text) debugStrdup(text, __FILE__, __LINE__)
+#define free(block) debugFree(block)
+#endif
+#endif
+
+#define COMPRESSION_MAGIC "UTZ1"
+#define COMPRESSION_MAGIC_SIZE 4
+#define COMPRESSION_BLOCK_SIZE (256 * 1024) // Raw bytes per independently decodable block
+#define BLOCK_HEADER_SIZE 8                 // Raw size and stored size, 4 bytes each
+
+// Inline capacity, terminator included, of node strings; longer strings go to the string pool
+#define TASK_NAME_INLINE 40
+#define PRIORITY_INLINE 8
+#define DATE_INLINE 12
+#define LIST_NAME_INLINE 24
+#define BOARD_NAME_INLINE 32
+#define POSITION_INLINE 8
+#define POSITION_INTEGER_SIZE 28 // Longest integer part of a position key, terminator included
+
+// Bump allocator for long strings; see stringpool.c
+typedef struct StringPool {
+    struct StringBlock* block; // Block new strings are carved from
+} StringPool;
+
+// Open-addressing hash table keyed by an ID, a name, or both
+typedef struct IndexEntry {
+    long id;
+    const char* name; // Not owned; points into the indexed entity
+    void* value;
+} IndexEntry;
+
+typedef struct Index {
+    IndexEntry* entries;
+    size_t capacity;
+    size_t count;
+    size_t tombstones;
+} Index;
+
+#define PRIORITY_RANKS 3 // high, medium and everything else; see priorityRank
+
+// Task totals kept on every list, board and user; see aggregates.c
+typedef struct TaskCounts {
+    long total;
+    long byPriority[PRIORITY_RANKS];
+    long overdue;
+    long nextDeadline;       // Day of the nearest deadline that has not passed
+    long nextDeadlineTasks;  // Tasks due on it; 0 when there is no such deadline
+    int nextDeadlineUnknown; // Set when it has to be found again
+} TaskCounts;
+
+// String fields point at their inline storage when the text fits and at a pooled copy otherwise
 typedef struct Task {
     long id;
     char* name;
     char* priority;
     char* date;
-    int modified;
-    struct Task* next;
+    char* position;      // Sort key of the task within its list; see position.c
+    long modified;       // Change sequence of the last change to the record; see changes.c
+    char overdue;        // Counted as overdue in the task counts
+    struct Task* next;   // Next task in position order
+    struct List* list;   // List that holds the task
+    struct Reminder* reminder; // Next deadline event while reminders are on; see reminders.c
+    char nameStorage[TASK_NAME_INLINE];
+    char priorityStorage[PRIORITY_INLINE];
+    char dateStorage[DATE_INLINE];
+    char positionStorage[POSITION_INLINE];
 } Task;
 
 typedef struct List {
     long id;
     char* name;
-    int modified;
+    long modified;
+    long newestChange;   // Newest change sequence in the list or its tasks
     struct List* next;
     Task* tasks;
+    TaskCounts counts;
+    Task** taskOrder;    // The tasks by position, built when a position is looked up; see index.c
+    size_t taskOrderCount;
+    size_t taskOrderCapacity;
+    int taskOrderValid;  // Cleared by every change to the order of the tasks
+    struct Board* board; // Board that holds the list
+    char nameStorage[LIST_NAME_INLINE];
 } List;
 
 typedef struct Board {
     long id;
     char* name;
-    int modified;
+    long modified;
+    long newestChange;   // Newest change sequence in the board or anything on it
     struct Board* next;
     List* lists;
+    TaskCounts counts;
+    struct User* user;   // Owner of the board
+    char nameStorage[BOARD_NAME_INLINE];
 } Board;
 
 typedef struct User {
     char* username;
     char* password;
-    int modified;
+    long modified;
+    long newestChange;   // Newest change sequence in the user or anything they own
     struct User* next;
     Board* boards;
+    TaskCounts counts;
+    Index boardsByName;  // Board name -> Board
+    Index listsByName;   // (board ID, list name) -> List
+    struct UserCopy* snapshotCopy; // Newest copy taken for a read snapshot; see snapshot.c
 } User;
 
+// Data files whose records the change feed carries; see changes.c
+typedef enum RecordType {
+    RECORD_USER,
+    RECORD_BOARD,
+    RECORD_LIST,
+    RECORD_TASK,
+    RECORD_TYPES
+} RecordType;
+
+// A deleted board, list or task, kept so the change feed can pass the deletion on
+typedef struct Tombstone {
+    long sequence;
+    long id;
+    RecordType type;
+} Tombstone;
+
+// A task taken out of the working set; see archiveTaskWithArgs
+typedef struct ArchivedTask {
+    Task* task;
+    long listId;         // List it was archived from, which may have been deleted since
+    User* owner;
+    int saved;           // Already in archive.csv
+    struct ArchivedTask* next;
+} ArchivedTask;
+
+typedef struct ThreadPool ThreadPool;
+typedef struct Snapshot Snapshot;
+typedef struct BorrowedRegion BorrowedRegion;
+
+// Operations whose last duration the stats command reports
+typedef enum StatTimer {
+    TIMER_LOAD,
+    TIMER_SAVE,
+    TIMER_UPCOMING,
+    TIMER_SORT,
+    TIMER_REPORT,
+    TIMER_COUNT
+} StatTimer;
+
+// Orders sortTasks can put a list in
+typedef enum TaskSortMode {
+    SORT_BY_PRIORITY, // High to low, then nearest deadline first
+    SORT_BY_DATE      // Nearest deadline first
+} TaskSortMode;
+
+// Deadline events, in the order a task goes through them
+typedef enum ReminderEvent {
+    REMINDER_DUE_TOMORROW,
+    REMINDER_DUE_TODAY,
+    REMINDER_OVERDUE
+} ReminderEvent;
+
+typedef void (*ReminderHook)(ReminderEvent event, const Task* task);
+
+// Organisation-wide reports; see reports.c
+typedef enum ReportType {
+    REPORT_OVERDUE,    // Every overdue task
+    REPORT_USERS,      // Task counts of every user
+    REPORT_PRIORITIES, // How the tasks spread over the priorities
+    REPORT_TYPES
+} ReportType;
+
+// One list's tasks in merge order; see startTaskMerge
+typedef struct MergeRun {
+    unsigned int key; // Sort key of the run's next task
+    size_t order;     // Position of the list among the user's lists, for stable ties
+    Task* next;       // Next task, when the list itself is in order
+    Task** sorted;    // Sorted copy of the list's tasks otherwise
+    int unsorted;     // Out of order and not copied yet; key holds the smallest key
+    size_t index;     // Tasks of the run handed out so far
+    size_t count;
+} MergeRun;
+
+// Streams all of a user's tasks in one order across boards and lists
+typedef struct TaskMerge {
+    TaskSortMode mode;
+    unsigned int afterDate; // Packed date; only tasks due after it are merged, 0 for all
+    MergeRun* runs;         // Binary heap of the runs that still have tasks
+    size_t runCount;
+    int failed;             // A run could not be sorted, so the merge ended early
+} TaskMerge;
+
+// Growable line buffer that is reused across reads
+typedef struct InputBuffer {
+    char* data;
+    size_t length;
+    size_t capacity;
+} InputBuffer;
+
+// Where a one-line command runs: the menu it was typed in determines what paths are relative to
+typedef struct CommandContext {
+    User* user;
+    Board* board; // NULL outside a board
+    List* list;   // NULL outside a list
+} CommandContext;
+
+// Selects tasks for bulk operations; criteria left NULL match every task
+typedef struct TaskFilter {
+    const char* priority;  // Exact priority
+    const char* fromDate;  // Inclusive deadline range, "YYYY-MM-DD"
+    const char* toDate;
+    const char* nameMatch; // Substring of the task name
+} TaskFilter;
+
+// Buffered output for one data file, written either as plain CSV or as compressed blocks
+typedef struct DataWriter {
+    FILE* fp;         // NULL when the records are only collected in the buffer
+    char* buffer;
+    size_t length;
+    size_t capacity;
+    int compressed;
+    int recordFields; // Fields written so far in the current record
+    int failed;       // Set once a write or allocation fails
+} DataWriter;
+
+// A slice of a data file that starts and ends on record boundaries
+typedef struct LoadChunk {
+    char* begin;                           // Next unparsed byte of the chunk
+    char* end;                             // One past the last byte of the chunk
+    void (*parse)(struct LoadChunk* chunk);
+    void* records;                         // Parsed records, the type depends on the file
+    size_t recordCount;
+    size_t recordCapacity;
+    long maxId;                            // Largest entity ID seen in the chunk
+    StringPool strings;                    // Long strings of the chunk's records
+    int borrow;                            // Strings may point into the load buffer
+    long borrowedStrings;                  // Fields left pointing into the load buffer
+    int failed;                            // A record could not be kept, so the file is incomplete
+} LoadChunk;
 
 // ... (other includes and definitions)
 
 // Function prototypes (add these)
+int parseDate(const char* text, int* year, int* month, int* day);
 int isValidDate(char* date);
+int normalizeDate(const char* text, char* date);
 long generateUniqueId();
-void saveAllData(const User* users);
-void saveUsers(const User* user);
-void saveBoards(const User* user);
-void saveLists(const User* users);
-void saveTasks(const User* users);
+int saveAllData(const User* users);
+int saveLoadedData();
+int isDataFileName(const char* fileName);
+int saveUsers(const User* user);
+int saveBoards(const User* user);
+int saveLists(const User* users);
+int saveTasks(const User* users);
+int saveTombstones();
+void writeUserFields(DataWriter* writer, const User* user);
+void writeBoardFields(DataWriter* writer, const Board* board);
+void writeListFields(DataWriter* writer, const List* list);
+void writeTaskFields(DataWriter* writer, const Task* task);
+int exportLoadedChanges(long since, const char* fileName);
+int reportLoadedData(ReportType type, const char* fileName);
+void setCompressedStorage(int enabled);
+void setBorrowedStrings(int enabled);
+int openDataWriter(DataWriter* writer, const char* fileName);
+void writeField(DataWriter* writer, const char* text);
+void writeIdField(DataWriter* writer, long value);
+void endRecord(DataWriter* writer);
+int closeDataWriter(DataWriter* writer);
+int openMemoryWriter(DataWriter* writer);
+void resetReplicatedData(User** users);
+int applyChangeRecord(char** fields, int fieldCount);
 char* dynamicFgets(FILE* stream);
 char** parseCSVLine(char* line, int* fieldCount);
 char* dynamicInput();
-void loadAllData(User** users);
-void loadUsers(User** users);
-void loadBoards(User* user);
-void loadLists(Board* board);
-void loadTasks(List* list);
+char* readLine(InputBuffer* buffer);
+char* readInputLine();
+void setInputRecording(FILE* fp);
+void freeInputBuffer();
+int readChoice();
+int loadAllData(User** users);
+void loadUsers(LoadChunk* chunk);
+void loadBoards(LoadChunk* chunk);
+void loadLists(LoadChunk* chunk);
+void loadTasks(LoadChunk* chunk);
+void loadArchivedTasks(LoadChunk* chunk);
+void loadTombstones(LoadChunk* chunk);
+void seedUniqueId(long maxId);
 void freeAllData(User** users);
 void freeUsers(User* user);
 void freeBoards(Board* board);
@@ -68,28 +315,232 @@ void deleteBoard(User* user);
 void createBoard(User* user);
 void displayBoards(const User* user);
 Board* selectBoard(User* user);
+Board* findBoard(User* user, const char* key);
+Board* createBoardWithArgs(User* user, const char* name);
+void deleteBoardWithArgs(User* user, Board* board);
 User* loginWithArgs(User* users, const char* username, const char* password);
 User* signupWithArgs(User** users, const char* username, const char* password);
 char* getNextToken(char** input);
+char* scanToken(char** input, const char* stopChars, char* separator);
 int userExists(User* users, const char* username);
 void displayLists(const Board* board);
 List* selectList(Board* board);
+List* findList(Board* board, const char* key);
+List* createListWithArgs(Board* board, const char* name);
+void deleteListWithArgs(Board* board, List* list);
 void createList(Board* board);
 void deleteList(Board* board);
 void listsMenu(User* user, Board* board);
 void displayTasks(const List* list);
+void displayTaskView(List* list);
 Task* selectTask(List* list);
+Task* findTask(List* list, const char* key);
+Task* addTaskWithArgs(List* list, const char* name, const char* priority, const char* date);
+int editTaskWithArgs(Task* task, const char* name, const char* priority, const char* date);
+void deleteTaskWithArgs(List* list, Task* task);
+void moveTaskWithArgs(List* currentList, Task* task, List* targetList);
+int reorderTaskWithArgs(List* list, Task* task, int position);
 void addTask(List* list);
 void editTask(List* list);
 void deleteTask(List* list);
 void moveTask(Board* board, List* currentList);
 void tasksMenu(User* user, Board* board, List* list);
+int taskMatchesFilter(const Task* task, const TaskFilter* filter);
+int bulkDeleteTasks(List* list, const TaskFilter* filter);
+int bulkMoveTasks(List* list, List* targetList, const TaskFilter* filter);
+int bulkSetPriority(List* list, const TaskFilter* filter, const char* priority);
+int archiveTaskWithArgs(List* list, Task* task);
+int archiveTasksOlderThan(User* user, int days);
+int searchArchive(const User* user, const char* text);
+ArchivedTask* findArchivedTask(const User* user, long id);
+Task* restoreTaskWithArgs(ArchivedTask* archived, List* list);
+void bulkTasksMenu(Board* board, List* list);
 void clearScreen();
-int taskDeadlineComparator(const void* a, const void* b);
 char* getCurrentDate();
 void showUpcomingTasks(const User* user);
-int compareTasksByPriority(const void* a, const void* b);
-int compareTasksByDate(const void* a, const void* b);
-void sortTasks(List* list, int (*compFunc)(const void*, const void*));
+void showAllTasks(const User* user, TaskSortMode mode);
+void sortTasks(List* list, TaskSortMode mode);
 void sortTasksMenu(List* list);
-void printLogo();
\ No newline at end of file
+void printLogo();
+void runSession(User** users);
+
+// Thread pool (threadpool.c)
+int getCoreCount();
+ThreadPool* createThreadPool(int threadCount);
+void submitJob(ThreadPool* pool, void (*function)(void* arg), void* arg);
+void waitForJobs(ThreadPool* pool);
+void destroyThreadPool(ThreadPool* pool);
+
+// Reports over every user (reports.c)
+int parseReportType(const char* name, ReportType* type);
+int writeReport(const User* users, ReportType type, ThreadPool* pool, int workers, long today, FILE* out);
+int printReport(const User* users, ReportType type, int workers, FILE* out);
+
+// Hash index (index.c)
+void initIndex(Index* index);
+void freeIndex(Index* index);
+void* indexFind(const Index* index, long id, const char* name);
+int indexInsert(Index* index, long id, const char* name, void* value);
+void indexRemove(Index* index, long id, const char* name);
+void indexUser(User* user);
+void indexBoard(Board* board);
+void unindexBoard(Board* board);
+void indexList(List* list);
+void unindexList(List* list);
+void indexTask(Task* task);
+void unindexTask(Task* task);
+void clearEntityIndexes();
+User* findUserByName(const char* username);
+Board* findBoardByName(const User* user, const char* name);
+List* findListByName(const Board* board, const char* name);
+Board* findBoardById(long id);
+List* findListById(long id);
+Task* findTaskById(long id);
+void initTaskOrder(List* list);
+void taskOrderChanged(List* list);
+void freeTaskOrder(List* list);
+Task* taskAtPosition(List* list, long position);
+Task** listTaskOrder(List* list, size_t* count);
+void getEntityCounts(size_t* users, size_t* boards, size_t* lists, size_t* tasks, size_t* indexBytes);
+
+// String pool (stringpool.c)
+char* poolString(StringPool* pool, const char* text, size_t length);
+void releasePoolString(char* text);
+void releaseStringPool(StringPool* pool);
+int storeString(StringPool* pool, char** field, char* storage, size_t storageSize, const char* text);
+void releaseString(char* text, const char* storage);
+BorrowedRegion* reserveBorrowedRegion();
+void retainBorrowedBuffer(BorrowedRegion* region, char* buffer, size_t size, long references);
+void getStringMemory(size_t* pooled, size_t* borrowed);
+
+// Trace spans (trace.c), compiled in only when UTBOARD_TRACE is defined
+#ifdef UTBOARD_TRACE
+void startTrace(const char* fileName);
+void stopTrace();
+void traceSpan(const char* name, long long startTicks);
+void traceMenuSpan(const char* menu, int option, long long startTicks);
+#define TRACE_START(fileName) startTrace(fileName)
+#define TRACE_STOP() stopTrace()
+#define TRACE_BEGIN(var) long long var = statsClock()
+#define TRACE_END(var, name) traceSpan(name, var)
+#define TRACE_MENU_END(var, menu, option) traceMenuSpan(menu, option, var)
+#else
+#define TRACE_START(fileName)
+#define TRACE_STOP()
+#define TRACE_BEGIN(var)
+#define TRACE_END(var, name)
+#define TRACE_MENU_END(var, menu, option)
+#endif
+
+// Runtime stats (stats.c)
+long long statsClock();
+void recordTiming(StatTimer timer, long long startTicks);
+void recordCommandLatency(const char* name, long long startTicks);
+void setActionTiming(int enabled);
+void recordActionLatency(const char* name, long long startTicks);
+void setStatsInterval(int interval);
+void printStats(FILE* out);
+
+// Block compression (compress.c)
+size_t compressBound(size_t rawSize);
+size_t compressBlock(const char* src, size_t srcSize, char* dst, size_t dstCapacity);
+int decompressBlock(const char* src, size_t srcSize, char* dst, size_t rawSize);
+unsigned int readUint32(const char* p);
+int isCompressedData(const char* data, size_t size);
+int writeStoredBlock(FILE* fp, const char* data, size_t size);
+int writeCompressedBlock(FILE* fp, const char* data, size_t size);
+
+// Radix sort and merged views of tasks (tasksort.c)
+int priorityRank(const char* priority);
+int sortTaskArray(Task** tasks, size_t count, TaskSortMode mode);
+unsigned int taskSortKey(const Task* task, TaskSortMode mode);
+int startTaskMerge(TaskMerge* merge, const User* user, TaskSortMode mode, const char* afterDate);
+Task* nextMergedTask(TaskMerge* merge);
+void endTaskMerge(TaskMerge* merge);
+
+// Task counts (aggregates.c)
+void countTask(Task* task);
+void uncountTask(Task* task);
+void markTaskOverdue(Task* task);
+void uncountList(List* list);
+void uncountBoard(Board* board);
+void printTaskSummary(User* user, Board* board);
+
+// Deadline reminders (reminders.c)
+long dateToDay(const char* date);
+void dayToDate(long day, char* date);
+long reminderDay();
+void setReminderLog(FILE* log);
+void setReminderHook(ReminderHook hook);
+void scheduleReminder(Task* task);
+void cancelReminder(Task* task);
+void tickReminders();
+void advanceReminders(long day);
+
+// Change sequence numbers and the change feed (changes.c)
+long currentChangeSequence();
+void touchUser(User* user);
+void touchBoard(Board* board);
+void touchList(List* list);
+void touchTask(Task* task);
+void noteLoadedChange(long sequence, User* user, Board* board, List* list);
+void recordTaskDeletion(const Task* task);
+void recordListDeletion(const List* list);
+void recordBoardDeletion(const Board* board);
+const char* recordFileName(RecordType type);
+int recordTypeOf(const char* fileName);
+void addTombstone(const Tombstone* tombstone);
+const Tombstone* getTombstones(size_t* count);
+void freeTombstones();
+void setTombstoneRetention(long changes);
+void pruneTombstones();
+void notePrunedTombstones(long floor);
+long prunedTombstoneFloor();
+int changesAvailableSince(long since);
+long writeChangesSince(DataWriter* writer, const User* users, long since);
+long exportChangesSince(const User* users, long since, const char* fileName);
+int copyLiveTombstones(Tombstone** copy, size_t* count);
+long exportSnapshotChanges(const Snapshot* snapshot, long since, const char* fileName);
+void beginReplayedChange(long sequence);
+void endReplayedChange();
+
+// Hot standby (replica.c)
+int startReplication(const char* path, User** users);
+void shipChanges();
+void stopReplication();
+long replicatedSequence();
+int runStandby(const char* path, User** users);
+
+// Read snapshots and the reads that run on them (snapshot.c)
+Snapshot* pinSnapshot(User* users);
+const User* snapshotUsers(const Snapshot* snapshot);
+long snapshotSequence(const Snapshot* snapshot);
+const Tombstone* snapshotTombstones(const Snapshot* snapshot, size_t* count);
+void releaseSnapshot(Snapshot* snapshot);
+void dropSnapshotCopy(User* user);
+void getSnapshotMemory(size_t* pinned, size_t* copies, size_t* bytes);
+int startBackgroundReport(User* users, ReportType type, const char* fileName);
+int startBackgroundExport(User* users, long since, const char* fileName);
+void finishBackgroundReads(int wait);
+
+// Screen frames and viewports (render.c)
+void beginFrame();
+void screenPrintf(const char* format, ...);
+void presentFrame();
+void markInputRow();
+void setDiffRendering(int enabled);
+int screenRows();
+int placeViewport(int total, int rows);
+int scrollViewport(int pages);
+int jumpViewport(int page);
+void resetViewport();
+void freeScreen();
+
+// Task position keys (position.c)
+int isValidPosition(const char* key);
+char* positionBetween(const char* before, const char* after);
+int nextPosition(char* key);
+
+// One-line commands (commands.c)
+int executeCommand(CommandContext* context, char* line);
+int readMenuChoice(CommandContext* context);
\ No newline at end of file
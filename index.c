@@ -0,0 +1,328 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "functions.h"
+
+#define INDEX_MIN_CAPACITY 16
+
+static char tombstoneMarker;
+#define TOMBSTONE ((void*)&tombstoneMarker)
+
+static size_t hashKey(long id, const char* name) {
+    // FNV-1a over the name, mixed with the ID
+    unsigned long long hash = 1469598103934665603ULL ^ (unsigned long long)id * 0x9E3779B97F4A7C15ULL;
+    if (name != NULL) {
+        for (const unsigned char* p = (const unsigned char*)name; *p; p++) {
+            hash ^= *p;
+            hash *= 1099511628211ULL;
+        }
+    }
+    return (size_t)(hash ^ (hash >> 29));
+}
+
+static int keysEqual(const IndexEntry* entry, long id, const char* name) {
+    if (entry->id != id) {
+        return 0;
+    }
+    if (entry->name == NULL || name == NULL) {
+        return entry->name == name;
+    }
+    return strcmp(entry->name, name) == 0;
+}
+
+void initIndex(Index* index) {
+    index->entries = NULL;
+    index->capacity = 0;
+    index->count = 0;
+    index->tombstones = 0;
+}
+
+void freeIndex(Index* index) {
+    free(index->entries);
+    initIndex(index);
+}
+
+// Returns the slot holding the key, or NULL if the key is not present
+static IndexEntry* findSlot(const Index* index, long id, const char* name) {
+    if (index->capacity == 0) {
+        return NULL;
+    }
+    size_t mask = index->capacity - 1;
+    for (size_t i = hashKey(id, name) & mask;; i = (i + 1) & mask) {
+        IndexEntry* entry = &index->entries[i];
+        if (entry->value == NULL) {
+            return NULL; // Reached an empty slot, the key is absent
+        }
+        if (entry->value != TOMBSTONE && keysEqual(entry, id, name)) {
+            return entry;
+        }
+    }
+}
+
+static int resizeIndex(Index* index, size_t newCapacity) {
+    IndexEntry* newEntries = calloc(newCapacity, sizeof(IndexEntry));
+    if (newEntries == NULL) {
+        perror("Memory allocation failed for index");
+        return 0;
+    }
+    IndexEntry* oldEntries = index->entries;
+    size_t oldCapacity = index->capacity;
+    index->entries = newEntries;
+    index->capacity = newCapacity;
+    index->tombstones = 0;
+
+    // Reinsert live entries, dropping tombstones
+    size_t mask = newCapacity - 1;
+    for (size_t i = 0; i < oldCapacity; i++) {
+        IndexEntry* entry = &oldEntries[i];
+        if (entry->value == NULL || entry->value == TOMBSTONE) {
+            continue;
+        }
+        size_t slot = hashKey(entry->id, entry->name) & mask;
+        while (newEntries[slot].value != NULL) {
+            slot = (slot + 1) & mask;
+        }
+        newEntries[slot] = *entry;
+    }
+    free(oldEntries);
+    return 1;
+}
+
+void* indexFind(const Index* index, long id, const char* name) {
+    IndexEntry* entry = findSlot(index, id, name);
+    return entry ? entry->value : NULL;
+}
+
+// Inserts or replaces the value stored under the key; returns 0 on allocation failure
+int indexInsert(Index* index, long id, const char* name, void* value) {
+    IndexEntry* existing = findSlot(index, id, name);
+    if (existing != NULL) {
+        existing->name = name; // The old name may belong to an entity that is going away
+        existing->value = value;
+        return 1;
+    }
+
+    // Keep the table at most 3/4 full, counting tombstones
+    if ((index->count + index->tombstones + 1) * 4 > index->capacity * 3) {
+        size_t newCapacity = index->capacity ? index->capacity : INDEX_MIN_CAPACITY;
+        while ((index->count + 1) * 2 > newCapacity) {
+            newCapacity *= 2;
+        }
+        if (!resizeIndex(index, newCapacity)) {
+            return 0;
+        }
+    }
+
+    size_t mask = index->capacity - 1;
+    size_t slot = hashKey(id, name) & mask;
+    while (index->entries[slot].value != NULL && index->entries[slot].value != TOMBSTONE) {
+        slot = (slot + 1) & mask;
+    }
+    if (index->entries[slot].value == TOMBSTONE) {
+        index->tombstones--;
+    }
+    index->entries[slot].id = id;
+    index->entries[slot].name = name;
+    index->entries[slot].value = value;
+    index->count++;
+    return 1;
+}
+
+void indexRemove(Index* index, long id, const char* name) {
+    IndexEntry* entry = findSlot(index, id, name);
+    if (entry != NULL) {
+        entry->name = NULL;
+        entry->value = TOMBSTONE;
+        index->count--;
+        index->tombstones++;
+    }
+}
+
+// Entity indexes: stable IDs to entities, user names to users
+static Index usersByName;
+static Index boardsById;
+static Index listsById;
+static Index tasksById;
+
+void indexUser(User* user) {
+    indexInsert(&usersByName, 0, user->username, user);
+}
+
+void indexBoard(Board* board) {
+    indexInsert(&board->user->boardsByName, 0, board->name, board);
+    indexInsert(&boardsById, board->id, NULL, board);
+}
+
+// Drops the board, its lists and their tasks from every index
+void unindexBoard(Board* board) {
+    User* user = board->user;
+    for (List* list = board->lists; list != NULL; list = list->next) {
+        unindexList(list);
+    }
+    if (indexFind(&user->boardsByName, 0, board->name) == board) {
+        indexRemove(&user->boardsByName, 0, board->name);
+        // Another board with the same name takes over the name
+        for (Board* other = user->boards; other != NULL; other = other->next) {
+            if (other != board && strcmp(other->name, board->name) == 0) {
+                indexInsert(&user->boardsByName, 0, other->name, other);
+                break;
+            }
+        }
+    }
+    if (indexFind(&boardsById, board->id, NULL) == board) {
+        indexRemove(&boardsById, board->id, NULL);
+    }
+}
+
+void indexList(List* list) {
+    indexInsert(&list->board->user->listsByName, list->board->id, list->name, list);
+    indexInsert(&listsById, list->id, NULL, list);
+}
+
+// Drops the list and its tasks from every index
+void unindexList(List* list) {
+    Board* board = list->board;
+    Index* names = &board->user->listsByName;
+    for (Task* task = list->tasks; task != NULL; task = task->next) {
+        unindexTask(task);
+    }
+    if (indexFind(names, board->id, list->name) == list) {
+        indexRemove(names, board->id, list->name);
+        for (List* other = board->lists; other != NULL; other = other->next) {
+            if (other != list && strcmp(other->name, list->name) == 0) {
+                indexInsert(names, board->id, other->name, other);
+                break;
+            }
+        }
+    }
+    if (indexFind(&listsById, list->id, NULL) == list) {
+        indexRemove(&listsById, list->id, NULL);
+    }
+}
+
+void indexTask(Task* task) {
+    indexInsert(&tasksById, task->id, NULL, task);
+}
+
+void unindexTask(Task* task) {
+    if (indexFind(&tasksById, task->id, NULL) == task) {
+        indexRemove(&tasksById, task->id, NULL);
+    }
+}
+
+// Forgets every entity; the per-user indexes are freed with their users
+void clearEntityIndexes() {
+    freeIndex(&usersByName);
+    freeIndex(&boardsById);
+    freeIndex(&listsById);
+    freeIndex(&tasksById);
+}
+
+// Entity counts come straight from the ID maps; indexBytes covers every index table
+void getEntityCounts(size_t* users, size_t* boards, size_t* lists, size_t* tasks, size_t* indexBytes) {
+    *users = usersByName.count;
+    *boards = boardsById.count;
+    *lists = listsById.count;
+    *tasks = tasksById.count;
+    size_t slots = usersByName.capacity + boardsById.capacity + listsById.capacity + tasksById.capacity;
+    for (size_t i = 0; i < usersByName.capacity; i++) {
+        const IndexEntry* entry = &usersByName.entries[i];
+        if (entry->value != NULL && entry->value != TOMBSTONE) {
+            const User* user = entry->value;
+            slots += user->boardsByName.capacity + user->listsByName.capacity;
+        }
+    }
+    *indexBytes = slots * sizeof(IndexEntry);
+}
+
+User* findUserByName(const char* username) {
+    return indexFind(&usersByName, 0, username);
+}
+
+Board* findBoardByName(const User* user, const char* name) {
+    return indexFind(&user->boardsByName, 0, name);
+}
+
+List* findListByName(const Board* board, const char* name) {
+    return indexFind(&board->user->listsByName, board->id, name);
+}
+
+Board* findBoardById(long id) {
+    return indexFind(&boardsById, id, NULL);
+}
+
+List* findListById(long id) {
+    return indexFind(&listsById, id, NULL);
+}
+
+Task* findTaskById(long id) {
+    return indexFind(&tasksById, id, NULL);
+}
+
+// Positional index of a list: an array of its tasks in list order, so the task at a position,
+// such as the first one of a page, is found without walking the tasks in front of it. Changes
+// to the order only mark the array out of date; the next lookup rebuilds it in one pass and
+// reuses its memory, so paging through a list that is not changing costs the pages alone.
+
+void initTaskOrder(List* list) {
+    list->taskOrder = NULL;
+    list->taskOrderCount = list->taskOrderCapacity = 0;
+    list->taskOrderValid = 0;
+}
+
+void taskOrderChanged(List* list) {
+    list->taskOrderValid = 0;
+}
+
+void freeTaskOrder(List* list) {
+    free(list->taskOrder);
+    initTaskOrder(list);
+}
+
+static int buildTaskOrder(List* list) {
+    size_t count = 0;
+    for (const Task* task = list->tasks; task != NULL; task = task->next) {
+        count++;
+    }
+    if (count > list->taskOrderCapacity) {
+        size_t capacity = count + count / 2;
+        Task** grown = realloc(list->taskOrder, capacity * sizeof(Task*));
+        if (grown == NULL) {
+            return 0;
+        }
+        list->taskOrder = grown;
+        list->taskOrderCapacity = capacity;
+    }
+    count = 0;
+    for (Task* task = list->tasks; task != NULL; task = task->next) {
+        list->taskOrder[count++] = task;
+    }
+    list->taskOrderCount = count;
+    list->taskOrderValid = 1;
+    return 1;
+}
+
+// The tasks of the list in order, with their number in *count, for a caller that reorders the
+// array in place and relinks the tasks to match; NULL if there is no memory for the array
+Task** listTaskOrder(List* list, size_t* count) {
+    if (!list->taskOrderValid && !buildTaskOrder(list)) {
+        return NULL;
+    }
+    *count = list->taskOrderCount;
+    return list->taskOrder;
+}
+
+// Task at the 0-based position in the list, or NULL past its end
+Task* taskAtPosition(List* list, long position) {
+    if (position < 0) {
+        return NULL;
+    }
+    if (!list->taskOrderValid && !buildTaskOrder(list)) {
+        Task* task = list->tasks; // No memory for the array, so walk the list
+        while (task != NULL && position-- > 0) {
+            task = task->next;
+        }
+        return task;
+    }
+    return (size_t)position < list->taskOrderCount ? list->taskOrder[position] : NULL;
+}
@@ -0,0 +1,197 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "functions.h"
+
+// Position keys order the tasks of a list by plain strcmp. A key is an integer part followed
+// by an optional fraction, all in base 62 digits (0-9, A-Z, a-z, which sort in ASCII order):
+//   - the first character gives the length of the integer part: 'a' is followed by 1 digit,
+//     'b' by 2 and so on, while 'Z' is followed by 1 digit, 'Y' by 2 and so on for the
+//     integers below "a0"
+//   - the fraction never ends in '0', so there is always room for a key in front of another
+// Keys at either end of a list grow or shrink the integer part, which keeps them short when
+// tasks are always added at the same end; keys between two tasks extend the fraction.
+
+#define POSITION_BASE 62
+
+static const char positionDigits[] = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz";
+
+static int digitValue(char c) {
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    if (c >= 'A' && c <= 'Z') {
+        return c - 'A' + 10;
+    }
+    if (c >= 'a' && c <= 'z') {
+        return c - 'a' + 36;
+    }
+    return -1;
+}
+
+// Length of the integer part, head included, or 0 if head cannot start a key
+static int integerLength(char head) {
+    if (head >= 'a' && head <= 'z') {
+        return head - 'a' + 2;
+    }
+    if (head >= 'A' && head <= 'Z') {
+        return 'Z' - head + 2;
+    }
+    return 0;
+}
+
+// The smallest integer has no integer before it, so it is never handed out or accepted
+static int isSmallestInteger(const char* key) {
+    if (key[0] != 'A') {
+        return 0;
+    }
+    for (int i = 1; i < integerLength('A'); i++) {
+        if (key[i] != '0') {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+int isValidPosition(const char* key) {
+    int length = integerLength(key[0]);
+    size_t keyLength = strlen(key);
+    if (length == 0 || keyLength < (size_t)length || isSmallestInteger(key)) {
+        return 0;
+    }
+    for (size_t i = 1; i < keyLength; i++) {
+        if (digitValue(key[i]) < 0) {
+            return 0;
+        }
+    }
+    return keyLength == (size_t)length || key[keyLength - 1] != '0';
+}
+
+// Adds one to the null-terminated integer part in place; returns 0 past the largest integer
+static int incrementInteger(char* integer) {
+    int length = integerLength(integer[0]);
+    for (int i = length - 1; i > 0; i--) {
+        int digit = digitValue(integer[i]) + 1;
+        if (digit < POSITION_BASE) {
+            integer[i] = positionDigits[digit];
+            return 1;
+        }
+        integer[i] = '0';
+    }
+    // Every digit carried: move to the next head, whose integers are one digit longer or shorter
+    if (integer[0] == 'z') {
+        return 0;
+    }
+    if (integer[0] == 'Z') {
+        strcpy(integer, "a0");
+        return 1;
+    }
+    integer[0]++;
+    integer[integerLength(integer[0])] = '\0';
+    if (integer[0] > 'a') {
+        integer[length] = '0';
+    }
+    return 1;
+}
+
+// Subtracts one from the null-terminated integer part in place; returns 0 at the smallest integer
+static int decrementInteger(char* integer) {
+    int length = integerLength(integer[0]);
+    for (int i = length - 1; i > 0; i--) {
+        int digit = digitValue(integer[i]) - 1;
+        if (digit >= 0) {
+            integer[i] = positionDigits[digit];
+            return !isSmallestInteger(integer);
+        }
+        integer[i] = 'z';
+    }
+    if (integer[0] == 'A') {
+        return 0;
+    }
+    if (integer[0] == 'a') {
+        strcpy(integer, "Zz");
+        return 1;
+    }
+    integer[0]--;
+    integer[integerLength(integer[0])] = '\0';
+    if (integer[0] < 'Z') {
+        integer[length] = 'z';
+    }
+    return 1;
+}
+
+// Writes a fraction strictly between lower and upper (NULL for no upper bound)
+static void fractionBetween(const char* lower, const char* upper, char* out) {
+    size_t lowerLength = strlen(lower);
+    size_t upperLength = upper != NULL ? strlen(upper) : 0;
+    int bounded = upper != NULL;
+    for (size_t i = 0;; i++) {
+        int low = i < lowerLength ? digitValue(lower[i]) : 0;
+        int high = bounded && i < upperLength ? digitValue(upper[i]) : POSITION_BASE;
+        if (high - low > 1) {
+            out[i] = positionDigits[(low + high) / 2];
+            out[i + 1] = '\0';
+            return;
+        }
+        out[i] = positionDigits[low];
+        if (high != low) {
+            bounded = 0; // One digit apart: anything after lower's digit stays below upper
+        }
+    }
+}
+
+// Moves key on to the key positionBetween(key, NULL) would return, in place and without
+// allocating, for numbering a whole list: an empty key becomes "a0", then "a1" and so on.
+// key must hold POSITION_INTEGER_SIZE bytes and have no fraction; returns 0 past the largest key.
+int nextPosition(char* key) {
+    if (key[0] == '\0') {
+        strcpy(key, "a0");
+        return 1;
+    }
+    return incrementInteger(key);
+}
+
+// Returns a new key that sorts after before and ahead of after; either may be NULL for the end
+// of the list. The caller frees the key. Returns NULL if the keys are out of order.
+char* positionBetween(const char* before, const char* after) {
+    if (before != NULL && after != NULL && strcmp(before, after) >= 0) {
+        return NULL;
+    }
+    size_t size = (before ? strlen(before) : 0) + (after ? strlen(after) : 0) + 32; // Integers are at most 27 characters
+    char* key = malloc(size);
+    if (key == NULL) {
+        return NULL;
+    }
+    if (before == NULL && after == NULL) {
+        strcpy(key, "a0");
+        return key;
+    }
+
+    if (before == NULL) {
+        int length = integerLength(after[0]);
+        memcpy(key, after, length);
+        key[length] = '\0';
+        if (after[length] != '\0') {
+            return key; // The integer part alone sorts ahead of the same integer with a fraction
+        }
+        if (!decrementInteger(key)) {
+            free(key);
+            return NULL;
+        }
+        return key;
+    }
+
+    int length = integerLength(before[0]);
+    memcpy(key, before, length);
+    key[length] = '\0';
+    if (after != NULL && memcmp(before, after, length) == 0) {
+        fractionBetween(before + length, after + length, key + length);
+        return key;
+    }
+    if (incrementInteger(key) && (after == NULL || strcmp(key, after) < 0)) {
+        return key;
+    }
+    memcpy(key, before, length);
+    fractionBetween(before + length, NULL, key + length);
+    return key;
+}
@@ -0,0 +1,768 @@
+// Read-only queries run straight on the data files, without loading them the way utboard does.
+// Build: make utboard-query, or gcc with every source but ca3.c and -lws2_32; it shares the CSV,
+// date and priority handling of utboard (functions.c, tasksort.c)
+// Usage: utboard-query [--dir PATH] count|list [by user|board|list|priority] [where CONDITION...]
+// Conditions, which must all hold: user=NAME, board=NAME, list=NAME, priority=LEVEL,
+// before=YYYY-MM-DD, after=YYYY-MM-DD, overdue (deadline before today) and name~TEXT (TEXT
+// anywhere in the task name). Results are printed as CSV.
+// Boards and lists are read into small lookup tables sorted by ID. tasks.csv is streamed: one
+// piece of a plain file or one block of a compressed one is in memory at a time, so the memory
+// used depends on the number of boards and lists, never on the number of tasks.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <windows.h>
+#include <io.h>
+#include <time.h>
+#include "functions.h"
+
+#define QUOTE '\"'
+#define QUERY_READ_SIZE (1 << 20) // Bytes read at a time from a plain data file
+#define MAX_CONDITIONS 16
+#define MAX_OPEN_ATTEMPTS 5
+
+typedef enum ConditionField {
+    MATCH_USER,
+    MATCH_BOARD,
+    MATCH_LIST,
+    MATCH_PRIORITY,
+    MATCH_BEFORE,
+    MATCH_AFTER,
+    MATCH_OVERDUE,
+    MATCH_NAME
+} ConditionField;
+
+typedef struct Condition {
+    ConditionField field;
+    const char* value;
+    char date[DATE_INLINE]; // before= and after= dates, zero-padded like the data files
+} Condition;
+
+typedef enum GroupBy { GROUP_NONE, GROUP_USER, GROUP_BOARD, GROUP_LIST, GROUP_PRIORITY } GroupBy;
+
+typedef struct Query {
+    int listing; // "list" prints the matching tasks, "count" only counts them
+    GroupBy groupBy;
+    Condition conditions[MAX_CONDITIONS];
+    int conditionCount;
+    char today[16];
+} Query;
+
+// Both row types start with their ID, which the tables are sorted and searched by
+typedef struct BoardRow {
+    long id;
+    char* name;
+    char* username;
+    size_t user; // Index into QueryTables.users
+} BoardRow;
+
+typedef struct ListRow {
+    long id;
+    char* name;
+    long boardIndex; // Index into QueryTables.boards, -1 if the board is missing
+} ListRow;
+
+typedef struct QueryTables {
+    BoardRow* boards;
+    size_t boardCount;
+    ListRow* lists;
+    size_t listCount;
+    char** users; // Usernames that own a board, sorted; they point into the board rows
+    size_t userCount;
+} QueryTables;
+
+// Records of a data file, read a piece at a time. A record cut by the end of a piece is carried
+// over to the front of the buffer and completed by the next piece.
+typedef struct DataReader {
+    FILE* fp;
+    int compressed;
+    char* buffer;
+    size_t capacity; // Bytes the buffer holds, not counting room for a terminator
+    size_t length;
+    size_t pos;      // Start of the next record in the buffer
+    char* stored;    // Bytes of the current compressed block as stored in the file
+    size_t storedCapacity;
+    int finished;
+} DataReader;
+
+static const char* priorityNames[PRIORITY_RANKS] = { "high", "medium", "low" };
+
+// Opens a data file without stopping utboard from replacing it while the query reads it
+static FILE* openShared(const char* path) {
+    HANDLE handle = CreateFile(path, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                               NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (handle == INVALID_HANDLE_VALUE) {
+        return NULL;
+    }
+    int fd = _open_osfhandle((intptr_t)handle, _O_RDONLY);
+    if (fd < 0) {
+        CloseHandle(handle);
+        return NULL;
+    }
+    FILE* fp = _fdopen(fd, "rb");
+    if (fp == NULL) {
+        _close(fd);
+    }
+    return fp;
+}
+
+// Whether the open file is still the one at path, that is no save has replaced it since. A save
+// moves a new file into place, which has a file index of its own, so the volume and index tell
+// the files apart however close together they were written.
+static int isCurrentFile(FILE* fp, const char* path) {
+    BY_HANDLE_FILE_INFORMATION opened, current;
+    HANDLE openedHandle = (HANDLE)_get_osfhandle(_fileno(fp));
+    if (openedHandle == INVALID_HANDLE_VALUE || !GetFileInformationByHandle(openedHandle, &opened)) {
+        return 0;
+    }
+    HANDLE currentHandle = CreateFile(path, 0, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL,
+                                      OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (currentHandle == INVALID_HANDLE_VALUE) {
+        return 0;
+    }
+    int ok = GetFileInformationByHandle(currentHandle, &current);
+    CloseHandle(currentHandle);
+    return ok && opened.dwVolumeSerialNumber == current.dwVolumeSerialNumber &&
+           opened.nFileIndexHigh == current.nFileIndexHigh && opened.nFileIndexLow == current.nFileIndexLow;
+}
+
+// Makes room for extra bytes after the buffered ones, dropping the records already read
+static int reserveReader(DataReader* reader, size_t extra) {
+    if (reader->pos > 0) {
+        memmove(reader->buffer, reader->buffer + reader->pos, reader->length - reader->pos);
+        reader->length -= reader->pos;
+        reader->pos = 0;
+    }
+    if (reader->length + extra <= reader->capacity) {
+        return 1;
+    }
+    size_t capacity = reader->capacity;
+    while (capacity < reader->length + extra) {
+        capacity *= 2;
+    }
+    char* buffer = realloc(reader->buffer, capacity + 1);
+    if (buffer == NULL) {
+        perror("Memory allocation failed for the read buffer");
+        return 0;
+    }
+    reader->buffer = buffer;
+    reader->capacity = capacity;
+    return 1;
+}
+
+// Appends the next piece of the file to the buffer; returns 0 at the end of the file
+static int fillReader(DataReader* reader) {
+    if (!reader->compressed) {
+        if (!reserveReader(reader, QUERY_READ_SIZE)) {
+            return 0;
+        }
+        size_t got = fread(reader->buffer + reader->length, 1, reader->capacity - reader->length, reader->fp);
+        reader->length += got;
+        return got > 0;
+    }
+
+    char header[BLOCK_HEADER_SIZE];
+    if (fread(header, 1, sizeof(header), reader->fp) != sizeof(header)) {
+        return 0;
+    }
+    size_t rawSize = readUint32(header);
+    size_t storedSize = readUint32(header + 4);
+    if (storedSize > rawSize || !reserveReader(reader, rawSize)) {
+        fprintf(stderr, "Corrupted block header, later records were skipped.\n");
+        return 0;
+    }
+    char* target = reader->buffer + reader->length;
+    if (storedSize == rawSize) {
+        // Stored uncompressed
+        if (fread(target, 1, rawSize, reader->fp) != rawSize) {
+            fprintf(stderr, "Truncated block, later records were skipped.\n");
+            return 0;
+        }
+    } else {
+        if (storedSize > reader->storedCapacity) {
+            char* stored = realloc(reader->stored, storedSize);
+            if (stored == NULL) {
+                perror("Memory allocation failed for a compressed block");
+                return 0;
+            }
+            reader->stored = stored;
+            reader->storedCapacity = storedSize;
+        }
+        if (fread(reader->stored, 1, storedSize, reader->fp) != storedSize) {
+            fprintf(stderr, "Truncated block, later records were skipped.\n");
+            return 0;
+        }
+        if (!decompressBlock(reader->stored, storedSize, target, rawSize)) {
+            fprintf(stderr, "Corrupted block, later records were skipped.\n");
+            return 0;
+        }
+    }
+    reader->length += rawSize;
+    return 1;
+}
+
+// Returns the next record, null-terminated in the reader's buffer and valid until the next
+// call, or NULL at the end of the file
+static char* nextRecord(DataReader* reader) {
+    char* line;
+    char* lineEnd;
+    for (;;) {
+        line = reader->buffer + reader->pos;
+        char* newline = memchr(line, '\n', reader->length - reader->pos);
+        if (newline != NULL) {
+            lineEnd = newline;
+            reader->pos = newline - reader->buffer + 1;
+            break;
+        }
+        if (reader->finished || !fillReader(reader)) {
+            // The last record may have no line break after it
+            reader->finished = 1;
+            if (reader->pos == reader->length) {
+                return NULL;
+            }
+            line = reader->buffer + reader->pos;
+            lineEnd = reader->buffer + reader->length;
+            reader->pos = reader->length;
+            break;
+        }
+    }
+    if (lineEnd > line && lineEnd[-1] == '\r') {
+        lineEnd--;
+    }
+    *lineEnd = '\0';
+    return line;
+}
+
+// Sets up the reader on an open data file and skips its header line
+static int startReader(DataReader* reader, FILE* fp) {
+    memset(reader, 0, sizeof(*reader));
+    reader->fp = fp;
+    char magic[COMPRESSION_MAGIC_SIZE];
+    size_t got = fread(magic, 1, sizeof(magic), fp);
+    reader->compressed = isCompressedData(magic, got);
+    reader->capacity = reader->compressed ? COMPRESSION_BLOCK_SIZE : QUERY_READ_SIZE;
+    reader->buffer = malloc(reader->capacity + 1);
+    if (reader->buffer == NULL) {
+        perror("Memory allocation failed for the read buffer");
+        return 0;
+    }
+    if (!reader->compressed) {
+        memcpy(reader->buffer, magic, got);
+        reader->length = got;
+    }
+    nextRecord(reader);
+    return 1;
+}
+
+static void endReader(DataReader* reader) {
+    free(reader->buffer);
+    free(reader->stored);
+    reader->buffer = NULL;
+    reader->stored = NULL;
+}
+
+static int compareRowIds(const void* a, const void* b) {
+    long first = *(const long*)a;
+    long second = *(const long*)b;
+    return (first > second) - (first < second);
+}
+
+static int compareNames(const void* a, const void* b) {
+    return strcmp(*(char* const*)a, *(char* const*)b);
+}
+
+// Grows a table array so it holds at least count + 1 rows; returns 0 if there is no memory
+static int growTable(void** rows, size_t* capacity, size_t count, size_t rowSize) {
+    if (count < *capacity) {
+        return 1;
+    }
+    size_t newCapacity = *capacity ? *capacity * 2 : 64;
+    void* newRows = realloc(*rows, newCapacity * rowSize);
+    if (newRows == NULL) {
+        perror("Memory allocation failed for a lookup table");
+        return 0;
+    }
+    *rows = newRows;
+    *capacity = newCapacity;
+    return 1;
+}
+
+static void freeTables(QueryTables* tables) {
+    for (size_t i = 0; i < tables->boardCount; i++) {
+        free(tables->boards[i].name);
+        free(tables->boards[i].username);
+    }
+    for (size_t i = 0; i < tables->listCount; i++) {
+        free(tables->lists[i].name);
+    }
+    free(tables->boards);
+    free(tables->lists);
+    free(tables->users);
+    memset(tables, 0, sizeof(*tables));
+}
+
+// Reads boards.csv (Board ID, Board Name, Username) into the board and user tables
+static int loadBoardTable(QueryTables* tables, DataReader* reader) {
+    size_t capacity = 0;
+    char* line;
+    while ((line = nextRecord(reader)) != NULL) {
+        int fieldCount;
+        char** fields = parseCSVLine(line, &fieldCount);
+        if (fields == NULL) {
+            return 0;
+        }
+        if (fieldCount < 3) {
+            free(fields);
+            continue;
+        }
+        if (!growTable((void**)&tables->boards, &capacity, tables->boardCount, sizeof(BoardRow))) {
+            free(fields);
+            return 0;
+        }
+        BoardRow* board = &tables->boards[tables->boardCount];
+        board->id = atol(fields[0]);
+        board->name = strdup(fields[1]);
+        board->username = strdup(fields[2]);
+        tables->boardCount++;
+        free(fields);
+        if (board->name == NULL || board->username == NULL) {
+            perror("Memory allocation failed for a board");
+            return 0;
+        }
+    }
+    if (tables->boardCount == 0) {
+        return 1;
+    }
+    qsort(tables->boards, tables->boardCount, sizeof(BoardRow), compareRowIds);
+
+    tables->users = malloc(tables->boardCount * sizeof(char*));
+    if (tables->users == NULL) {
+        perror("Memory allocation failed for the user table");
+        return 0;
+    }
+    for (size_t i = 0; i < tables->boardCount; i++) {
+        tables->users[i] = tables->boards[i].username;
+    }
+    qsort(tables->users, tables->boardCount, sizeof(char*), compareNames);
+    for (size_t i = 0; i < tables->boardCount; i++) {
+        if (tables->userCount == 0 || strcmp(tables->users[tables->userCount - 1], tables->users[i]) != 0) {
+            tables->users[tables->userCount++] = tables->users[i];
+        }
+    }
+    for (size_t i = 0; i < tables->boardCount; i++) {
+        char** user = bsearch(&tables->boards[i].username, tables->users, tables->userCount, sizeof(char*), compareNames);
+        tables->boards[i].user = user - tables->users;
+    }
+    return 1;
+}
+
+// Reads lists.csv (List ID, List Name, Board ID) into the list table
+static int loadListTable(QueryTables* tables, DataReader* reader) {
+    size_t capacity = 0;
+    char* line;
+    while ((line = nextRecord(reader)) != NULL) {
+        int fieldCount;
+        char** fields = parseCSVLine(line, &fieldCount);
+        if (fields == NULL) {
+            return 0;
+        }
+        if (fieldCount < 3) {
+            free(fields);
+            continue;
+        }
+        if (!growTable((void**)&tables->lists, &capacity, tables->listCount, sizeof(ListRow))) {
+            free(fields);
+            return 0;
+        }
+        ListRow* list = &tables->lists[tables->listCount];
+        long boardId = atol(fields[2]);
+        BoardRow* board = bsearch(&boardId, tables->boards, tables->boardCount, sizeof(BoardRow), compareRowIds);
+        list->id = atol(fields[0]);
+        list->name = strdup(fields[1]);
+        list->boardIndex = board != NULL ? board - tables->boards : -1;
+        tables->listCount++;
+        free(fields);
+        if (list->name == NULL) {
+            perror("Memory allocation failed for a list");
+            return 0;
+        }
+    }
+    if (tables->listCount > 0) {
+        qsort(tables->lists, tables->listCount, sizeof(ListRow), compareRowIds);
+    }
+    return 1;
+}
+
+static FILE* openDataFile(const char* dir, const char* name, char* path, size_t pathSize) {
+    snprintf(path, pathSize, "%s/%s", dir, name);
+    FILE* fp = openShared(path);
+    if (fp == NULL) {
+        char message[FILENAME_MAX + 32];
+        snprintf(message, sizeof(message), "Unable to open %s", path);
+        perror(message);
+    }
+    return fp;
+}
+
+// Opens tasks.csv and reads the lookup tables so that all three files come from the same save.
+// utboard replaces the files one after another, boards before lists before tasks, so they are
+// opened in the opposite order; if any of them has been replaced once the tables are read, a
+// save was under way and the files are opened again. Returns tasks.csv, or NULL on failure.
+static FILE* openSnapshot(const char* dir, QueryTables* tables) {
+    char tasksPath[FILENAME_MAX], listsPath[FILENAME_MAX], boardsPath[FILENAME_MAX];
+    for (int attempt = 1;; attempt++) {
+        FILE* tasksFile = openDataFile(dir, "tasks.csv", tasksPath, sizeof(tasksPath));
+        FILE* listsFile = tasksFile ? openDataFile(dir, "lists.csv", listsPath, sizeof(listsPath)) : NULL;
+        FILE* boardsFile = listsFile ? openDataFile(dir, "boards.csv", boardsPath, sizeof(boardsPath)) : NULL;
+        int ok = boardsFile != NULL;
+        DataReader reader;
+        if (ok) {
+            ok = startReader(&reader, boardsFile) && loadBoardTable(tables, &reader);
+            endReader(&reader);
+        }
+        if (ok) {
+            ok = startReader(&reader, listsFile) && loadListTable(tables, &reader);
+            endReader(&reader);
+        }
+        int unchanged = ok && isCurrentFile(tasksFile, tasksPath) && isCurrentFile(listsFile, listsPath) &&
+                        isCurrentFile(boardsFile, boardsPath);
+        if (boardsFile != NULL) {
+            fclose(boardsFile);
+        }
+        if (listsFile != NULL) {
+            fclose(listsFile);
+        }
+        if (!ok) {
+            if (tasksFile != NULL) {
+                fclose(tasksFile);
+            }
+            freeTables(tables);
+            return NULL;
+        }
+        if (unchanged || attempt == MAX_OPEN_ATTEMPTS) {
+            if (!unchanged) {
+                fprintf(stderr, "The data files kept changing; the results may mix two saves.\n");
+            }
+            return tasksFile;
+        }
+        fclose(tasksFile);
+        freeTables(tables);
+        Sleep(50);
+    }
+}
+
+static int parseCondition(Condition* condition, const char* text) {
+    static const struct {
+        const char* prefix;
+        ConditionField field;
+    } prefixes[] = {
+        { "user=", MATCH_USER }, { "board=", MATCH_BOARD }, { "list=", MATCH_LIST },
+        { "priority=", MATCH_PRIORITY }, { "before=", MATCH_BEFORE }, { "after=", MATCH_AFTER },
+        { "name~", MATCH_NAME },
+    };
+    if (strcmp(text, "overdue") == 0) {
+        condition->field = MATCH_OVERDUE;
+        condition->value = NULL;
+        return 1;
+    }
+    for (size_t i = 0; i < sizeof(prefixes) / sizeof(prefixes[0]); i++) {
+        size_t length = strlen(prefixes[i].prefix);
+        if (strncmp(text, prefixes[i].prefix, length) == 0) {
+            condition->field = prefixes[i].field;
+            condition->value = text + length;
+            if ((condition->field == MATCH_BEFORE || condition->field == MATCH_AFTER) &&
+                !normalizeDate(condition->value, condition->date)) {
+                fprintf(stderr, "Dates are written YYYY-MM-DD: %s\n", text);
+                return 0;
+            }
+            return 1;
+        }
+    }
+    fprintf(stderr, "Unknown condition: %s\n", text);
+    return 0;
+}
+
+// Reads "count|list [by FIELD] [where CONDITION [and] ...]"
+static int parseQuery(Query* query, int argc, char* argv[]) {
+    memset(query, 0, sizeof(*query));
+    time_t now = time(NULL);
+    strftime(query->today, sizeof(query->today), "%Y-%m-%d", localtime(&now));
+    if (argc < 1) {
+        return 0;
+    }
+    if (strcmp(argv[0], "list") == 0) {
+        query->listing = 1;
+    } else if (strcmp(argv[0], "count") != 0) {
+        fprintf(stderr, "Unknown query: %s\n", argv[0]);
+        return 0;
+    }
+    int i = 1;
+    if (i + 1 < argc && strcmp(argv[i], "by") == 0) {
+        static const char* groupNames[] = { "", "user", "board", "list", "priority" };
+        for (int group = GROUP_USER; group <= GROUP_PRIORITY; group++) {
+            if (strcmp(argv[i + 1], groupNames[group]) == 0) {
+                query->groupBy = (GroupBy)group;
+            }
+        }
+        if (query->groupBy == GROUP_NONE || query->listing) {
+            fprintf(stderr, "Only counts can be grouped, by user, board, list or priority.\n");
+            return 0;
+        }
+        i += 2;
+    }
+    if (i < argc && strcmp(argv[i], "where") == 0) {
+        i++;
+    }
+    for (; i < argc; i++) {
+        if (strcmp(argv[i], "and") == 0) {
+            continue;
+        }
+        if (query->conditionCount == MAX_CONDITIONS) {
+            fprintf(stderr, "At most %d conditions are allowed.\n", MAX_CONDITIONS);
+            return 0;
+        }
+        if (!parseCondition(&query->conditions[query->conditionCount++], argv[i])) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+// Tasks.csv fields
+enum { TASK_ID, TASK_NAME, TASK_PRIORITY, TASK_DATE, TASK_LIST, TASK_FIELDS };
+
+static int matchesQuery(const Query* query, const QueryTables* tables, const ListRow* list, char** fields) {
+    const BoardRow* board = &tables->boards[list->boardIndex];
+    char date[DATE_INLINE];
+    int hasDate = normalizeDate(fields[TASK_DATE], date); // Older saves may not have padded it
+    for (int i = 0; i < query->conditionCount; i++) {
+        const Condition* condition = &query->conditions[i];
+        int matches = 0;
+        switch (condition->field) {
+            case MATCH_USER:
+                matches = strcmp(board->username, condition->value) == 0;
+                break;
+            case MATCH_BOARD:
+                matches = strcmp(board->name, condition->value) == 0;
+                break;
+            case MATCH_LIST:
+                matches = strcmp(list->name, condition->value) == 0;
+                break;
+            case MATCH_PRIORITY:
+                matches = priorityRank(fields[TASK_PRIORITY]) == priorityRank(condition->value);
+                break;
+            case MATCH_BEFORE:
+                matches = hasDate && strcmp(date, condition->date) < 0;
+                break;
+            case MATCH_AFTER:
+                matches = hasDate && strcmp(date, condition->date) > 0;
+                break;
+            case MATCH_OVERDUE:
+                matches = hasDate && strcmp(date, query->today) < 0;
+                break;
+            case MATCH_NAME:
+                matches = strstr(fields[TASK_NAME], condition->value) != NULL;
+                break;
+        }
+        if (!matches) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static void printCsvField(const char* text, int last) {
+    putchar(QUOTE);
+    for (const char* p = text; *p; p++) {
+        if (*p == QUOTE) {
+            putchar(QUOTE);
+        }
+        putchar(*p);
+    }
+    putchar(QUOTE);
+    putchar(last ? '\n' : ',');
+}
+
+static size_t groupCount(const Query* query, const QueryTables* tables) {
+    switch (query->groupBy) {
+        case GROUP_USER:
+            return tables->userCount;
+        case GROUP_BOARD:
+            return tables->boardCount;
+        case GROUP_LIST:
+            return tables->listCount;
+        case GROUP_PRIORITY:
+            return PRIORITY_RANKS;
+        default:
+            return 1;
+    }
+}
+
+static size_t taskGroup(const Query* query, const QueryTables* tables, const ListRow* list, char** fields) {
+    switch (query->groupBy) {
+        case GROUP_USER:
+            return tables->boards[list->boardIndex].user;
+        case GROUP_BOARD:
+            return list->boardIndex;
+        case GROUP_LIST:
+            return list - tables->lists;
+        case GROUP_PRIORITY:
+            return priorityRank(fields[TASK_PRIORITY]);
+        default:
+            return 0;
+    }
+}
+
+// Prints the groups that have tasks, after a header naming the group columns
+static void printCounts(const Query* query, const QueryTables* tables, const unsigned long* counts) {
+    char number[24];
+    switch (query->groupBy) {
+        case GROUP_USER:
+            printf("\"User\",\"Tasks\"\n");
+            break;
+        case GROUP_BOARD:
+            printf("\"User\",\"Board\",\"Tasks\"\n");
+            break;
+        case GROUP_LIST:
+            printf("\"User\",\"Board\",\"List\",\"Tasks\"\n");
+            break;
+        case GROUP_PRIORITY:
+            printf("\"Priority\",\"Tasks\"\n");
+            break;
+        default:
+            printf("\"Tasks\"\n");
+            break;
+    }
+    size_t groups = groupCount(query, tables);
+    for (size_t i = 0; i < groups; i++) {
+        if (counts[i] == 0 && query->groupBy != GROUP_NONE) {
+            continue;
+        }
+        switch (query->groupBy) {
+            case GROUP_USER:
+                printCsvField(tables->users[i], 0);
+                break;
+            case GROUP_BOARD:
+                printCsvField(tables->boards[i].username, 0);
+                printCsvField(tables->boards[i].name, 0);
+                break;
+            case GROUP_LIST: {
+                const BoardRow* board = &tables->boards[tables->lists[i].boardIndex];
+                printCsvField(board->username, 0);
+                printCsvField(board->name, 0);
+                printCsvField(tables->lists[i].name, 0);
+                break;
+            }
+            case GROUP_PRIORITY:
+                printCsvField(priorityNames[i], 0);
+                break;
+            default:
+                break;
+        }
+        snprintf(number, sizeof(number), "%lu", counts[i]);
+        printCsvField(number, 1);
+    }
+}
+
+// Prints or counts one task record if it matches; returns 0 if it belongs to no known list
+static int queryTask(const Query* query, const QueryTables* tables, char** fields, unsigned long* counts) {
+    long listId = atol(fields[TASK_LIST]);
+    const ListRow* list = bsearch(&listId, tables->lists, tables->listCount, sizeof(ListRow), compareRowIds);
+    if (list == NULL || list->boardIndex < 0) {
+        return 0;
+    }
+    if (!matchesQuery(query, tables, list, fields)) {
+        return 1;
+    }
+    if (!query->listing) {
+        counts[taskGroup(query, tables, list, fields)]++;
+        return 1;
+    }
+    const BoardRow* board = &tables->boards[list->boardIndex];
+    printCsvField(board->username, 0);
+    printCsvField(board->name, 0);
+    printCsvField(list->name, 0);
+    for (int i = TASK_ID; i <= TASK_DATE; i++) {
+        printCsvField(fields[i], i == TASK_DATE);
+    }
+    return 1;
+}
+
+// One pass over tasks.csv: matching tasks are printed as they are read, or counted
+static int runQuery(const Query* query, const QueryTables* tables, FILE* tasksFile) {
+    DataReader reader;
+    unsigned long* counts = NULL;
+    if (!query->listing) {
+        counts = calloc(groupCount(query, tables) + 1, sizeof(unsigned long));
+        if (counts == NULL) {
+            perror("Memory allocation failed for the counts");
+            return 0;
+        }
+    }
+    if (!startReader(&reader, tasksFile)) {
+        free(counts);
+        return 0;
+    }
+    if (query->listing) {
+        printf("\"User\",\"Board\",\"List\",\"Task ID\",\"Task Name\",\"Priority\",\"Date\"\n");
+    }
+
+    unsigned long orphans = 0;
+    int ok = 1;
+    char* line;
+    while ((line = nextRecord(&reader)) != NULL) {
+        int fieldCount;
+        char** fields = parseCSVLine(line, &fieldCount);
+        if (fields == NULL) {
+            ok = 0;
+            break;
+        }
+        if (fieldCount >= TASK_FIELDS && !queryTask(query, tables, fields, counts)) {
+            orphans++;
+        }
+        free(fields);
+    }
+    endReader(&reader);
+
+    if (!query->listing) {
+        printCounts(query, tables, counts);
+        free(counts);
+    }
+    if (orphans > 0) {
+        fprintf(stderr, "%lu tasks belong to no known list and were left out.\n", orphans);
+    }
+    return ok;
+}
+
+static void printUsage() {
+    fprintf(stderr, "Usage: utboard-query [--dir PATH] count|list [by user|board|list|priority] [where CONDITION...]\n"
+                    "Conditions: user=NAME board=NAME list=NAME priority=LEVEL before=YYYY-MM-DD\n"
+                    "            after=YYYY-MM-DD overdue name~TEXT\n");
+}
+
+int main(int argc, char* argv[]) {
+    const char* dir = ".";
+    int first = 1;
+    if (argc > 2 && strcmp(argv[1], "--dir") == 0) {
+        dir = argv[2];
+        first = 3;
+    }
+    Query query;
+    if (!parseQuery(&query, argc - first, argv + first)) {
+        printUsage();
+        return 1;
+    }
+
+    QueryTables tables;
+    memset(&tables, 0, sizeof(tables));
+    FILE* tasksFile = openSnapshot(dir, &tables);
+    if (tasksFile == NULL) {
+        return 1;
+    }
+    int ok = runQuery(&query, &tables, tasksFile);
+    fclose(tasksFile);
+    freeTables(&tables);
+    return ok ? 0 : 1;
+}
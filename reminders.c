@@ -0,0 +1,278 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "functions.h"
+
+// Deadline reminders on a hierarchical timer wheel counted in days. Every task in the working
+// set has one pending reminder for its next event: "due tomorrow" the day before the deadline,
+// "due today" on the day and "overdue" the day after. Level 0 has a slot for each of the next
+// 64 days, level 1 one for each of the next 64 blocks of 64 days and level 2 one for blocks of
+// 4096 days; reminders move down a level when their block comes up. Advancing a day empties one
+// slot per level at most, so a tick costs the same however many tasks are waiting.
+// The wheel always runs, as the task counts (aggregates.c) learn from it when tasks become
+// overdue; --reminders only adds a log of the events.
+
+#define WHEEL_BITS 6
+#define WHEEL_SLOTS (1 << WHEEL_BITS)
+#define WHEEL_LEVELS 3
+
+// Slots are circular lists with a sentinel node, so a reminder unlinks itself without knowing
+// which slot it is in
+typedef struct Reminder {
+    Task* task;
+    long day;            // Day the event fires, counted from 1970-01-01
+    ReminderEvent event;
+    struct Reminder* prev;
+    struct Reminder* next;
+} Reminder;
+
+static const char* eventNames[] = { "due tomorrow", "due today", "overdue" };
+
+static Reminder wheel[WHEEL_LEVELS][WHEEL_SLOTS];
+static Reminder firingNow; // Events of days that have already been ticked, fired on the next tick
+static long currentDay = 0; // Last day the wheel has advanced to
+static int wheelStarted = 0;
+static FILE* reminderLog = NULL;
+static ReminderHook reminderHook = NULL;
+
+// Days since 1970-01-01 of a civil date (Howard Hinnant's days_from_civil)
+static long daysFromCivil(int year, int month, int day) {
+    year -= month <= 2;
+    long era = (year >= 0 ? year : year - 399) / 400;
+    long yearOfEra = year - era * 400;
+    long dayOfYear = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    long dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+    return era * 146097 + dayOfEra - 719468;
+}
+
+// Day number of a date, or -1 if parseDate does not accept the text
+long dateToDay(const char* date) {
+    int year, month, day;
+    if (!parseDate(date, &year, &month, &day)) {
+        return -1;
+    }
+    return daysFromCivil(year, month, day);
+}
+
+// Writes the day as "YYYY-MM-DD" (Howard Hinnant's civil_from_days)
+void dayToDate(long day, char* date) {
+    day += 719468;
+    long era = (day >= 0 ? day : day - 146096) / 146097;
+    long dayOfEra = day - era * 146097;
+    long yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+    long dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+    long shiftedMonth = (5 * dayOfYear + 2) / 153;
+    long month = shiftedMonth < 10 ? shiftedMonth + 3 : shiftedMonth - 9;
+    long year = yearOfEra + era * 400 + (month <= 2);
+    sprintf(date, "%04ld-%02ld-%02ld", year, month, dayOfYear - (153 * shiftedMonth + 2) / 5 + 1);
+}
+
+static long localDay() {
+    time_t now = time(NULL);
+    struct tm* now_tm = localtime(&now);
+    return daysFromCivil(now_tm->tm_year + 1900, now_tm->tm_mon + 1, now_tm->tm_mday);
+}
+
+static void emptySlot(Reminder* slot) {
+    slot->prev = slot->next = slot;
+}
+
+static void linkReminder(Reminder* slot, Reminder* reminder) {
+    reminder->prev = slot;
+    reminder->next = slot->next;
+    slot->next->prev = reminder;
+    slot->next = reminder;
+}
+
+static void unlinkReminder(Reminder* reminder) {
+    reminder->prev->next = reminder->next;
+    reminder->next->prev = reminder->prev;
+}
+
+// Files the reminder in the slot of the lowest level whose range reaches its day
+static void placeReminder(Reminder* reminder) {
+    long delta = reminder->day - currentDay;
+    if (delta <= 0) {
+        linkReminder(&firingNow, reminder);
+        return;
+    }
+    for (int level = 0; level < WHEEL_LEVELS; level++) {
+        int shift = level * WHEEL_BITS;
+        if (delta < (1L << (shift + WHEEL_BITS))) {
+            linkReminder(&wheel[level][(reminder->day >> shift) & (WHEEL_SLOTS - 1)], reminder);
+            return;
+        }
+    }
+    // Further out than the wheel reaches: park it in the last block, which files it again
+    int shift = (WHEEL_LEVELS - 1) * WHEEL_BITS;
+    linkReminder(&wheel[WHEEL_LEVELS - 1][((currentDay >> shift) - 1) & (WHEEL_SLOTS - 1)], reminder);
+}
+
+// Schedules the first of the task's events, from the given one on, that has not gone by.
+// Returns 0 when there is none left, and the reminder is then no longer needed.
+static int placeNextEvent(Reminder* reminder, ReminderEvent event) {
+    long deadline = dateToDay(reminder->task->date);
+    if (deadline < 0) {
+        return 0;
+    }
+    for (; event <= REMINDER_OVERDUE; event++) {
+        long day = deadline + (long)event - REMINDER_DUE_TODAY;
+        if (day >= currentDay) {
+            reminder->day = day;
+            reminder->event = event;
+            placeReminder(reminder);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static void fireReminder(Reminder* reminder) {
+    Task* task = reminder->task;
+    if (reminderLog != NULL) {
+        char stamp[20];
+        time_t now = time(NULL);
+        strftime(stamp, sizeof(stamp), "%Y-%m-%d %H:%M", localtime(&now));
+        const List* list = task->list;
+        fprintf(reminderLog, "%s %s: %s (#%ld), deadline %s, in %s/%s of %s\n", stamp,
+                eventNames[reminder->event], task->name, task->id, task->date, list->board->name,
+                list->name, list->board->user->username);
+        fflush(reminderLog);
+    }
+    if (reminder->event == REMINDER_OVERDUE) {
+        markTaskOverdue(task);
+    }
+    if (reminderHook != NULL) {
+        reminderHook(reminder->event, task);
+    }
+    if (!placeNextEvent(reminder, reminder->event + 1)) {
+        task->reminder = NULL;
+        free(reminder);
+    }
+}
+
+static void fireSlot(Reminder* slot) {
+    Reminder due;
+    if (slot->next == slot) {
+        return;
+    }
+    // Move the slot's reminders aside first, as firing files the next events
+    due.next = slot->next;
+    due.prev = slot->prev;
+    due.next->prev = &due;
+    due.prev->next = &due;
+    emptySlot(slot);
+    while (due.next != &due) {
+        Reminder* reminder = due.next;
+        unlinkReminder(reminder);
+        fireReminder(reminder);
+    }
+}
+
+// Files the reminders of a higher level slot again, now that its block has come up
+static void cascadeSlot(Reminder* slot) {
+    Reminder moving;
+    if (slot->next == slot) {
+        return;
+    }
+    moving.next = slot->next;
+    moving.prev = slot->prev;
+    moving.next->prev = &moving;
+    moving.prev->next = &moving;
+    emptySlot(slot);
+    while (moving.next != &moving) {
+        Reminder* reminder = moving.next;
+        unlinkReminder(reminder);
+        placeReminder(reminder);
+    }
+}
+
+static void startWheel() {
+    for (int level = 0; level < WHEEL_LEVELS; level++) {
+        for (int slot = 0; slot < WHEEL_SLOTS; slot++) {
+            emptySlot(&wheel[level][slot]);
+        }
+    }
+    emptySlot(&firingNow);
+    currentDay = localDay();
+    wheelStarted = 1;
+}
+
+// Day the wheel has reached: tasks due before it count as overdue
+long reminderDay() {
+    if (!wheelStarted) {
+        startWheel();
+    }
+    return currentDay;
+}
+
+// Writes every event to log as it fires; NULL stops the log
+void setReminderLog(FILE* log) {
+    reminderLog = log;
+}
+
+// Called with every event as it fires, after it is logged; the hook must not change any task
+void setReminderHook(ReminderHook hook) {
+    reminderHook = hook;
+}
+
+// Schedules the task's next event from its deadline, replacing the one it had
+void scheduleReminder(Task* task) {
+    if (!wheelStarted) {
+        startWheel();
+    }
+    Reminder* reminder = task->reminder;
+    if (reminder != NULL) {
+        unlinkReminder(reminder);
+    } else {
+        reminder = malloc(sizeof(Reminder));
+        if (reminder == NULL) {
+            perror("Memory allocation failed for reminder");
+            return;
+        }
+        reminder->task = task;
+    }
+    if (placeNextEvent(reminder, REMINDER_DUE_TOMORROW)) {
+        task->reminder = reminder;
+    } else {
+        task->reminder = NULL;
+        free(reminder);
+    }
+}
+
+void cancelReminder(Task* task) {
+    if (task->reminder != NULL) {
+        unlinkReminder(task->reminder);
+        free(task->reminder);
+        task->reminder = NULL;
+    }
+}
+
+// Fires the events that have come due by today
+void tickReminders() {
+    if (wheelStarted) {
+        advanceReminders(localDay());
+    }
+}
+
+// Fires the events that have come due by day: the ones filed for a day already reached, then the
+// wheel day by day up to day. tickReminders passes today; the tests pass days to come.
+void advanceReminders(long day) {
+    if (!wheelStarted) {
+        startWheel();
+    }
+    fireSlot(&firingNow);
+    while (currentDay < day) {
+        currentDay++;
+        // Highest level first, so that what comes down lands in slots not yet emptied today
+        for (int level = WHEEL_LEVELS - 1; level > 0; level--) {
+            int shift = level * WHEEL_BITS;
+            if ((currentDay & ((1L << shift) - 1)) == 0) {
+                cascadeSlot(&wheel[level][(currentDay >> shift) & (WHEEL_SLOTS - 1)]);
+            }
+        }
+        fireSlot(&wheel[0][currentDay & (WHEEL_SLOTS - 1)]);
+        fireSlot(&firingNow);
+    }
+}
@@ -0,0 +1,364 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <limits.h>
+#include <windows.h>
+#include "functions.h"
+
+// Screen rendering for the menus. A menu describes its whole screen as a frame: beginFrame, then
+// screenPrintf for every line, then presentFrame. On a console, presentFrame compares the frame
+// with the lines already on the console and rewrites only the ones that differ, positioning the
+// cursor with ANSI sequences and sending everything in one write; nothing is cleared and nothing
+// waits. Prompts, input and the output of the last action go below the frame: the next frame
+// reads that output back from the console and keeps it under the new frame, so results stay on
+// screen. When stdout is not a console (scripted runs, the replay benchmark) frames are printed
+// as plain text one after the other.
+
+#define PROMPT_AREA_ROWS 7  // Rows kept below a frame for the prompt and the last action's output
+
+typedef struct Frame {
+    char* text;         // Built with screenPrintf; split into lines in place when presented
+    size_t length;
+    size_t capacity;
+    size_t* lines;      // Offsets of the lines in text
+    int lineCount;
+    int lineCapacity;
+} Frame;
+
+static Frame frames[2];
+static Frame* building = NULL; // Open frame, NULL between presentFrame and beginFrame
+static Frame* shown = &frames[1]; // Lines on the console, frame and kept output together
+static int shownValid = 0;   // Whether shown still matches the console
+static SHORT inputRow = -1;  // Console row of the last input, or the last row of shown; -1 if unknown
+static SHORT inputTop = 0;   // Window top when inputRow was taken
+
+static HANDLE console = NULL;
+static int consoleChecked = 0;
+static int diffRendering = 1;
+
+static char* output = NULL;  // Escape sequences and text of one present
+static size_t outputLength = 0;
+static size_t outputCapacity = 0;
+
+static int viewportTop = 0;
+static int viewportRows = 0; // Rows the last viewport showed, 0 when it showed everything
+
+// The console stdout writes to, with ANSI sequences turned on, or NULL when there is none
+static HANDLE renderConsole() {
+    if (!diffRendering) {
+        return NULL;
+    }
+    if (!consoleChecked) {
+        consoleChecked = 1;
+        HANDLE handle = GetStdHandle(STD_OUTPUT_HANDLE);
+        DWORD mode;
+        if (handle != INVALID_HANDLE_VALUE && handle != NULL && GetConsoleMode(handle, &mode) &&
+            SetConsoleMode(handle, mode | ENABLE_VIRTUAL_TERMINAL_PROCESSING)) {
+            console = handle;
+        }
+    }
+    return console;
+}
+
+// Replays turn this off, so frames are printed as plain text even when a console is attached
+void setDiffRendering(int enabled) {
+    diffRendering = enabled;
+    shownValid = 0;
+}
+
+static int growText(Frame* frame, size_t needed) {
+    if (frame->length + needed + 1 <= frame->capacity) {
+        return 1;
+    }
+    size_t capacity = frame->capacity ? frame->capacity : 4096;
+    while (frame->length + needed + 1 > capacity) {
+        capacity *= 2;
+    }
+    char* grown = realloc(frame->text, capacity);
+    if (grown == NULL) {
+        perror("Memory allocation failed for the screen");
+        return 0;
+    }
+    frame->text = grown;
+    frame->capacity = capacity;
+    return 1;
+}
+
+static const char* frameLine(const Frame* frame, int row) {
+    return frame->text + frame->lines[row];
+}
+
+static int addLine(Frame* frame, size_t start) {
+    if (frame->lineCount == frame->lineCapacity) {
+        int capacity = frame->lineCapacity ? frame->lineCapacity * 2 : 128;
+        size_t* grown = realloc(frame->lines, capacity * sizeof(size_t));
+        if (grown == NULL) {
+            perror("Memory allocation failed for the screen");
+            return 0;
+        }
+        frame->lines = grown;
+        frame->lineCapacity = capacity;
+    }
+    frame->lines[frame->lineCount++] = start;
+    return 1;
+}
+
+void beginFrame() {
+    building = shown == &frames[0] ? &frames[1] : &frames[0];
+    building->length = 0;
+    building->lineCount = 0;
+}
+
+// Adds to the open frame, or prints straight away when no frame is being built, so the display
+// functions serve the menus and the commands alike
+void screenPrintf(const char* format, ...) {
+    va_list args;
+    if (building == NULL) {
+        va_start(args, format);
+        vprintf(format, args);
+        va_end(args);
+        return;
+    }
+    va_start(args, format);
+    int needed = vsnprintf(NULL, 0, format, args);
+    va_end(args);
+    if (needed <= 0 || !growText(building, (size_t)needed)) {
+        return;
+    }
+    va_start(args, format);
+    vsnprintf(building->text + building->length, (size_t)needed + 1, format, args);
+    va_end(args);
+    building->length += (size_t)needed;
+}
+
+static void appendOutput(const char* text, size_t length) {
+    if (outputLength + length > outputCapacity) {
+        size_t capacity = outputCapacity ? outputCapacity : 8192;
+        while (outputLength + length > capacity) {
+            capacity *= 2;
+        }
+        char* grown = realloc(output, capacity);
+        if (grown == NULL) {
+            return; // The frame comes out incomplete and the next one is drawn in full
+        }
+        output = grown;
+        outputCapacity = capacity;
+    }
+    memcpy(output + outputLength, text, length);
+    outputLength += length;
+}
+
+static void moveCursor(int row) {
+    char sequence[24];
+    appendOutput(sequence, (size_t)snprintf(sequence, sizeof(sequence), "\x1b[%d;1H", row + 1));
+}
+
+// Cuts the frame text into lines in place
+static void splitFrame(Frame* frame) {
+    size_t start = 0;
+    frame->lineCount = 0;
+    if (frame->length == 0) {
+        return;
+    }
+    frame->text[frame->length] = '\0';
+    for (size_t i = 0; i < frame->length; i++) {
+        if (frame->text[i] == '\n') {
+            frame->text[i] = '\0';
+            addLine(frame, start);
+            start = i + 1;
+        }
+    }
+    if (start < frame->length) {
+        addLine(frame, start);
+        frame->length++; // Keeps the terminator of the last line
+    }
+}
+
+// Puts the line breaks back, undoing splitFrame
+static void joinFrame(Frame* frame, size_t length) {
+    for (int i = 0; i < frame->lineCount; i++) {
+        char* line = frame->text + frame->lines[i];
+        line[strlen(line)] = '\n';
+    }
+    frame->length = length;
+}
+
+// Reads the console rows from first to last and adds them to the frame as lines
+static void keepConsoleRows(Frame* frame, SHORT first, SHORT last, int width) {
+    if (first > last) {
+        return;
+    }
+    if (!growText(frame, (size_t)(last - first + 1) * (width + 1))) {
+        return;
+    }
+    for (SHORT row = first; row <= last; row++) {
+        char* line = frame->text + frame->length;
+        COORD from = { 0, row };
+        DWORD read = 0;
+        if (!ReadConsoleOutputCharacterA(console, line, (DWORD)width, from, &read)) {
+            read = 0;
+        }
+        while (read > 0 && line[read - 1] == ' ') {
+            read--;
+        }
+        line[read] = '\0';
+        addLine(frame, frame->length);
+        frame->length += read + 1;
+    }
+}
+
+static void writeOutput() {
+    fwrite(output, 1, outputLength, stdout);
+    fflush(stdout);
+    outputLength = 0;
+}
+
+// Prints the frame as it is, for when it cannot be placed on the screen
+static void printFramePlain(Frame* frame) {
+    fwrite(frame->text, 1, frame->length, stdout);
+    fflush(stdout);
+}
+
+void presentFrame() {
+    Frame* frame = building;
+    building = NULL;
+    if (frame == NULL) {
+        return;
+    }
+    CONSOLE_SCREEN_BUFFER_INFO info;
+    fflush(stdout); // The cursor position must include the prompts printed since the last frame
+    if (renderConsole() == NULL || !GetConsoleScreenBufferInfo(console, &info)) {
+        printFramePlain(frame);
+        shownValid = 0;
+        return;
+    }
+    int width = info.srWindow.Right - info.srWindow.Left + 1;
+    int height = info.srWindow.Bottom - info.srWindow.Top + 1;
+    SHORT top = info.srWindow.Top;
+    SHORT cursor = info.dwCursorPosition.Y;
+    // Output that reached the bottom row may have scrolled the window, and then the rows the
+    // last frame and the input were on are not known any more
+    int scrolled = top != inputTop || cursor >= info.srWindow.Bottom;
+    SHORT firstKept = inputRow + 1;
+    SHORT lastKept = info.dwCursorPosition.X > 0 ? cursor : cursor - 1;
+
+    size_t frameLength = frame->length;
+    splitFrame(frame);
+    int room = height - frame->lineCount - 2; // Rows left for kept output, with the prompt row and a spare
+    if (frame->lineCount > height - 2 || (shownValid && (scrolled || lastKept - firstKept + 1 > room))) {
+        // The frame is too tall, or the output since the last one scrolled the window or does not
+        // fit under this one: print the frame after it, and draw the next one on a clean screen
+        joinFrame(frame, frameLength);
+        printFramePlain(frame);
+        shownValid = 0;
+        inputRow = -1;
+        return;
+    }
+    if (inputRow >= 0 && !scrolled && room > 0) {
+        if (lastKept - firstKept + 1 > room) {
+            firstKept = lastKept - room + 1;
+        }
+        keepConsoleRows(frame, firstKept, lastKept, width);
+    }
+
+    if (!shownValid) {
+        appendOutput("\x1b[H\x1b[J", 6);
+    }
+    for (int row = 0; row < frame->lineCount; row++) {
+        const char* line = frameLine(frame, row);
+        if (shownValid && row < shown->lineCount && strcmp(line, frameLine(shown, row)) == 0) {
+            continue;
+        }
+        size_t length = strlen(line);
+        if (length > (size_t)width - 1) {
+            length = (size_t)width - 1; // A wrapped line would push every row below it down
+        }
+        moveCursor(row);
+        appendOutput(line, length);
+        appendOutput("\x1b[K", 3);
+    }
+    moveCursor(frame->lineCount);
+    appendOutput("\x1b[J", 3);
+    writeOutput();
+
+    shown = frame;
+    shownValid = 1;
+    inputTop = top;
+    inputRow = top + frame->lineCount - 1; // Output from here on is kept until input is read
+}
+
+// Called before every line of input is read: the output the next frame keeps is what follows it
+void markInputRow() {
+    CONSOLE_SCREEN_BUFFER_INFO info;
+    if (renderConsole() == NULL) {
+        return;
+    }
+    fflush(stdout);
+    if (GetConsoleScreenBufferInfo(console, &info)) {
+        inputRow = info.dwCursorPosition.Y;
+        inputTop = info.srWindow.Top;
+    }
+}
+
+// Rows a menu can fill and still leave room for its prompt, or 0 when the screen size is unknown
+// and lists are shown in full
+int screenRows() {
+    CONSOLE_SCREEN_BUFFER_INFO info;
+    if (renderConsole() == NULL || !GetConsoleScreenBufferInfo(console, &info)) {
+        return 0;
+    }
+    int rows = info.srWindow.Bottom - info.srWindow.Top + 1 - PROMPT_AREA_ROWS;
+    return rows > 0 ? rows : 1;
+}
+
+// The viewport shows a longer list rows items at a time, in pages that start at multiples of
+// rows. Returns the first item to show after keeping the viewport on a page of the list; rows 0
+// means the whole list is shown.
+int placeViewport(int total, int rows) {
+    viewportRows = rows > 0 && rows < total ? rows : 0;
+    if (viewportRows == 0 || viewportTop < 0) {
+        viewportTop = 0;
+    } else if (viewportTop >= total) {
+        viewportTop = (total - 1) / viewportRows * viewportRows;
+    } else {
+        viewportTop = viewportTop / viewportRows * viewportRows; // The page size follows the window
+    }
+    return viewportTop;
+}
+
+// Moves the viewport by whole pages; returns 0 if the last viewport showed the whole list
+int scrollViewport(int pages) {
+    if (viewportRows == 0) {
+        return 0;
+    }
+    long long top = viewportTop + (long long)pages * viewportRows;
+    viewportTop = top < 0 ? 0 : top > INT_MAX ? INT_MAX : (int)top; // Kept within the list when placed
+    return 1;
+}
+
+// Moves the viewport to the 1-based page; returns 0 if the last viewport showed the whole list
+int jumpViewport(int page) {
+    if (viewportRows == 0) {
+        return 0;
+    }
+    long long top = (long long)(page - 1) * viewportRows;
+    viewportTop = top > INT_MAX ? INT_MAX : (int)top;
+    return 1;
+}
+
+void resetViewport() {
+    viewportTop = 0;
+}
+
+void freeScreen() {
+    for (int i = 0; i < 2; i++) {
+        free(frames[i].text);
+        free(frames[i].lines);
+        memset(&frames[i], 0, sizeof(Frame));
+    }
+    free(output);
+    output = NULL;
+    outputLength = outputCapacity = 0;
+    shownValid = 0;
+}
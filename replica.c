@@ -0,0 +1,356 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <winsock2.h>
+#include <afunix.h>
+#include <windows.h>
+#include "functions.h"
+
+// Hot standby over a local socket (AF_UNIX, Windows 10 1803 and later; link with ws2_32). A
+// primary started with --replicate PATH connects to a standby started with --standby PATH and
+// streams it the change feed of changes.c: every record when it connects, then, before each
+// line of input is read, what the last action changed. The standby applies each batch to its
+// own model under the primary's sequence numbers, so its records, IDs and tombstones match the
+// primary's at every batch boundary. A primary that exits says so after its final save, and the
+// standby waits for the next one; a primary that gives up on its standby says so too, and the
+// standby exits. When the connection drops without either, the standby makes sure the primary
+// is gone before it takes over: while it replicates, a primary holds PATH.lock open without
+// sharing, which the system lets go of only when the primary's process ends. A standby that can
+// open the lock itself takes over and runs the session on the model it already holds, without
+// loading the data files, and saves them on exit as the primary would have; one that cannot
+// exits. Run it in the primary's directory to take over its data files. The archive is not part
+// of the change feed; archived tasks stay in the primary's archive.csv.
+//
+// Messages, each a header line, the batch following its header:
+//   CHANGES <sequence> <bytes>  lines as writeChangesSince writes them, up to sequence
+//   BYE <sequence>              the primary saved and exited
+//   DETACH                      the primary carries on without a standby
+
+#define HEADER_MAX 64
+#define LOCK_TRIES 50   // A dead primary's lock may outlive its socket by a moment, so it is
+#define LOCK_WAIT_MS 100 // tried this many times this far apart
+
+// How following a primary ended
+typedef enum {
+    FOLLOW_NEXT_PRIMARY, // It shut down; wait for the next one
+    FOLLOW_EXIT,         // It carries on without this standby, or the stream broke on this side
+    FOLLOW_TAKE_OVER     // It died
+} FollowResult;
+
+static SOCKET standbySocket = INVALID_SOCKET; // The primary's connection to its standby
+static HANDLE primaryLock = INVALID_HANDLE_VALUE; // Held from startReplication until the primary exits
+static char primaryLockPath[FILENAME_MAX];
+static User** replicatedUsers = NULL;
+static DataWriter batch;                      // Reused for every batch
+static long shippedSequence = -1;             // Changes up to this number have been sent
+
+static int startSockets() {
+    WSADATA data;
+    if (WSAStartup(MAKEWORD(2, 2), &data) != 0) {
+        fprintf(stderr, "Unable to start Windows Sockets.\n");
+        return 0;
+    }
+    return 1;
+}
+
+static int fillAddress(SOCKADDR_UN* address, const char* path) {
+    memset(address, 0, sizeof(SOCKADDR_UN));
+    address->sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(address->sun_path)) {
+        fprintf(stderr, "The socket path '%s' is too long.\n", path);
+        return 0;
+    }
+    strcpy(address->sun_path, path);
+    return 1;
+}
+
+static int sendAll(SOCKET socket, const char* data, size_t length) {
+    while (length > 0) {
+        int sent = send(socket, data, length > INT_MAX ? INT_MAX : (int)length, 0);
+        if (sent == SOCKET_ERROR || sent == 0) {
+            return 0;
+        }
+        data += sent;
+        length -= (size_t)sent;
+    }
+    return 1;
+}
+
+static int receiveAll(SOCKET socket, char* data, size_t length) {
+    while (length > 0) {
+        int received = recv(socket, data, length > INT_MAX ? INT_MAX : (int)length, 0);
+        if (received == SOCKET_ERROR || received == 0) {
+            return 0;
+        }
+        data += received;
+        length -= (size_t)received;
+    }
+    return 1;
+}
+
+// Reads a header line without its '\n'; returns 0 when the connection is closed or broken
+static int receiveLine(SOCKET socket, char* line, size_t size) {
+    size_t length = 0;
+    while (length + 1 < size) {
+        char ch;
+        if (recv(socket, &ch, 1, 0) != 1) {
+            return 0;
+        }
+        if (ch == '\n') {
+            line[length] = '\0';
+            return 1;
+        }
+        line[length++] = ch;
+    }
+    return 0; // Longer than any header
+}
+
+static HANDLE openLock(const char* path) {
+    return CreateFile(path, GENERIC_WRITE, 0, NULL, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+}
+
+static void releasePrimaryLock() {
+    if (primaryLock != INVALID_HANDLE_VALUE) {
+        CloseHandle(primaryLock);
+        primaryLock = INVALID_HANDLE_VALUE;
+        DeleteFile(primaryLockPath);
+    }
+}
+
+// Ends replication after the standby went away or could not be kept up to date; the session
+// carries on without one. The standby is told, so that it exits rather than taking over, and
+// the lock stays held until the primary exits in case the message does not get through.
+static void dropStandby(const char* reason) {
+    fprintf(stderr, "%s; carrying on without a standby.\n", reason);
+    sendAll(standbySocket, "DETACH\n", 7);
+    closesocket(standbySocket);
+    standbySocket = INVALID_SOCKET;
+    closeDataWriter(&batch);
+    WSACleanup();
+}
+
+// Connects to the standby listening on path and sends it every record. Returns 0 if there is
+// no standby, and the session then runs without one.
+int startReplication(const char* path, User** users) {
+    SOCKADDR_UN address;
+    if (!fillAddress(&address, path)) {
+        return 0;
+    }
+    snprintf(primaryLockPath, sizeof(primaryLockPath), "%s.lock", path);
+    primaryLock = openLock(primaryLockPath);
+    if (primaryLock == INVALID_HANDLE_VALUE) {
+        fprintf(stderr, "Unable to lock %s (error %lu), is another primary using it? Running without a standby.\n",
+                primaryLockPath, (unsigned long)GetLastError());
+        return 0;
+    }
+    if (!startSockets()) {
+        releasePrimaryLock();
+        return 0;
+    }
+    standbySocket = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (standbySocket == INVALID_SOCKET ||
+        connect(standbySocket, (struct sockaddr*)&address, sizeof(address)) == SOCKET_ERROR) {
+        fprintf(stderr, "No standby is listening on %s (error %d); running without one.\n", path, WSAGetLastError());
+        if (standbySocket != INVALID_SOCKET) {
+            closesocket(standbySocket);
+            standbySocket = INVALID_SOCKET;
+        }
+        WSACleanup();
+        releasePrimaryLock();
+        return 0;
+    }
+    if (!openMemoryWriter(&batch)) {
+        dropStandby("Memory allocation failed for the change batches");
+        return 0;
+    }
+    replicatedUsers = users;
+    shippedSequence = -1; // Everything, records from before sequence numbers included
+    shipChanges();
+    return standbySocket != INVALID_SOCKET;
+}
+
+// Sends the standby what changed since the last batch; called before every line of input
+void shipChanges() {
+    if (standbySocket == INVALID_SOCKET || currentChangeSequence() == shippedSequence) {
+        return;
+    }
+    batch.length = 0;
+    batch.recordFields = 0;
+    writeChangesSince(&batch, *replicatedUsers, shippedSequence);
+    if (batch.failed) {
+        dropStandby("Memory allocation failed for a change batch");
+        return;
+    }
+    char header[HEADER_MAX];
+    long sequence = currentChangeSequence();
+    int headerLength = snprintf(header, sizeof(header), "CHANGES %ld %lu\n", sequence, (unsigned long)batch.length);
+    if (!sendAll(standbySocket, header, (size_t)headerLength) || !sendAll(standbySocket, batch.buffer, batch.length)) {
+        dropStandby("The standby stopped taking changes");
+        return;
+    }
+    shippedSequence = sequence;
+}
+
+// Changes up to this number have reached the standby, so it needs no tombstone up to it; without
+// a standby none is needed
+long replicatedSequence() {
+    return standbySocket != INVALID_SOCKET ? shippedSequence : LONG_MAX;
+}
+
+// Sends the last changes and tells the standby the primary is done; call after the final save
+void stopReplication() {
+    shipChanges();
+    if (standbySocket != INVALID_SOCKET) {
+        char header[HEADER_MAX];
+        int headerLength = snprintf(header, sizeof(header), "BYE %ld\n", currentChangeSequence());
+        sendAll(standbySocket, header, (size_t)headerLength);
+        closesocket(standbySocket);
+        standbySocket = INVALID_SOCKET;
+        closeDataWriter(&batch);
+        WSACleanup();
+    }
+    releasePrimaryLock();
+}
+
+// Applies the lines of one batch; text is changed in place
+static long applyBatch(char* text, size_t length) {
+    long failed = 0;
+    char* end = text + length;
+    while (text < end) {
+        char* newline = memchr(text, '\n', (size_t)(end - text));
+        char* next = newline != NULL ? newline + 1 : end;
+        if (newline != NULL) {
+            *newline = '\0';
+        }
+        if (*text != '\0') {
+            int fieldCount = 0;
+            char** fields = parseCSVLine(text, &fieldCount);
+            if (fields == NULL || !applyChangeRecord(fields, fieldCount)) {
+                failed++;
+            }
+            free(fields);
+        }
+        text = next;
+    }
+    return failed;
+}
+
+// Whether the primary that replicated to path still runs. Its process may close the socket a
+// moment before the system lets go of its lock, so a held lock is tried again for a while; a
+// lock that cannot be checked counts as held.
+static int primaryIsAlive(const char* path) {
+    char lockPath[FILENAME_MAX];
+    snprintf(lockPath, sizeof(lockPath), "%s.lock", path);
+    for (int i = 0; i < LOCK_TRIES; i++) {
+        HANDLE lock = openLock(lockPath);
+        if (lock != INVALID_HANDLE_VALUE) {
+            CloseHandle(lock);
+            DeleteFile(lockPath);
+            return 0;
+        }
+        if (GetLastError() != ERROR_SHARING_VIOLATION) {
+            fprintf(stderr, "Standby: unable to check the primary's lock %s (error %lu).\n", lockPath,
+                    (unsigned long)GetLastError());
+            return 1;
+        }
+        Sleep(LOCK_WAIT_MS);
+    }
+    return 1;
+}
+
+// Applies the batches of one primary until it goes
+static FollowResult followPrimary(SOCKET primary, const char* path, char** text, size_t* capacity) {
+    char header[HEADER_MAX];
+    long batches = 0;
+    while (receiveLine(primary, header, sizeof(header))) {
+        long sequence;
+        unsigned long length;
+        if (sscanf(header, "BYE %ld", &sequence) == 1) {
+            printf("Standby: the primary shut down at sequence %ld.\n", sequence);
+            return FOLLOW_NEXT_PRIMARY;
+        }
+        if (strcmp(header, "DETACH") == 0) {
+            printf("Standby: the primary carries on without a standby at sequence %ld; exiting.\n",
+                   currentChangeSequence());
+            return FOLLOW_EXIT;
+        }
+        if (sscanf(header, "CHANGES %ld %lu", &sequence, &length) != 2) {
+            fprintf(stderr, "Standby: unexpected message '%s' from the primary, exiting.\n", header);
+            return FOLLOW_EXIT;
+        }
+        if (length + 1 > *capacity) {
+            char* grown = realloc(*text, length + 1);
+            if (grown == NULL) {
+                perror("Memory allocation failed for a change batch");
+                return FOLLOW_EXIT;
+            }
+            *text = grown;
+            *capacity = length + 1;
+        }
+        if (!receiveAll(primary, *text, length)) {
+            break; // The batch is dropped whole, so the model stays at the last batch boundary
+        }
+        (*text)[length] = '\0';
+        long failed = applyBatch(*text, length);
+        noteLoadedChange(sequence, NULL, NULL, NULL);
+        if (failed > 0) {
+            fprintf(stderr, "Standby: %ld change(s) up to sequence %ld could not be applied.\n", failed, sequence);
+        }
+        if (batches++ == 0) {
+            size_t users, boards, lists, tasks, indexBytes;
+            getEntityCounts(&users, &boards, &lists, &tasks, &indexBytes);
+            printf("Standby: copied %lu users, %lu boards, %lu lists and %lu tasks from the primary.\n",
+                   (unsigned long)users, (unsigned long)boards, (unsigned long)lists, (unsigned long)tasks);
+            fflush(stdout);
+        }
+    }
+    if (primaryIsAlive(path)) {
+        printf("Standby: lost the primary at sequence %ld but it is still running; exiting.\n",
+               currentChangeSequence());
+        return FOLLOW_EXIT;
+    }
+    printf("Standby: the primary died at sequence %ld; taking over.\n", currentChangeSequence());
+    return FOLLOW_TAKE_OVER;
+}
+
+// Follows primaries on path until one dies, then returns 1 with users holding the model to
+// take over with. Returns 0 if the socket could not be set up, or if a primary detached or
+// lost its connection while still running.
+int runStandby(const char* path, User** users) {
+    SOCKADDR_UN address;
+    if (!fillAddress(&address, path) || !startSockets()) {
+        return 0;
+    }
+    remove(path); // Left behind by a standby that did not exit cleanly
+    SOCKET listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listener == INVALID_SOCKET || bind(listener, (struct sockaddr*)&address, sizeof(address)) == SOCKET_ERROR ||
+        listen(listener, 1) == SOCKET_ERROR) {
+        fprintf(stderr, "Unable to listen on %s (error %d).\n", path, WSAGetLastError());
+        if (listener != INVALID_SOCKET) {
+            closesocket(listener);
+        }
+        WSACleanup();
+        return 0;
+    }
+    char* text = NULL;
+    size_t capacity = 0;
+    FollowResult result = FOLLOW_NEXT_PRIMARY;
+    while (result == FOLLOW_NEXT_PRIMARY) {
+        printf("Standby: waiting for a primary on %s.\n", path);
+        fflush(stdout);
+        SOCKET primary = accept(listener, NULL, NULL);
+        if (primary == INVALID_SOCKET) {
+            fprintf(stderr, "Unable to accept a primary (error %d).\n", WSAGetLastError());
+            break;
+        }
+        resetReplicatedData(users); // Every primary starts with a full copy
+        result = followPrimary(primary, path, &text, &capacity);
+        closesocket(primary);
+    }
+    free(text);
+    closesocket(listener);
+    remove(path);
+    WSACleanup();
+    return result == FOLLOW_TAKE_OVER;
+}
@@ -0,0 +1,256 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "functions.h"
+
+// Organisation-wide reports, which walk the tasks of every user rather than the logged-in one.
+// The users are cut into parts that hold about the same number of tasks (the counts of
+// aggregates.c give that without a walk) and every part is a job on the work-stealing pool that
+// fills in a partial result of its own. The jobs share nothing but the tasks they read, so the
+// walk scales with the workers; once they are done the partials are merged in user order, and a
+// report reads the same whatever the number of workers.
+
+#define PARTS_PER_WORKER 4 // Spare parts for the workers that finish early to steal
+
+static const char* reportNames[] = { "overdue", "users", "priorities" };
+static const char* priorityNames[PRIORITY_RANKS] = { "high", "medium", "low" };
+
+typedef struct UserRow {
+    const User* user;
+    long total;
+    long byPriority[PRIORITY_RANKS];
+    long overdue;
+} UserRow;
+
+// The users of one part and what the walk found in them
+typedef struct ReportPart {
+    const User** users;
+    UserRow* rows;             // One per user of the part
+    size_t userCount;
+    ReportType type;
+    long today;
+    long byPriority[PRIORITY_RANKS];
+    long overdueByPriority[PRIORITY_RANKS];
+    long undated;              // Tasks without a valid deadline
+    const Task** overdueTasks; // For the overdue report, in user, board, list and task order
+    size_t overdueCount;
+    size_t overdueCapacity;
+    int outOfMemory;
+} ReportPart;
+
+// Returns 0 if name is not a report
+int parseReportType(const char* name, ReportType* type) {
+    for (int i = 0; i < REPORT_TYPES; i++) {
+        if (strcmp(name, reportNames[i]) == 0) {
+            *type = (ReportType)i;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static void addOverdueTask(ReportPart* part, const Task* task) {
+    if (part->overdueCount == part->overdueCapacity) {
+        size_t capacity = part->overdueCapacity ? part->overdueCapacity * 2 : 256;
+        const Task** grown = realloc(part->overdueTasks, capacity * sizeof(Task*));
+        if (grown == NULL) {
+            part->outOfMemory = 1; // The counts stay complete, only the listing is cut short
+            return;
+        }
+        part->overdueTasks = grown;
+        part->overdueCapacity = capacity;
+    }
+    part->overdueTasks[part->overdueCount++] = task;
+}
+
+// Walks the tasks of the part's users; runs on a pool worker
+static void scanPartJob(void* arg) {
+    ReportPart* part = (ReportPart*)arg;
+    for (size_t i = 0; i < part->userCount; i++) {
+        UserRow* row = &part->rows[i];
+        row->user = part->users[i];
+        for (const Board* board = row->user->boards; board != NULL; board = board->next) {
+            for (const List* list = board->lists; list != NULL; list = list->next) {
+                for (const Task* task = list->tasks; task != NULL; task = task->next) {
+                    int rank = priorityRank(task->priority);
+                    long deadline = dateToDay(task->date);
+                    row->total++;
+                    row->byPriority[rank]++;
+                    part->byPriority[rank]++;
+                    if (deadline < 0) {
+                        part->undated++;
+                    } else if (deadline < part->today) {
+                        row->overdue++;
+                        part->overdueByPriority[rank]++;
+                        if (part->type == REPORT_OVERDUE) {
+                            addOverdueTask(part, task);
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+// Cuts the users into at most partLimit parts of about the same number of tasks, never
+// splitting a user; returns the number of parts
+static size_t cutParts(const User** users, UserRow* rows, size_t userCount, long taskTotal,
+                       ReportPart* parts, size_t partLimit) {
+    long partTasks = taskTotal / (long)partLimit + 1; // Every part but the last reaches this
+    size_t partCount = 0;
+    size_t first = 0;
+    long tasks = 0;
+    for (size_t i = 0; i < userCount; i++) {
+        tasks += users[i]->counts.total;
+        if (tasks >= partTasks || i + 1 == userCount) {
+            parts[partCount].users = users + first;
+            parts[partCount].rows = rows + first;
+            parts[partCount].userCount = i + 1 - first;
+            partCount++;
+            first = i + 1;
+            tasks = 0;
+        }
+    }
+    return partCount;
+}
+
+static void printOverdueReport(FILE* out, const ReportPart* parts, size_t partCount, long today) {
+    char date[16];
+    dayToDate(today, date);
+    fprintf(out, "Overdue tasks as of %s:\n", date);
+    long listed = 0;
+    int complete = 1;
+    for (size_t i = 0; i < partCount; i++) {
+        for (size_t j = 0; j < parts[i].overdueCount; j++) {
+            const Task* task = parts[i].overdueTasks[j];
+            const List* list = task->list;
+            fprintf(out, "  %s: %s/%s/%s (#%ld), %s, due %s, %ld day(s) overdue\n", list->board->user->username,
+                    list->board->name, list->name, task->name, task->id, task->priority, task->date,
+                    today - dateToDay(task->date));
+        }
+        listed += (long)parts[i].overdueCount;
+        complete = complete && !parts[i].outOfMemory;
+    }
+    if (!complete) {
+        fprintf(out, "  ... not enough memory to list them all.\n");
+    }
+    fprintf(out, "%ld overdue task(s) listed.\n", listed);
+}
+
+static void printUserReport(FILE* out, const UserRow* rows, size_t userCount) {
+    UserRow total = { NULL };
+    fprintf(out, "%-24s %9s %9s %9s %9s %9s\n", "User", "Tasks", "High", "Medium", "Low", "Overdue");
+    for (size_t i = 0; i < userCount; i++) {
+        const UserRow* row = &rows[i];
+        fprintf(out, "%-24s %9ld %9ld %9ld %9ld %9ld\n", row->user->username, row->total, row->byPriority[0],
+                row->byPriority[1], row->byPriority[2], row->overdue);
+        total.total += row->total;
+        for (int rank = 0; rank < PRIORITY_RANKS; rank++) {
+            total.byPriority[rank] += row->byPriority[rank];
+        }
+        total.overdue += row->overdue;
+    }
+    fprintf(out, "%-24s %9ld %9ld %9ld %9ld %9ld\n", "All users", total.total, total.byPriority[0],
+            total.byPriority[1], total.byPriority[2], total.overdue);
+}
+
+static void printPriorityReport(FILE* out, const ReportPart* merged) {
+    long total = 0;
+    for (int rank = 0; rank < PRIORITY_RANKS; rank++) {
+        total += merged->byPriority[rank];
+    }
+    // Tasks with an unknown priority count as "low", as they do everywhere else
+    fprintf(out, "%-10s %9s %7s %9s\n", "Priority", "Tasks", "Share", "Overdue");
+    for (int rank = 0; rank < PRIORITY_RANKS; rank++) {
+        fprintf(out, "%-10s %9ld %6.1f%% %9ld\n", priorityNames[rank], merged->byPriority[rank],
+                total > 0 ? merged->byPriority[rank] * 100.0 / total : 0.0, merged->overdueByPriority[rank]);
+    }
+    fprintf(out, "%ld task(s), %ld without a valid deadline.\n", total, merged->undated);
+}
+
+// Walks every user's tasks on the pool's workers threads (a NULL pool walks them on the calling
+// thread) and writes the report as of day today to out. Reads nothing but users, so a read
+// snapshot (snapshot.c) can be reported on from another thread. Returns 0 if there was no
+// memory for it.
+int writeReport(const User* users, ReportType type, ThreadPool* pool, int workers, long today, FILE* out) {
+    size_t userCount = 0;
+    long taskTotal = 0;
+    for (const User* user = users; user != NULL; user = user->next) {
+        userCount++;
+        taskTotal += user->counts.total;
+    }
+    if (userCount == 0) {
+        fprintf(out, "There are no users to report on.\n");
+        return 1;
+    }
+    size_t partLimit = (size_t)workers * PARTS_PER_WORKER;
+    if (partLimit > userCount) {
+        partLimit = userCount;
+    }
+    const User** userArray = malloc(userCount * sizeof(User*));
+    UserRow* rows = calloc(userCount, sizeof(UserRow));
+    ReportPart* parts = calloc(partLimit, sizeof(ReportPart));
+    if (userArray == NULL || rows == NULL || parts == NULL) {
+        perror("Memory allocation failed for the report");
+        free(userArray);
+        free(rows);
+        free(parts);
+        return 0;
+    }
+    size_t i = 0;
+    for (const User* user = users; user != NULL; user = user->next) {
+        userArray[i++] = user;
+    }
+    size_t partCount = cutParts(userArray, rows, userCount, taskTotal, parts, partLimit);
+
+    for (i = 0; i < partCount; i++) {
+        parts[i].type = type;
+        parts[i].today = today;
+        submitJob(pool, scanPartJob, &parts[i]);
+    }
+    waitForJobs(pool);
+
+    ReportPart merged = { NULL };
+    for (i = 0; i < partCount; i++) {
+        for (int rank = 0; rank < PRIORITY_RANKS; rank++) {
+            merged.byPriority[rank] += parts[i].byPriority[rank];
+            merged.overdueByPriority[rank] += parts[i].overdueByPriority[rank];
+        }
+        merged.undated += parts[i].undated;
+    }
+    switch (type) {
+        case REPORT_OVERDUE:
+            printOverdueReport(out, parts, partCount, today);
+            break;
+        case REPORT_USERS:
+            printUserReport(out, rows, userCount);
+            break;
+        case REPORT_PRIORITIES:
+        default:
+            printPriorityReport(out, &merged);
+            break;
+    }
+
+    for (i = 0; i < partCount; i++) {
+        free(parts[i].overdueTasks);
+    }
+    free(parts);
+    free(rows);
+    free(userArray);
+    return 1;
+}
+
+// Walks every user's tasks on workers threads (1 walks them on the calling thread) and prints
+// the report to out. Returns 0 if there was no memory for it.
+int printReport(const User* users, ReportType type, int workers, FILE* out) {
+    long long startTicks = statsClock();
+    if (workers < 1) {
+        workers = 1;
+    }
+    long today = reminderDay(); // Read here, as the wheel is not for the workers to start
+    ThreadPool* pool = workers > 1 ? createThreadPool(workers) : NULL;
+    int ok = writeReport(users, type, pool, workers, today, out);
+    destroyThreadPool(pool);
+    recordTiming(TIMER_REPORT, startTicks);
+    return ok;
+}
@@ -0,0 +1,407 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <windows.h>
+#include "functions.h"
+
+// Read snapshots: every user, board, list and task as they were at one change sequence number,
+// unchanging from then on, for reads long enough that the session should not wait for them. A
+// snapshot is pinned on the main thread between two actions, when no change is half applied (a
+// task unlinked from one list and not yet linked into the other is never in one), and a read
+// then runs on it in the background while the edits go on.
+//
+// Snapshots are copy-on-write per user. A user keeps the newest copy of what they own that was
+// made for a snapshot, tagged with their newestChange (changes.c), which every change and
+// deletion under them moves on. Pinning shares the copies of the users whose number has not
+// moved and copies the others, so a pin after a few edits costs the users they touched rather
+// than the whole model. A copy is one block holding the user, boards, lists and tasks, linked
+// as the model is, so the code that reads the model reads a snapshot unchanged. Once no
+// snapshot holds a copy, it is freed if its user has moved on, has a newer one or is gone, and
+// releasing the last snapshot frees them all, so a session that stops reading keeps none.
+// Pinning and releasing are for the main thread only, so the reference counts need no locking.
+
+typedef struct UserCopy {
+    long references; // Snapshots holding the copy, plus its user while it is the user's newest
+    long sequence;   // The user's newestChange when the copy was made
+    User* owner;     // The user while it is their newest, else NULL
+    struct UserCopy* prevOwned; // In ownedCopies while it has an owner
+    struct UserCopy* nextOwned;
+    size_t bytes;
+    User user;       // The boards, lists, tasks and strings follow in the same block
+} UserCopy;
+
+struct Snapshot {
+    long sequence;         // Change sequence the snapshot was pinned at
+    User* users;           // The copies' users, linked in the model's order
+    UserCopy** copies;
+    size_t userCount;
+    Tombstone* tombstones; // Without the deletions of records that exist again
+    size_t tombstoneCount;
+};
+
+static size_t pinnedSnapshots = 0;
+static UserCopy* ownedCopies = NULL; // Users' newest copies, freed when no snapshot is pinned
+static size_t liveCopies = 0;
+static size_t copyBytes = 0;
+
+// Bytes a string takes in a copy: none when it is in the record's inline storage, which is
+// copied with the record
+static size_t copiedStringSize(const char* text, const char* storage) {
+    return text == storage ? 0 : strlen(text) + 1;
+}
+
+// Points a copied field at the copy's inline storage, or at a copy of the text taken from strings
+static char* copyString(const char* text, const char* storage, char* copyStorage, char** strings) {
+    if (text == storage) {
+        return copyStorage;
+    }
+    size_t size = strlen(text) + 1;
+    char* copy = memcpy(*strings, text, size);
+    *strings += size;
+    return copy;
+}
+
+// Copies the user and everything they own into one block; returns NULL if there is no memory
+static UserCopy* copyUser(const User* user) {
+    size_t boardCount = 0, listCount = 0, taskCount = 0;
+    size_t stringBytes = copiedStringSize(user->username, NULL) + copiedStringSize(user->password, NULL);
+    for (const Board* board = user->boards; board != NULL; board = board->next) {
+        boardCount++;
+        stringBytes += copiedStringSize(board->name, board->nameStorage);
+        for (const List* list = board->lists; list != NULL; list = list->next) {
+            listCount++;
+            stringBytes += copiedStringSize(list->name, list->nameStorage);
+            for (const Task* task = list->tasks; task != NULL; task = task->next) {
+                taskCount++;
+                stringBytes += copiedStringSize(task->name, task->nameStorage) +
+                               copiedStringSize(task->priority, task->priorityStorage) +
+                               copiedStringSize(task->date, task->dateStorage) +
+                               copiedStringSize(task->position, task->positionStorage);
+            }
+        }
+    }
+    size_t bytes = sizeof(UserCopy) + boardCount * sizeof(Board) + listCount * sizeof(List) +
+                   taskCount * sizeof(Task) + stringBytes;
+    UserCopy* copy = malloc(bytes);
+    if (copy == NULL) {
+        return NULL;
+    }
+    Board* nextBoard = (Board*)(copy + 1);
+    List* nextList = (List*)(nextBoard + boardCount);
+    Task* nextTask = (Task*)(nextList + listCount);
+    char* strings = (char*)(nextTask + taskCount);
+    copy->references = 0;
+    copy->sequence = user->newestChange;
+    copy->owner = NULL;
+    copy->bytes = bytes;
+
+    User* userCopy = &copy->user;
+    *userCopy = *user;
+    userCopy->username = copyString(user->username, NULL, NULL, &strings);
+    userCopy->password = copyString(user->password, NULL, NULL, &strings);
+    userCopy->next = NULL;
+    initIndex(&userCopy->boardsByName); // Lookups by name are for the model
+    initIndex(&userCopy->listsByName);
+    userCopy->snapshotCopy = NULL;
+    Board** boardLink = &userCopy->boards;
+    for (const Board* board = user->boards; board != NULL; board = board->next) {
+        Board* boardCopy = nextBoard++;
+        *boardCopy = *board;
+        boardCopy->name = copyString(board->name, board->nameStorage, boardCopy->nameStorage, &strings);
+        boardCopy->user = userCopy;
+        *boardLink = boardCopy;
+        boardLink = &boardCopy->next;
+        List** listLink = &boardCopy->lists;
+        for (const List* list = board->lists; list != NULL; list = list->next) {
+            List* listCopy = nextList++;
+            *listCopy = *list;
+            listCopy->name = copyString(list->name, list->nameStorage, listCopy->nameStorage, &strings);
+            listCopy->board = boardCopy;
+            initTaskOrder(listCopy);
+            *listLink = listCopy;
+            listLink = &listCopy->next;
+            Task** taskLink = &listCopy->tasks;
+            for (const Task* task = list->tasks; task != NULL; task = task->next) {
+                Task* taskCopy = nextTask++;
+                *taskCopy = *task;
+                taskCopy->name = copyString(task->name, task->nameStorage, taskCopy->nameStorage, &strings);
+                taskCopy->priority = copyString(task->priority, task->priorityStorage, taskCopy->priorityStorage, &strings);
+                taskCopy->date = copyString(task->date, task->dateStorage, taskCopy->dateStorage, &strings);
+                taskCopy->position = copyString(task->position, task->positionStorage, taskCopy->positionStorage, &strings);
+                taskCopy->list = listCopy;
+                taskCopy->reminder = NULL;
+                *taskLink = taskCopy;
+                taskLink = &taskCopy->next;
+            }
+            *taskLink = NULL;
+        }
+        *listLink = NULL;
+    }
+    *boardLink = NULL;
+    liveCopies++;
+    copyBytes += bytes;
+    return copy;
+}
+
+static void releaseCopy(UserCopy* copy) {
+    if (--copy->references == 0) {
+        liveCopies--;
+        copyBytes -= copy->bytes;
+        free(copy);
+    }
+}
+
+// Lets go of the user's newest copy, when the user changed or is freed
+void dropSnapshotCopy(User* user) {
+    UserCopy* copy = user->snapshotCopy;
+    if (copy != NULL) {
+        copy->owner = NULL;
+        if (copy->prevOwned != NULL) {
+            copy->prevOwned->nextOwned = copy->nextOwned;
+        } else {
+            ownedCopies = copy->nextOwned;
+        }
+        if (copy->nextOwned != NULL) {
+            copy->nextOwned->prevOwned = copy->prevOwned;
+        }
+        releaseCopy(copy);
+        user->snapshotCopy = NULL;
+    }
+}
+
+// Pins a snapshot of users and everything they own as they are now; returns NULL if there was
+// no memory for it. Release it with releaseSnapshot.
+Snapshot* pinSnapshot(User* users) {
+    size_t userCount = 0;
+    for (const User* user = users; user != NULL; user = user->next) {
+        userCount++;
+    }
+    Snapshot* snapshot = calloc(1, sizeof(Snapshot));
+    if (snapshot == NULL) {
+        perror("Memory allocation failed for a read snapshot");
+        return NULL;
+    }
+    pinnedSnapshots++;
+    snapshot->sequence = currentChangeSequence();
+    if (userCount > 0) {
+        snapshot->users = malloc(userCount * sizeof(User));
+        snapshot->copies = malloc(userCount * sizeof(UserCopy*));
+    }
+    if ((userCount > 0 && (snapshot->users == NULL || snapshot->copies == NULL)) ||
+        !copyLiveTombstones(&snapshot->tombstones, &snapshot->tombstoneCount)) {
+        perror("Memory allocation failed for a read snapshot");
+        releaseSnapshot(snapshot);
+        return NULL;
+    }
+    for (User* user = users; user != NULL; user = user->next) {
+        UserCopy* copy = user->snapshotCopy;
+        if (copy == NULL || copy->sequence != user->newestChange) {
+            copy = copyUser(user);
+            if (copy == NULL) {
+                perror("Memory allocation failed for a read snapshot");
+                releaseSnapshot(snapshot);
+                return NULL;
+            }
+            dropSnapshotCopy(user);
+            copy->references = 1;
+            copy->owner = user;
+            copy->prevOwned = NULL;
+            copy->nextOwned = ownedCopies;
+            if (ownedCopies != NULL) {
+                ownedCopies->prevOwned = copy;
+            }
+            ownedCopies = copy;
+            user->snapshotCopy = copy;
+        }
+        copy->references++;
+        snapshot->copies[snapshot->userCount] = copy;
+        snapshot->users[snapshot->userCount] = copy->user;
+        snapshot->userCount++;
+    }
+    for (size_t i = 0; i < snapshot->userCount; i++) {
+        snapshot->users[i].next = i + 1 < snapshot->userCount ? &snapshot->users[i + 1] : NULL;
+    }
+    return snapshot;
+}
+
+// Head of the snapshot's users; read it like the model, but never change it
+const User* snapshotUsers(const Snapshot* snapshot) {
+    return snapshot->userCount > 0 ? snapshot->users : NULL;
+}
+
+long snapshotSequence(const Snapshot* snapshot) {
+    return snapshot->sequence;
+}
+
+const Tombstone* snapshotTombstones(const Snapshot* snapshot, size_t* count) {
+    *count = snapshot->tombstoneCount;
+    return snapshot->tombstones;
+}
+
+void releaseSnapshot(Snapshot* snapshot) {
+    pinnedSnapshots--;
+    for (size_t i = 0; i < snapshot->userCount; i++) {
+        UserCopy* copy = snapshot->copies[i];
+        // About to be left with its user alone, who has moved on since
+        if (copy->references == 2 && copy->owner != NULL && copy->sequence != copy->owner->newestChange) {
+            dropSnapshotCopy(copy->owner);
+        }
+        releaseCopy(copy);
+    }
+    // With no snapshot pinned, no copy is needed until the next pin
+    while (pinnedSnapshots == 0 && ownedCopies != NULL) {
+        dropSnapshotCopy(ownedCopies->owner);
+    }
+    free(snapshot->users);
+    free(snapshot->copies);
+    free(snapshot->tombstones);
+    free(snapshot);
+}
+
+// Snapshots pinned, user copies alive and the bytes those take, for the stats
+void getSnapshotMemory(size_t* pinned, size_t* copies, size_t* bytes) {
+    *pinned = pinnedSnapshots;
+    *copies = liveCopies;
+    *bytes = copyBytes;
+}
+
+// Reads that run on a snapshot in the background, each on a thread of its own and into a file.
+// The main thread looks for finished ones before every prompt, says how they went and releases
+// their snapshots.
+
+typedef struct BackgroundRead {
+    HANDLE thread;
+    Snapshot* snapshot;
+    char* fileName;
+    int isReport;        // A report, or else an export of the changes after since
+    ReportType type;
+    long today;          // Day the report is as of; the reminder wheel is the main thread's
+    ThreadPool* pool;    // Made and destroyed on the main thread
+    int workers;
+    long since;
+    long result;         // Set by the thread: changes exported, 1 for a report, -1 on failure
+    struct BackgroundRead* next;
+} BackgroundRead;
+
+static BackgroundRead* backgroundReads = NULL; // In the order they were started
+
+static DWORD WINAPI backgroundReadMain(LPVOID param) {
+    BackgroundRead* read = (BackgroundRead*)param;
+    if (!read->isReport) {
+        read->result = exportSnapshotChanges(read->snapshot, read->since, read->fileName);
+        return 0;
+    }
+    FILE* out = fopen(read->fileName, "w");
+    if (out == NULL) {
+        perror("Unable to open the report file");
+        read->result = -1;
+        return 0;
+    }
+    int ok = writeReport(snapshotUsers(read->snapshot), read->type, read->pool, read->workers, read->today, out);
+    ok = !ferror(out) && ok;
+    ok = fclose(out) == 0 && ok;
+    read->result = ok ? 1 : -1;
+    return 0;
+}
+
+static void freeBackgroundRead(BackgroundRead* read) {
+    destroyThreadPool(read->pool);
+    if (read->snapshot != NULL) {
+        releaseSnapshot(read->snapshot);
+    }
+    free(read->fileName);
+    free(read);
+}
+
+// A read into fileName with a snapshot of users pinned for it; NULL if it cannot be made
+static BackgroundRead* newBackgroundRead(User* users, const char* fileName) {
+    if (isDataFileName(fileName)) {
+        printf("%s is a data file; choose another file to write to.\n", fileName);
+        return NULL;
+    }
+    for (const BackgroundRead* running = backgroundReads; running != NULL; running = running->next) {
+        if (strcmp(running->fileName, fileName) == 0) {
+            printf("A read into %s is still running.\n", fileName);
+            return NULL;
+        }
+    }
+    BackgroundRead* read = calloc(1, sizeof(BackgroundRead));
+    if (read == NULL || (read->fileName = strdup(fileName)) == NULL) {
+        perror("Memory allocation failed for a background read");
+        free(read);
+        return NULL;
+    }
+    read->snapshot = pinSnapshot(users);
+    if (read->snapshot == NULL) {
+        freeBackgroundRead(read);
+        return NULL;
+    }
+    return read;
+}
+
+static int runInBackground(BackgroundRead* read) {
+    read->thread = CreateThread(NULL, 0, backgroundReadMain, read, 0, NULL);
+    if (read->thread == NULL) {
+        fprintf(stderr, "Unable to start a background thread.\n");
+        freeBackgroundRead(read);
+        return 0;
+    }
+    BackgroundRead** link = &backgroundReads;
+    while (*link != NULL) {
+        link = &(*link)->next;
+    }
+    *link = read;
+    return 1;
+}
+
+// Writes the report on users as they are now to fileName while the session goes on; returns 0
+// if it could not be started
+int startBackgroundReport(User* users, ReportType type, const char* fileName) {
+    BackgroundRead* read = newBackgroundRead(users, fileName);
+    if (read == NULL) {
+        return 0;
+    }
+    read->isReport = 1;
+    read->type = type;
+    read->today = reminderDay();
+    read->workers = getCoreCount();
+    read->pool = read->workers > 1 ? createThreadPool(read->workers) : NULL;
+    return runInBackground(read);
+}
+
+// Exports the changes after sequence since, up to now, to fileName while the session goes on;
+// returns 0 if it could not be started
+int startBackgroundExport(User* users, long since, const char* fileName) {
+    BackgroundRead* read = newBackgroundRead(users, fileName);
+    if (read == NULL) {
+        return 0;
+    }
+    read->since = since;
+    return runInBackground(read);
+}
+
+// Says how the background reads that finished went and releases their snapshots; with wait,
+// waits for every read first. Called before every menu prompt and before the final save.
+void finishBackgroundReads(int wait) {
+    BackgroundRead** link = &backgroundReads;
+    while (*link != NULL) {
+        BackgroundRead* read = *link;
+        if (WaitForSingleObject(read->thread, wait ? INFINITE : 0) != WAIT_OBJECT_0) {
+            link = &read->next;
+            continue;
+        }
+        *link = read->next;
+        CloseHandle(read->thread);
+        long sequence = snapshotSequence(read->snapshot);
+        if (read->result < 0) {
+            printf("The %s as of sequence %ld could not be written to %s.\n",
+                   read->isReport ? "report" : "change export", sequence, read->fileName);
+        } else if (read->isReport) {
+            printf("The report as of sequence %ld is in %s.\n", sequence, read->fileName);
+        } else {
+            printf("Exported %ld change(s) after sequence %ld, up to sequence %ld, to %s.\n", read->result,
+                   read->since, sequence, read->fileName);
+        }
+        freeBackgroundRead(read);
+    }
+}
@@ -0,0 +1,175 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <windows.h>
+#include "functions.h"
+
+// Latencies go into log-scale buckets of microseconds: four buckets per power of two, so a
+// percentile is exact to within about 19%. Recording one sample is a few integer operations.
+#define LATENCY_BUCKETS 128
+#define MAX_TRACKED_COMMANDS 64
+
+typedef struct LatencyHistogram {
+    const char* name;
+    unsigned long counts[LATENCY_BUCKETS];
+    unsigned long samples;
+} LatencyHistogram;
+
+static const char* timerNames[TIMER_COUNT] = { "loadAllData", "saveAllData", "showUpcomingTasks", "sortTasks", "printReport" };
+static double lastTimings[TIMER_COUNT];
+static int timingRecorded[TIMER_COUNT];
+static LatencyHistogram commandLatencies[MAX_TRACKED_COMMANDS];
+static int trackedCommands = 0;
+static int actionTiming = 0;
+static int dumpInterval = 0;
+static int commandsSinceDump = 0;
+
+// Current time in performance counter ticks
+long long statsClock() {
+    LARGE_INTEGER now;
+    QueryPerformanceCounter(&now);
+    return now.QuadPart;
+}
+
+static double ticksToMs(long long ticks) {
+    static long long frequency = 0;
+    if (frequency == 0) {
+        LARGE_INTEGER value;
+        QueryPerformanceFrequency(&value);
+        frequency = value.QuadPart;
+    }
+    return (double)ticks * 1000.0 / (double)frequency;
+}
+
+// Remembers how long the last run of an instrumented operation took
+void recordTiming(StatTimer timer, long long startTicks) {
+    lastTimings[timer] = ticksToMs(statsClock() - startTicks);
+    timingRecorded[timer] = 1;
+    if (actionTiming) {
+        recordActionLatency(timerNames[timer], startTicks);
+    }
+}
+
+static int latencyBucket(unsigned long long micros) {
+    if (micros < 4) {
+        return (int)micros;
+    }
+    int topBit = 63;
+    while (!(micros >> topBit)) {
+        topBit--;
+    }
+    int bucket = 4 * (topBit - 1) + (int)((micros >> (topBit - 2)) & 3);
+    return bucket < LATENCY_BUCKETS ? bucket : LATENCY_BUCKETS - 1;
+}
+
+// Smallest latency, in microseconds, that falls into the bucket
+static unsigned long long bucketStart(int bucket) {
+    if (bucket < 4) {
+        return (unsigned long long)bucket;
+    }
+    return (unsigned long long)(4 + bucket % 4) << (bucket / 4 - 1);
+}
+
+// Upper bound of the bucket that holds the given fraction of the samples, in milliseconds
+static double latencyPercentile(const LatencyHistogram* histogram, double fraction) {
+    unsigned long target = (unsigned long)(fraction * histogram->samples + 0.5);
+    unsigned long seen = 0;
+    for (int i = 0; i < LATENCY_BUCKETS; i++) {
+        seen += histogram->counts[i];
+        if (seen >= target && seen > 0) {
+            return bucketStart(i + 1) / 1000.0;
+        }
+    }
+    return 0;
+}
+
+// Adds one sample to the histogram of name; name must be a string that outlives the process
+static void addLatencySample(const char* name, long long startTicks) {
+    unsigned long long micros = (unsigned long long)(ticksToMs(statsClock() - startTicks) * 1000.0);
+    LatencyHistogram* histogram = NULL;
+    for (int i = 0; i < trackedCommands; i++) {
+        if (commandLatencies[i].name == name) {
+            histogram = &commandLatencies[i];
+            break;
+        }
+    }
+    if (histogram == NULL) {
+        if (trackedCommands == MAX_TRACKED_COMMANDS) {
+            return;
+        }
+        histogram = &commandLatencies[trackedCommands++];
+        histogram->name = name;
+    }
+    histogram->counts[latencyBucket(micros)]++;
+    histogram->samples++;
+}
+
+void recordCommandLatency(const char* name, long long startTicks) {
+    addLatencySample(name, startTicks);
+    if (dumpInterval > 0 && ++commandsSinceDump >= dumpInterval) {
+        commandsSinceDump = 0;
+        printStats(stderr);
+    }
+}
+
+// Menu actions include the time spent typing at their prompts, so they are only worth
+// timing when the input is scripted; the replay benchmark turns this on
+void setActionTiming(int enabled) {
+    actionTiming = enabled;
+}
+
+void recordActionLatency(const char* name, long long startTicks) {
+    if (actionTiming) {
+        addLatencySample(name, startTicks);
+    }
+}
+
+// Dumps the stats to stderr after every interval commands; 0 turns the dump off
+void setStatsInterval(int interval) {
+    dumpInterval = interval;
+}
+
+void printStats(FILE* out) {
+    size_t users, boards, lists, tasks, indexBytes;
+    getEntityCounts(&users, &boards, &lists, &tasks, &indexBytes);
+    size_t pooledBytes, borrowedBytes;
+    getStringMemory(&pooledBytes, &borrowedBytes);
+
+    fprintf(out, "Entities: %lu users, %lu boards, %lu lists, %lu tasks\n",
+            (unsigned long)users, (unsigned long)boards, (unsigned long)lists, (unsigned long)tasks);
+    fprintf(out, "Memory (KiB): users %.1f, boards %.1f, lists %.1f, tasks %.1f, string pool %.1f, borrowed file data %.1f, indexes %.1f\n",
+            users * sizeof(User) / 1024.0, boards * sizeof(Board) / 1024.0, lists * sizeof(List) / 1024.0,
+            tasks * sizeof(Task) / 1024.0, pooledBytes / 1024.0, borrowedBytes / 1024.0, indexBytes / 1024.0);
+    size_t pinned, copies, copyBytes;
+    getSnapshotMemory(&pinned, &copies, &copyBytes);
+    fprintf(out, "Read snapshots: %lu pinned, %lu user copies, %.1f KiB\n", (unsigned long)pinned,
+            (unsigned long)copies, copyBytes / 1024.0);
+
+#ifdef UTBOARD_DEBUG_ALLOC
+    size_t liveBytes, peakBytes;
+    getAllocationTotals(&liveBytes, &peakBytes);
+    fprintf(out, "Tracked heap (KiB): live %.1f, peak %.1f\n", liveBytes / 1024.0, peakBytes / 1024.0);
+#endif
+
+    fprintf(out, "Last run (ms):");
+    for (int i = 0; i < TIMER_COUNT; i++) {
+        if (timingRecorded[i]) {
+            fprintf(out, " %s %.2f", timerNames[i], lastTimings[i]);
+        } else {
+            fprintf(out, " %s -", timerNames[i]);
+        }
+        fprintf(out, i + 1 < TIMER_COUNT ? "," : "\n");
+    }
+
+    if (trackedCommands == 0) {
+        fprintf(out, "No commands run yet.\n");
+        return;
+    }
+    fprintf(out, "%-18s %8s %10s %10s %10s\n", "Operation", "Calls", "p50 ms", "p95 ms", "p99 ms");
+    for (int i = 0; i < trackedCommands; i++) {
+        const LatencyHistogram* histogram = &commandLatencies[i];
+        fprintf(out, "%-18s %8lu %10.3f %10.3f %10.3f\n", histogram->name, histogram->samples,
+                latencyPercentile(histogram, 0.50), latencyPercentile(histogram, 0.95),
+                latencyPercentile(histogram, 0.99));
+    }
+}
@@ -0,0 +1,171 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <windows.h>
+#include "functions.h"
+
+#define STRING_BLOCK_SIZE (64 * 1024)
+#define DEDICATED_STRING_SIZE (STRING_BLOCK_SIZE / 4) // Larger strings get a block of their own
+
+// Long strings are carved from shared blocks. A block counts the strings that still use it,
+// plus one while it is a pool's current block, and is freed when the count drops to zero.
+// Every string is preceded by a pointer to its block so it can be released on its own.
+typedef struct StringBlock {
+    volatile LONG references;
+    size_t used;
+    size_t capacity;
+    char data[];
+} StringBlock;
+
+// A load buffer kept alive for the strings that still point into it
+struct BorrowedRegion {
+    char* begin;
+    char* end;
+    long references;
+    struct BorrowedRegion* next;
+};
+
+static BorrowedRegion* borrowedRegions = NULL;
+static volatile LONG pooledBytes = 0; // Bytes held by live string blocks
+
+static size_t alignToPointer(size_t size) {
+    return (size + sizeof(void*) - 1) & ~(sizeof(void*) - 1);
+}
+
+static StringBlock* newStringBlock(size_t capacity) {
+    StringBlock* block = malloc(sizeof(StringBlock) + capacity);
+    if (block == NULL) {
+        perror("Memory allocation failed for string pool");
+        return NULL;
+    }
+    block->references = 1;
+    block->used = 0;
+    block->capacity = capacity;
+    InterlockedExchangeAdd(&pooledBytes, (LONG)capacity);
+    return block;
+}
+
+static void releaseBlock(StringBlock* block) {
+    if (InterlockedDecrement(&block->references) == 0) {
+        InterlockedExchangeAdd(&pooledBytes, -(LONG)block->capacity);
+        free(block);
+    }
+}
+
+static char* placeString(StringBlock* block, size_t size, const char* text, size_t length) {
+    char* slot = block->data + block->used;
+    block->used += size;
+    memcpy(slot, &block, sizeof(StringBlock*));
+    char* copy = slot + sizeof(StringBlock*);
+    memcpy(copy, text, length);
+    copy[length] = '\0';
+    return copy;
+}
+
+// Copies length bytes of text into the pool; a pool must only be used by one thread at a time
+char* poolString(StringPool* pool, const char* text, size_t length) {
+    size_t size = alignToPointer(sizeof(StringBlock*) + length + 1);
+    if (size > DEDICATED_STRING_SIZE) {
+        StringBlock* block = newStringBlock(size); // Its one reference belongs to the string
+        return block != NULL ? placeString(block, size, text, length) : NULL;
+    }
+    if (pool->block == NULL || pool->block->capacity - pool->block->used < size) {
+        StringBlock* block = newStringBlock(STRING_BLOCK_SIZE);
+        if (block == NULL) {
+            return NULL;
+        }
+        releaseStringPool(pool);
+        pool->block = block;
+    }
+    InterlockedIncrement(&pool->block->references);
+    return placeString(pool->block, size, text, length);
+}
+
+// Releases a string returned by poolString; safe to call from any thread
+void releasePoolString(char* text) {
+    StringBlock* block;
+    memcpy(&block, text - sizeof(StringBlock*), sizeof(StringBlock*));
+    releaseBlock(block);
+}
+
+// Lets go of the pool's current block; strings already handed out stay valid
+void releaseStringPool(StringPool* pool) {
+    if (pool->block != NULL) {
+        releaseBlock(pool->block);
+        pool->block = NULL;
+    }
+}
+
+// Points *field at a copy of text, kept in storage when it fits and in the pool otherwise.
+// The previous value is released only after the copy succeeds, so text may alias it.
+int storeString(StringPool* pool, char** field, char* storage, size_t storageSize, const char* text) {
+    size_t length = strlen(text);
+    char* previous = *field;
+    if (length < storageSize) {
+        memmove(storage, text, length + 1);
+        *field = storage;
+    } else {
+        char* copy = poolString(pool, text, length);
+        if (copy == NULL) {
+            return 0;
+        }
+        *field = copy;
+    }
+    releaseString(previous, storage);
+    return 1;
+}
+
+// Releases a node string unless it lives in the node itself; borrowed strings drop their
+// reference on the load buffer instead
+void releaseString(char* text, const char* storage) {
+    if (text == NULL || text == storage) {
+        return;
+    }
+    for (BorrowedRegion** link = &borrowedRegions; *link != NULL; link = &(*link)->next) {
+        BorrowedRegion* region = *link;
+        if (text >= region->begin && text < region->end) {
+            if (--region->references == 0) {
+                *link = region->next;
+                free(region->begin);
+                free(region);
+            }
+            return;
+        }
+    }
+    releasePoolString(text);
+}
+
+// Reports the bytes held by string blocks and by retained load buffers
+void getStringMemory(size_t* pooled, size_t* borrowed) {
+    *pooled = (size_t)pooledBytes;
+    *borrowed = 0;
+    for (const BorrowedRegion* region = borrowedRegions; region != NULL; region = region->next) {
+        *borrowed += region->end - region->begin;
+    }
+}
+
+// Allocated before a load lets any string point into its buffer, so keeping the buffer alive
+// afterwards cannot fail; when it returns NULL the load copies its strings instead
+BorrowedRegion* reserveBorrowedRegion() {
+    BorrowedRegion* region = malloc(sizeof(BorrowedRegion));
+    if (region == NULL) {
+        perror("Memory allocation failed for borrowed strings");
+    }
+    return region;
+}
+
+// Takes ownership of a load buffer that references strings point into, using a region from
+// reserveBorrowedRegion. The buffer is never written again: edits store a new copy, so it is
+// freed after the last borrowed string is released.
+void retainBorrowedBuffer(BorrowedRegion* region, char* buffer, size_t size, long references) {
+    if (references == 0) {
+        free(region);
+        free(buffer);
+        return;
+    }
+    region->begin = buffer;
+    region->end = buffer + size;
+    region->references = references;
+    region->next = borrowedRegions;
+    borrowedRegions = region;
+}
@@ -0,0 +1,317 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "functions.h"
+
+// Task sorting without comparisons: one pass packs every task's sort fields into a 32-bit key,
+// then a stable LSD radix sort orders the keys. Being stable, the sort keeps the current list
+// order for tasks whose keys are equal, which is the final tiebreak of every sort mode.
+//   key = priority bucket (2 bits, priority mode only) | deadline (23 bits)
+
+#define DATE_KEY_BITS 23
+#define INVALID_DATE_KEY ((1u << DATE_KEY_BITS) - 1) // Tasks without a valid deadline sort last
+#define RADIX_BITS 11
+#define RADIX_SIZE (1 << RADIX_BITS)
+#define RADIX_PASSES 3 // Enough for 33 key bits
+#define SMALL_SORT_LIMIT 64 // Below this an insertion sort beats setting up the histograms
+
+// The date parseDate reads, packed as year * 512 + month * 32 + day, which orders like the text
+static unsigned int dateKey(const char* date) {
+    int year, month, day;
+    if (!parseDate(date, &year, &month, &day)) {
+        return INVALID_DATE_KEY;
+    }
+    return ((unsigned int)year << 9) | ((unsigned int)month << 5) | (unsigned int)day;
+}
+
+// High first; anything that is not a known priority sorts and counts with "low", as it always has
+int priorityRank(const char* priority) {
+    if (strcmp(priority, "high") == 0) {
+        return 0;
+    }
+    if (strcmp(priority, "medium") == 0) {
+        return 1;
+    }
+    return 2;
+}
+
+// One key extraction loop per sort mode, so the per-task work is inlined instead of called
+#define DEFINE_KEY_EXTRACTOR(name, keyExpression)                                  \
+    static void name(Task* const* tasks, size_t count, unsigned int* keys) {      \
+        for (size_t i = 0; i < count; i++) {                                      \
+            const Task* task = tasks[i];                                          \
+            keys[i] = (keyExpression);                                            \
+        }                                                                         \
+    }
+
+DEFINE_KEY_EXTRACTOR(extractPriorityKeys, ((unsigned int)priorityRank(task->priority) << DATE_KEY_BITS) | dateKey(task->date))
+DEFINE_KEY_EXTRACTOR(extractDateKeys, dateKey(task->date))
+
+static void extractKeys(Task* const* tasks, size_t count, TaskSortMode mode, unsigned int* keys) {
+    switch (mode) {
+        case SORT_BY_PRIORITY:
+            extractPriorityKeys(tasks, count, keys);
+            break;
+        case SORT_BY_DATE:
+            extractDateKeys(tasks, count, keys);
+            break;
+    }
+}
+
+unsigned int taskSortKey(const Task* task, TaskSortMode mode) {
+    unsigned int key = 0;
+    extractKeys((Task* const*)&task, 1, mode, &key);
+    return key;
+}
+
+// Stable insertion sort for short arrays, with the keys on the stack
+static void insertionSortTasks(Task** tasks, size_t count, TaskSortMode mode) {
+    unsigned int keys[SMALL_SORT_LIMIT];
+    extractKeys(tasks, count, mode, keys);
+    for (size_t i = 1; i < count; i++) {
+        unsigned int key = keys[i];
+        Task* task = tasks[i];
+        size_t j = i;
+        while (j > 0 && keys[j - 1] > key) {
+            keys[j] = keys[j - 1];
+            tasks[j] = tasks[j - 1];
+            j--;
+        }
+        keys[j] = key;
+        tasks[j] = task;
+    }
+}
+
+// Sorts tasks in place by the given mode; returns 0 if there was no memory for the sort
+int sortTaskArray(Task** tasks, size_t count, TaskSortMode mode) {
+    if (count < SMALL_SORT_LIMIT) {
+        insertionSortTasks(tasks, count, mode);
+        return 1;
+    }
+    unsigned int* keys = malloc(2 * count * sizeof(unsigned int));
+    Task** scratch = malloc(count * sizeof(Task*));
+    size_t (*histograms)[RADIX_SIZE] = calloc(RADIX_PASSES, sizeof(*histograms));
+    if (keys == NULL || scratch == NULL || histograms == NULL) {
+        free(keys);
+        free(scratch);
+        free(histograms);
+        return 0;
+    }
+    unsigned int* scratchKeys = keys + count;
+
+    extractKeys(tasks, count, mode, keys);
+
+    // Count every digit of every pass in one read of the keys
+    for (size_t i = 0; i < count; i++) {
+        unsigned int key = keys[i];
+        for (int pass = 0; pass < RADIX_PASSES; pass++) {
+            histograms[pass][(key >> (pass * RADIX_BITS)) & (RADIX_SIZE - 1)]++;
+        }
+    }
+
+    Task** from = tasks;
+    Task** to = scratch;
+    unsigned int* fromKeys = keys;
+    unsigned int* toKeys = scratchKeys;
+    for (int pass = 0; pass < RADIX_PASSES; pass++) {
+        size_t* histogram = histograms[pass];
+        int shift = pass * RADIX_BITS;
+        if (histogram[(fromKeys[0] >> shift) & (RADIX_SIZE - 1)] == count) {
+            continue; // Every key has the same digit here, the pass would not move anything
+        }
+        size_t offset = 0;
+        for (int digit = 0; digit < RADIX_SIZE; digit++) {
+            size_t digitCount = histogram[digit];
+            histogram[digit] = offset;
+            offset += digitCount;
+        }
+        for (size_t i = 0; i < count; i++) {
+            size_t target = histogram[(fromKeys[i] >> shift) & (RADIX_SIZE - 1)]++;
+            to[target] = from[i];
+            toKeys[target] = fromKeys[i];
+        }
+        Task** swapTasks = from;
+        from = to;
+        to = swapTasks;
+        unsigned int* swapKeys = fromKeys;
+        fromKeys = toKeys;
+        toKeys = swapKeys;
+    }
+    if (from != tasks) {
+        memcpy(tasks, from, count * sizeof(Task*));
+    }
+    free(keys);
+    free(scratch);
+    free(histograms);
+    return 1;
+}
+
+// Merged view over every list of a user: each list is a run of its tasks in the requested
+// order. A list that is already in order (it was sorted, or is short and happens to be) is its
+// own run; any other list is only scanned for its smallest key up front, and a sorted copy of its
+// task pointers is made when the merge first needs one of its tasks. A binary heap keyed on the
+// next task of each run hands out the tasks in order one at a time, so the first page costs one
+// scan of every task plus the sorts of the lists it shows, not a sort of every list.
+
+// Heap order: smaller key first, then the earlier run, which keeps the merge stable
+static int runBefore(const MergeRun* a, const MergeRun* b) {
+    return a->key != b->key ? a->key < b->key : a->order < b->order;
+}
+
+static Task* runHead(const MergeRun* run) {
+    return run->sorted != NULL ? run->sorted[run->index] : run->next;
+}
+
+static int isMerged(const TaskMerge* merge, const Task* task) {
+    return merge->afterDate == 0 || dateKey(task->date) > merge->afterDate;
+}
+
+// First task from task onwards that the merge includes
+static Task* nextMerged(const TaskMerge* merge, Task* task) {
+    while (task != NULL && !isMerged(merge, task)) {
+        task = task->next;
+    }
+    return task;
+}
+
+static void siftDown(MergeRun* heap, size_t count, size_t i) {
+    for (;;) {
+        size_t smallest = i;
+        size_t left = 2 * i + 1;
+        size_t right = left + 1;
+        if (left < count && runBefore(&heap[left], &heap[smallest])) {
+            smallest = left;
+        }
+        if (right < count && runBefore(&heap[right], &heap[smallest])) {
+            smallest = right;
+        }
+        if (smallest == i) {
+            return;
+        }
+        MergeRun swap = heap[i];
+        heap[i] = heap[smallest];
+        heap[smallest] = swap;
+        i = smallest;
+    }
+}
+
+// Makes the list a run: the list itself when it is already in order. Otherwise the run is
+// keyed on its smallest key, which the stable sort puts first, and left for sortRun. Leaves
+// the run empty when the merge includes none of the list's tasks.
+static void makeRun(const TaskMerge* merge, MergeRun* run, const List* list, size_t order) {
+    size_t count = 0;
+    int inOrder = 1;
+    unsigned int previous = 0;
+    unsigned int smallest = 0;
+    for (Task* task = nextMerged(merge, list->tasks); task != NULL; task = nextMerged(merge, task->next)) {
+        unsigned int key = taskSortKey(task, merge->mode);
+        if (count > 0 && key < previous) {
+            inOrder = 0;
+        }
+        if (count == 0 || key < smallest) {
+            smallest = key;
+        }
+        previous = key;
+        count++;
+    }
+    run->order = order;
+    run->index = 0;
+    run->count = count;
+    run->next = nextMerged(merge, list->tasks);
+    run->sorted = NULL;
+    run->unsorted = !inOrder;
+    run->key = smallest;
+}
+
+// Replaces an out-of-order run by a sorted copy of its tasks; returns 0 if there was no memory
+static int sortRun(const TaskMerge* merge, MergeRun* run) {
+    Task** sorted = malloc(run->count * sizeof(Task*));
+    if (sorted == NULL) {
+        return 0;
+    }
+    size_t i = 0;
+    for (Task* task = run->next; task != NULL; task = nextMerged(merge, task->next)) {
+        sorted[i++] = task;
+    }
+    if (!sortTaskArray(sorted, run->count, merge->mode)) {
+        free(sorted);
+        return 0;
+    }
+    run->sorted = sorted;
+    run->unsorted = 0;
+    return 1;
+}
+
+// Sets up the merge over the user's tasks that are due after afterDate ("YYYY-MM-DD"), or over
+// all of them when afterDate is NULL. Returns 0 if there was no memory for it.
+int startTaskMerge(TaskMerge* merge, const User* user, TaskSortMode mode, const char* afterDate) {
+    merge->mode = mode;
+    merge->failed = 0;
+    merge->afterDate = afterDate != NULL ? dateKey(afterDate) : 0;
+    merge->runs = NULL;
+    merge->runCount = 0;
+    size_t listCount = 0;
+    for (const Board* board = user->boards; board != NULL; board = board->next) {
+        for (const List* list = board->lists; list != NULL; list = list->next) {
+            listCount += list->tasks != NULL;
+        }
+    }
+    if (listCount == 0) {
+        return 1;
+    }
+    merge->runs = malloc(listCount * sizeof(MergeRun));
+    if (merge->runs == NULL) {
+        return 0;
+    }
+    size_t order = 0;
+    for (const Board* board = user->boards; board != NULL; board = board->next) {
+        for (const List* list = board->lists; list != NULL; list = list->next) {
+            if (list->tasks == NULL) {
+                continue;
+            }
+            MergeRun* run = &merge->runs[merge->runCount];
+            makeRun(merge, run, list, order++);
+            merge->runCount += run->count > 0;
+        }
+    }
+    for (size_t i = merge->runCount / 2; i-- > 0;) {
+        siftDown(merge->runs, merge->runCount, i);
+    }
+    return 1;
+}
+
+// Next task in merged order, or NULL once every task has been handed out. Also NULL, with
+// merge->failed set, if there was no memory to sort the next run.
+Task* nextMergedTask(TaskMerge* merge) {
+    if (merge->runCount == 0) {
+        return NULL;
+    }
+    MergeRun* top = &merge->runs[0];
+    if (top->unsorted && !sortRun(merge, top)) {
+        merge->failed = 1;
+        return NULL;
+    }
+    Task* task = runHead(top);
+    top->index++;
+    if (top->sorted == NULL) {
+        top->next = nextMerged(merge, task->next);
+    }
+    if (top->index < top->count) {
+        top->key = taskSortKey(runHead(top), merge->mode);
+    } else {
+        free(top->sorted);
+        *top = merge->runs[--merge->runCount];
+    }
+    siftDown(merge->runs, merge->runCount, 0);
+    return task;
+}
+
+// Frees what is left of the merge; the tasks themselves are untouched
+void endTaskMerge(TaskMerge* merge) {
+    for (size_t i = 0; i < merge->runCount; i++) {
+        free(merge->runs[i].sorted);
+    }
+    free(merge->runs);
+    merge->runs = NULL;
+    merge->runCount = 0;
+}
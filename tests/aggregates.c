@@ -0,0 +1,179 @@
+// Task count test: after every kind of change, and as days go by, the counts kept on each list,
+// board and user match counts taken afresh from their tasks.
+// Build and run: make test
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../functions.h"
+
+#define USERS 3
+#define STEPS 3000
+
+static int failures = 0;
+static unsigned int seed = 12345;
+
+static unsigned int nextRandom(unsigned int range) {
+    seed = seed * 1103515245u + 12345u;
+    return (seed >> 8) % range;
+}
+
+static void addCounts(TaskCounts* counts, const Task* task) {
+    long deadline = dateToDay(task->date);
+    counts->total++;
+    counts->byPriority[priorityRank(task->priority)]++;
+    if (deadline >= 0 && deadline < reminderDay()) {
+        counts->overdue++;
+    } else if (deadline >= 0) {
+        if (counts->nextDeadlineTasks == 0 || deadline < counts->nextDeadline) {
+            counts->nextDeadline = deadline;
+            counts->nextDeadlineTasks = 0;
+        }
+        counts->nextDeadlineTasks += deadline == counts->nextDeadline;
+    }
+}
+
+static void compareCounts(const TaskCounts* kept, const TaskCounts* actual, const char* level, int step) {
+    int same = kept->total == actual->total && kept->overdue == actual->overdue;
+    for (int i = 0; i < PRIORITY_RANKS; i++) {
+        same = same && kept->byPriority[i] == actual->byPriority[i];
+    }
+    // A next deadline marked unknown is found again when a summary asks for it
+    if (!kept->nextDeadlineUnknown) {
+        same = same && kept->nextDeadlineTasks == actual->nextDeadlineTasks &&
+               (actual->nextDeadlineTasks == 0 || kept->nextDeadline == actual->nextDeadline);
+    }
+    if (!same) {
+        printf("FAIL: %s counts after step %d: kept %ld tasks, %ld overdue, next %ld (%ld); actual %ld, %ld, %ld (%ld)\n",
+               level, step, kept->total, kept->overdue, kept->nextDeadline, kept->nextDeadlineTasks, actual->total,
+               actual->overdue, actual->nextDeadline, actual->nextDeadlineTasks);
+        failures++;
+    }
+}
+
+static void checkAllCounts(User* users, int step) {
+    for (User* user = users; user != NULL; user = user->next) {
+        TaskCounts userCounts = { 0 };
+        for (Board* board = user->boards; board != NULL; board = board->next) {
+            TaskCounts boardCounts = { 0 };
+            for (List* list = board->lists; list != NULL; list = list->next) {
+                TaskCounts listCounts = { 0 };
+                for (const Task* task = list->tasks; task != NULL; task = task->next) {
+                    addCounts(&listCounts, task);
+                    addCounts(&boardCounts, task);
+                    addCounts(&userCounts, task);
+                }
+                compareCounts(&list->counts, &listCounts, "list", step);
+            }
+            compareCounts(&board->counts, &boardCounts, "board", step);
+        }
+        compareCounts(&user->counts, &userCounts, "user", step);
+    }
+}
+
+static void randomDate(long today, char* date) {
+    dayToDate(today + (long)nextRandom(60) - 20, date);
+}
+
+static const char* randomPriority() {
+    static const char* priorities[] = { "high", "medium", "low", "someday" };
+    return priorities[nextRandom(4)];
+}
+
+static List* randomList(User* user) {
+    int boards = 0;
+    for (Board* board = user->boards; board != NULL; board = board->next) {
+        boards++;
+    }
+    if (boards == 0) {
+        return NULL;
+    }
+    Board* board = user->boards;
+    for (int i = nextRandom(boards); i > 0; i--) {
+        board = board->next;
+    }
+    int lists = 0;
+    for (List* list = board->lists; list != NULL; list = list->next) {
+        lists++;
+    }
+    if (lists == 0) {
+        return NULL;
+    }
+    List* list = board->lists;
+    for (int i = nextRandom(lists); i > 0; i--) {
+        list = list->next;
+    }
+    return list;
+}
+
+static Task* randomTask(List* list) {
+    int tasks = 0;
+    for (Task* task = list->tasks; task != NULL; task = task->next) {
+        tasks++;
+    }
+    if (tasks == 0) {
+        return NULL;
+    }
+    Task* task = list->tasks;
+    for (int i = nextRandom(tasks); i > 0; i--) {
+        task = task->next;
+    }
+    return task;
+}
+
+int main() {
+    User* users = NULL;
+    User* people[USERS];
+    char name[32];
+    char date[16];
+    for (int i = 0; i < USERS; i++) {
+        snprintf(name, sizeof(name), "user%d", i);
+        people[i] = signupWithArgs(&users, name, "secret");
+    }
+    long today = reminderDay();
+    for (int step = 1; step <= STEPS; step++) {
+        User* user = people[nextRandom(USERS)];
+        List* list = randomList(user);
+        Task* task = list != NULL ? randomTask(list) : NULL;
+        unsigned int action = nextRandom(100);
+        if (action < 3 || list == NULL) {
+            snprintf(name, sizeof(name), "Board %d", step);
+            Board* board = createBoardWithArgs(user, name);
+            for (int i = 0; i < 3; i++) {
+                snprintf(name, sizeof(name), "List %d", i);
+                createListWithArgs(board, name);
+            }
+        } else if (action < 45) {
+            randomDate(today, date);
+            addTaskWithArgs(list, "Task", randomPriority(), date);
+        } else if (action < 60 && task != NULL) {
+            randomDate(today, date);
+            editTaskWithArgs(task, NULL, nextRandom(2) ? randomPriority() : NULL, nextRandom(2) ? date : NULL);
+        } else if (action < 75 && task != NULL) {
+            List* target = randomList(user);
+            if (target != NULL && target != list) {
+                moveTaskWithArgs(list, task, target);
+            }
+        } else if (action < 90 && task != NULL) {
+            deleteTaskWithArgs(list, task);
+        } else if (action < 92) {
+            deleteListWithArgs(list->board, list);
+        } else if (action < 93) {
+            deleteBoardWithArgs(user, list->board);
+        } else if (action < 98) {
+            today++;
+            advanceReminders(today);
+        }
+        checkAllCounts(users, step);
+        if (failures > 10) {
+            break;
+        }
+    }
+
+    freeAllData(&users);
+    if (failures > 0) {
+        printf("aggregates: %d checks failed\n", failures);
+        return 1;
+    }
+    printf("aggregates: all checks passed\n");
+    return 0;
+}
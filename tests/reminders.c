@@ -0,0 +1,108 @@
+// Reminder wheel test: tasks due across every level of the wheel, and beyond its reach, each get
+// their three events on the right days as the wheel advances, also after being rescheduled.
+// Build and run: make test
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../functions.h"
+
+#define MAX_EVENTS 256
+
+typedef struct FiredEvent {
+    const Task* task;
+    ReminderEvent event;
+    long day;
+} FiredEvent;
+
+static FiredEvent fired[MAX_EVENTS];
+static int firedCount = 0;
+static int failures = 0;
+
+static void recordEvent(ReminderEvent event, const Task* task) {
+    if (firedCount < MAX_EVENTS) {
+        fired[firedCount].task = task;
+        fired[firedCount].event = event;
+        fired[firedCount].day = reminderDay();
+    }
+    firedCount++;
+}
+
+static void check(int condition, const char* what, long offset) {
+    if (!condition) {
+        printf("FAIL: %s (deadline in %ld days)\n", what, offset);
+        failures++;
+    }
+}
+
+// Checks that the task fired exactly the events from first on, each on its day
+static void checkEvents(const Task* task, long deadline, long offset, ReminderEvent first) {
+    ReminderEvent expected = first;
+    for (int i = 0; i < firedCount && i < MAX_EVENTS; i++) {
+        if (fired[i].task != task) {
+            continue;
+        }
+        check(fired[i].event == expected, "events fire in order, once each", offset);
+        check(fired[i].day == deadline + (long)fired[i].event - REMINDER_DUE_TODAY, "event fires on its day", offset);
+        expected = fired[i].event + 1;
+    }
+    check(expected == REMINDER_OVERDUE + 1, "every event fires", offset);
+    check(task->overdue, "task counts as overdue after its overdue event", offset);
+    check(task->reminder == NULL, "reminder is freed after its last event", offset);
+}
+
+int main() {
+    // Deadlines on both sides of every level boundary (64 and 4096 days) and past the wheel's
+    // reach of 64^3 days
+    static const long offsets[] = { 0, 1, 2, 63, 64, 65, 127, 128, 4095, 4096, 4097, 10000, 262143, 262144, 300000 };
+    size_t taskCount = sizeof(offsets) / sizeof(offsets[0]);
+    Task* tasks[sizeof(offsets) / sizeof(offsets[0])];
+
+    User* users = NULL;
+    long start = reminderDay();
+    setReminderHook(recordEvent);
+    User* user = signupWithArgs(&users, "tester", "secret");
+    List* list = createListWithArgs(createBoardWithArgs(user, "Board"), "List");
+    for (size_t i = 0; i < taskCount; i++) {
+        char date[16];
+        dayToDate(start + offsets[i], date);
+        tasks[i] = addTaskWithArgs(list, "Task", "high", date);
+    }
+    char date[16];
+    dayToDate(start - 5, date);
+    Task* past = addTaskWithArgs(list, "Past", "low", date);
+    check(past->overdue && past->reminder == NULL, "a task already overdue has no reminder", -5);
+
+    // Day by day through the first levels, then across the rest in one go
+    for (long day = start; day <= start + 200; day++) {
+        advanceReminders(day);
+    }
+    // Rescheduled while waiting in level 1: one brought forward, one put off into level 2
+    dayToDate(start + 210, date);
+    editTaskWithArgs(tasks[10], NULL, NULL, date);
+    dayToDate(start + 5000, date);
+    editTaskWithArgs(tasks[8], NULL, NULL, date);
+    advanceReminders(start + 300001);
+
+    for (size_t i = 0; i < taskCount; i++) {
+        long offset = offsets[i];
+        if (i == 10) {
+            offset = 210;
+        } else if (i == 8) {
+            offset = 5000;
+        }
+        // A deadline today has already passed its "due tomorrow" day
+        checkEvents(tasks[i], start + offset, offset, offset == 0 ? REMINDER_DUE_TODAY : REMINDER_DUE_TOMORROW);
+    }
+    check(firedCount <= MAX_EVENTS, "no more events than expected", 0);
+    for (int i = 0; i < firedCount && i < MAX_EVENTS; i++) {
+        check(fired[i].task != past, "a task already overdue fires nothing", -5);
+    }
+
+    freeAllData(&users);
+    if (failures > 0) {
+        printf("reminders: %d checks failed\n", failures);
+        return 1;
+    }
+    printf("reminders: all checks passed\n");
+    return 0;
+}
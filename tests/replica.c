@@ -0,0 +1,251 @@
+// Standby test: a standby that follows the change batches of a primary ends up with the
+// primary's data, takes over when the primary dies, and exits instead when the primary detaches
+// or still holds its lock. The batches are recorded from a model built here first; a thread then
+// plays the primary and sends them over the socket to runStandby.
+// Build and run: make test. Runs inside a "utboard-test" directory.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <winsock2.h>
+#include <afunix.h>
+#include <windows.h>
+#include "../functions.h"
+
+#define TEST_DIRECTORY "utboard-test"
+#define SOCKET_PATH "standby.sock"
+#define MAX_BATCHES 8
+
+typedef struct Batch {
+    char* text;
+    size_t length;
+    long sequence;
+} Batch;
+
+// How the pretend primary leaves
+typedef enum { END_BYE, END_DETACH, END_DROP } Ending;
+
+typedef struct FakePrimary {
+    const Batch* batches;
+    int batchCount;
+    Ending ending;
+} FakePrimary;
+
+static const char* dataFiles[] = { "users.csv", "boards.csv", "lists.csv", "tasks.csv", "tombstones.csv" };
+static Batch batches[MAX_BATCHES];
+static int batchCount = 0;
+static long shipped = -1;
+static int failures = 0;
+
+static void check(int condition, const char* what) {
+    if (!condition) {
+        printf("FAIL: %s\n", what);
+        failures++;
+    }
+}
+
+// Records what changed since the last batch, as shipChanges would send it
+static void recordBatch(const User* users) {
+    DataWriter writer;
+    if (batchCount == MAX_BATCHES || !openMemoryWriter(&writer)) {
+        check(0, "recording a batch");
+        return;
+    }
+    writeChangesSince(&writer, users, shipped);
+    Batch* batch = &batches[batchCount++];
+    batch->text = malloc(writer.length + 1);
+    memcpy(batch->text, writer.buffer, writer.length);
+    batch->length = writer.length;
+    batch->sequence = currentChangeSequence();
+    shipped = batch->sequence;
+    closeDataWriter(&writer);
+}
+
+static int compareLines(const void* a, const void* b) {
+    return strcmp(*(char* const*)a, *(char* const*)b);
+}
+
+// The lines of a data file, sorted, as one string; boards and lists are not saved in a fixed order
+static char* readSortedLines(const char* fileName) {
+    FILE* fp = fopen(fileName, "rb");
+    if (fp == NULL) {
+        return strdup("");
+    }
+    fseek(fp, 0, SEEK_END);
+    long size = ftell(fp);
+    rewind(fp);
+    char* text = malloc(size + 1);
+    size_t got = fread(text, 1, size, fp);
+    text[got] = '\0';
+    fclose(fp);
+    size_t lineCount = 0;
+    for (size_t i = 0; i < got; i++) {
+        lineCount += text[i] == '\n';
+    }
+    char** lines = malloc((lineCount + 1) * sizeof(char*));
+    lineCount = 0;
+    for (char* line = strtok(text, "\r\n"); line != NULL; line = strtok(NULL, "\r\n")) {
+        lines[lineCount++] = line;
+    }
+    qsort(lines, lineCount, sizeof(char*), compareLines);
+    char* sorted = malloc(got + 2);
+    sorted[0] = '\0';
+    for (size_t i = 0; i < lineCount; i++) {
+        strcat(sorted, lines[i]);
+        strcat(sorted, "\n");
+    }
+    free(lines);
+    free(text);
+    return sorted;
+}
+
+// Connects to the standby as a primary would, sends the batches and leaves as told
+static void playPrimary(const FakePrimary* primary) {
+    SOCKADDR_UN address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strcpy(address.sun_path, SOCKET_PATH);
+    SOCKET standby = INVALID_SOCKET;
+    // The standby may not be listening yet
+    for (int attempt = 0; attempt < 100 && standby == INVALID_SOCKET; attempt++) {
+        standby = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (connect(standby, (struct sockaddr*)&address, sizeof(address)) == SOCKET_ERROR) {
+            closesocket(standby);
+            standby = INVALID_SOCKET;
+            Sleep(50);
+        }
+    }
+    if (standby == INVALID_SOCKET) {
+        check(0, "connecting to the standby");
+        return;
+    }
+    char header[64];
+    for (int i = 0; i < primary->batchCount; i++) {
+        const Batch* batch = &primary->batches[i];
+        int length = snprintf(header, sizeof(header), "CHANGES %ld %lu\n", batch->sequence, (unsigned long)batch->length);
+        send(standby, header, length, 0);
+        send(standby, batch->text, (int)batch->length, 0);
+    }
+    if (primary->ending == END_BYE) {
+        int length = snprintf(header, sizeof(header), "BYE %ld\n", primary->batches[primary->batchCount - 1].sequence);
+        send(standby, header, length, 0);
+    } else if (primary->ending == END_DETACH) {
+        send(standby, "DETACH\n", 7, 0);
+    }
+    closesocket(standby);
+}
+
+// Plays the primaries one after another, each once the standby is done with the one before
+static DWORD WINAPI playPrimaries(LPVOID param) {
+    const FakePrimary* primary = (const FakePrimary*)param;
+    WSADATA data;
+    WSAStartup(MAKEWORD(2, 2), &data);
+    for (; primary->batchCount > 0; primary++) {
+        playPrimary(primary);
+    }
+    WSACleanup();
+    return 0;
+}
+
+// Runs a standby against the primaries, which end with one that has no batches; returns what
+// runStandby did
+static int followFakePrimaries(User** users, FakePrimary* primaries) {
+    HANDLE thread = CreateThread(NULL, 0, playPrimaries, primaries, 0, NULL);
+    int result = runStandby(SOCKET_PATH, users);
+    WaitForSingleObject(thread, INFINITE);
+    CloseHandle(thread);
+    return result;
+}
+
+int main() {
+    CreateDirectory(TEST_DIRECTORY, NULL);
+    if (!SetCurrentDirectory(TEST_DIRECTORY)) {
+        perror("Unable to enter the test directory");
+        return 1;
+    }
+
+    // The primary: a batch with everything, then batches of edits, moves and deletions
+    User* users = NULL;
+    char name[32], date[16];
+    for (int u = 0; u < 3; u++) {
+        snprintf(name, sizeof(name), "user%d", u);
+        User* user = signupWithArgs(&users, name, "secret");
+        for (int b = 0; b < 2; b++) {
+            snprintf(name, sizeof(name), "Board %d", b);
+            Board* board = createBoardWithArgs(user, name);
+            for (int l = 0; l < 2; l++) {
+                snprintf(name, sizeof(name), "List %d", l);
+                List* list = createListWithArgs(board, name);
+                for (int t = 0; t < 5; t++) {
+                    snprintf(name, sizeof(name), "Task \"%d\", a, b", t);
+                    snprintf(date, sizeof(date), "2030-%02d-%02d", 1 + t, 1 + b + l);
+                    addTaskWithArgs(list, name, t % 2 ? "high" : "low", date);
+                }
+            }
+        }
+    }
+    recordBatch(users);
+    for (User* user = users; user != NULL; user = user->next) {
+        List* first = user->boards->lists;
+        editTaskWithArgs(first->tasks, "Renamed", "medium", "2031-1-2");
+        moveTaskWithArgs(first, first->tasks, first->next);
+        deleteTaskWithArgs(first, first->tasks);
+    }
+    recordBatch(users);
+    deleteListWithArgs(users->boards, users->boards->lists);
+    deleteBoardWithArgs(users->next, users->next->boards);
+    addTaskWithArgs(users->boards->lists, "Added last", "low", "2032-03-04");
+    recordBatch(users);
+    signupWithArgs(&users, "latecomer", "secret");
+    recordBatch(users);
+
+    saveAllData(users);
+    char* expected[sizeof(dataFiles) / sizeof(dataFiles[0])];
+    for (size_t i = 0; i < sizeof(dataFiles) / sizeof(dataFiles[0]); i++) {
+        expected[i] = readSortedLines(dataFiles[i]);
+        remove(dataFiles[i]);
+    }
+    freeAllData(&users);
+
+    // A primary that shuts down after two batches, then one that dies after all of them: the
+    // standby starts over with the second and takes over with its data
+    FakePrimary primaries[] = { { batches, 2, END_BYE }, { batches, batchCount, END_DROP }, { NULL, 0, END_DROP } };
+    check(followFakePrimaries(&users, primaries) == 1, "the standby takes over from a primary that died");
+    saveAllData(users);
+    for (size_t i = 0; i < sizeof(dataFiles) / sizeof(dataFiles[0]); i++) {
+        char* actual = readSortedLines(dataFiles[i]);
+        if (strcmp(actual, expected[i]) != 0) {
+            printf("FAIL: %s of the standby differs from the primary's\n", dataFiles[i]);
+            failures++;
+        }
+        free(actual);
+        free(expected[i]);
+        remove(dataFiles[i]);
+    }
+    freeAllData(&users);
+
+    // A primary that detaches
+    FakePrimary detaching[] = { { batches, 1, END_DETACH }, { NULL, 0, END_DROP } };
+    check(followFakePrimaries(&users, detaching) == 0, "the standby exits when the primary detaches");
+    freeAllData(&users);
+
+    // A primary whose connection breaks while it still holds its lock
+    HANDLE lock = CreateFile(SOCKET_PATH ".lock", GENERIC_WRITE, 0, NULL, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    check(lock != INVALID_HANDLE_VALUE, "taking the primary's lock");
+    FakePrimary alive[] = { { batches, 1, END_DROP }, { NULL, 0, END_DROP } };
+    check(followFakePrimaries(&users, alive) == 0, "the standby exits when the primary still runs");
+    freeAllData(&users);
+    if (lock != INVALID_HANDLE_VALUE) {
+        CloseHandle(lock);
+        DeleteFile(SOCKET_PATH ".lock");
+    }
+
+    for (int i = 0; i < batchCount; i++) {
+        free(batches[i].text);
+    }
+    if (failures > 0) {
+        printf("replica: %d checks failed\n", failures);
+        return 1;
+    }
+    printf("replica: all checks passed\n");
+    return 0;
+}
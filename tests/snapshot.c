@@ -0,0 +1,219 @@
+// Read snapshot test: a snapshot reads exactly as the model did when it was pinned, however the
+// model changes while a reader runs on it in the background; pins share the copies of users who
+// did not change, and no copy outlives the snapshots that need it.
+// Build and run: make test. Runs inside a "utboard-test" directory.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <windows.h>
+#include "../functions.h"
+
+#define TEST_DIRECTORY "utboard-test"
+#define USERS 6
+
+static int failures = 0;
+static unsigned int seed = 12345;
+static volatile LONG stopReading = 0;
+
+static void check(int condition, const char* what) {
+    if (!condition) {
+        printf("FAIL: %s\n", what);
+        failures++;
+    }
+}
+
+static unsigned int nextRandom(unsigned int range) {
+    seed = seed * 1103515245u + 12345u;
+    return (seed >> 8) % range;
+}
+
+static char* readFile(const char* fileName) {
+    FILE* fp = fopen(fileName, "rb");
+    if (fp == NULL) {
+        return strdup("");
+    }
+    fseek(fp, 0, SEEK_END);
+    long size = ftell(fp);
+    rewind(fp);
+    char* text = malloc(size + 1);
+    size_t got = fread(text, 1, size, fp);
+    text[got] = '\0';
+    fclose(fp);
+    return text;
+}
+
+static int sameFiles(const char* first, const char* second) {
+    char* a = readFile(first);
+    char* b = readFile(second);
+    int same = strcmp(a, b) == 0;
+    free(a);
+    free(b);
+    return same;
+}
+
+static void writeLiveReport(const User* users, ReportType type, const char* fileName) {
+    FILE* out = fopen(fileName, "w");
+    printReport(users, type, 2, out);
+    fclose(out);
+}
+
+static void writeSnapshotReport(const Snapshot* snapshot, ReportType type, const char* fileName) {
+    FILE* out = fopen(fileName, "w");
+    writeReport(snapshotUsers(snapshot), type, NULL, 1, reminderDay(), out);
+    fclose(out);
+}
+
+// Reports on and exports the snapshot over and over, as a background read would, until stopped
+static DWORD WINAPI readSnapshot(LPVOID param) {
+    const Snapshot* snapshot = (const Snapshot*)param;
+    while (!InterlockedCompareExchange(&stopReading, 0, 0)) {
+        writeSnapshotReport(snapshot, REPORT_OVERDUE, "background.txt");
+        exportSnapshotChanges(snapshot, 0, "background.csv");
+    }
+    return 0;
+}
+
+// Pins a snapshot and checks every report and the change export against the model's
+static Snapshot* pinAndCompare(User* users, long since, const char* when) {
+    char what[96];
+    Snapshot* snapshot = pinSnapshot(users);
+    check(snapshot != NULL, "pinning a snapshot");
+    for (int type = 0; type < REPORT_TYPES; type++) {
+        writeLiveReport(users, (ReportType)type, "live.txt");
+        writeSnapshotReport(snapshot, (ReportType)type, "snapshot.txt");
+        snprintf(what, sizeof(what), "report %d of a snapshot %s matches the model", type, when);
+        check(sameFiles("live.txt", "snapshot.txt"), what);
+    }
+    exportChangesSince(users, since, "live.csv");
+    exportSnapshotChanges(snapshot, since, "snapshot.csv");
+    snprintf(what, sizeof(what), "change export of a snapshot %s matches the model", when);
+    check(sameFiles("live.csv", "snapshot.csv"), what);
+    return snapshot;
+}
+
+static void changeEveryone(User** users) {
+    char date[16];
+    for (User* user = *users; user != NULL; user = user->next) {
+        List* first = user->boards != NULL ? user->boards->lists : NULL;
+        if (first == NULL || first->next == NULL) {
+            continue;
+        }
+        List* second = first->next;
+        snprintf(date, sizeof(date), "20%02u-%02u-%02u", 20 + nextRandom(20), 1 + nextRandom(12), 1 + nextRandom(28));
+        if (first->tasks != NULL) {
+            moveTaskWithArgs(first, first->tasks, second);
+        }
+        if (second->tasks != NULL && second->tasks->next != NULL) {
+            deleteTaskWithArgs(second, second->tasks->next);
+        }
+        addTaskWithArgs(first, "A task with a name long enough to be kept out of line", "high", date);
+        if (second->tasks != NULL) {
+            editTaskWithArgs(second->tasks, "Renamed", "low", date);
+        }
+    }
+}
+
+int main() {
+    CreateDirectory(TEST_DIRECTORY, NULL);
+    if (!SetCurrentDirectory(TEST_DIRECTORY)) {
+        perror("Unable to enter the test directory");
+        return 1;
+    }
+
+    User* users = NULL;
+    char name[32], date[16];
+    for (int u = 0; u < USERS; u++) {
+        snprintf(name, sizeof(name), "user%d", u);
+        User* user = signupWithArgs(&users, name, "secret");
+        for (int b = 0; b < 3; b++) {
+            snprintf(name, sizeof(name), "Board %d", b);
+            Board* board = createBoardWithArgs(user, name);
+            for (int l = 0; l < 3; l++) {
+                snprintf(name, sizeof(name), "List %d", l);
+                List* list = createListWithArgs(board, name);
+                for (int t = 0; t < 20; t++) {
+                    snprintf(name, sizeof(name), "Task %d", t);
+                    snprintf(date, sizeof(date), "20%02u-%02u-%02u", 20 + nextRandom(20), 1 + nextRandom(12), 1 + nextRandom(28));
+                    addTaskWithArgs(list, name, t % 3 ? "high" : "medium", date);
+                }
+            }
+        }
+    }
+
+    // A snapshot pinned now reads as the model does, and still does after the model changed
+    // under a background reader
+    Snapshot* first = pinAndCompare(users, 0, "just pinned");
+    long firstSequence = snapshotSequence(first);
+    for (int type = 0; type < REPORT_TYPES; type++) {
+        snprintf(name, sizeof(name), "first%d.txt", type);
+        writeLiveReport(users, (ReportType)type, name);
+    }
+    exportChangesSince(users, 0, "first.csv");
+    HANDLE reader = CreateThread(NULL, 0, readSnapshot, first, 0, NULL);
+    for (int round = 0; round < 20; round++) {
+        changeEveryone(&users);
+        Snapshot* passing = pinSnapshot(users);
+        changeEveryone(&users);
+        releaseSnapshot(passing);
+    }
+    deleteBoardWithArgs(users, users->boards);
+    InterlockedIncrement(&stopReading);
+    WaitForSingleObject(reader, INFINITE);
+    CloseHandle(reader);
+    for (int type = 0; type < REPORT_TYPES; type++) {
+        snprintf(name, sizeof(name), "first%d.txt", type);
+        writeSnapshotReport(first, (ReportType)type, "snapshot.txt");
+        check(sameFiles(name, "snapshot.txt"), "a snapshot reads the same after the model changed");
+    }
+    exportSnapshotChanges(first, 0, "snapshot.csv");
+    check(sameFiles("first.csv", "snapshot.csv"), "a snapshot exports the same after the model changed");
+
+    // A new snapshot reads as the changed model does, deletions included
+    Snapshot* second = pinAndCompare(users, firstSequence, "pinned after changes");
+
+    // Pins share the copies of users who did not change
+    size_t pinned, copies, moreCopies, bytes;
+    getSnapshotMemory(&pinned, &copies, &bytes);
+    Snapshot* third = pinSnapshot(users);
+    getSnapshotMemory(&pinned, &moreCopies, &bytes);
+    check(moreCopies == copies, "a pin with no change since the last one copies nothing");
+    editTaskWithArgs(users->next->boards->lists->tasks, "Edited", NULL, NULL);
+    Snapshot* fourth = pinAndCompare(users, 0, "after one user changed");
+    getSnapshotMemory(&pinned, &moreCopies, &bytes);
+    check(moreCopies == copies + 1, "a pin after one user changed copies that user alone");
+
+    // Copies go with the snapshots that need them
+    releaseSnapshot(first);
+    releaseSnapshot(second);
+    releaseSnapshot(third);
+    getSnapshotMemory(&pinned, &copies, &bytes);
+    check(pinned == 1 && copies == USERS, "a pinned snapshot keeps its copies alone");
+    releaseSnapshot(fourth);
+    getSnapshotMemory(&pinned, &copies, &bytes);
+    check(pinned == 0 && copies == 0 && bytes == 0, "no copy is kept once no snapshot is pinned");
+
+    // Background reads never write over the data files
+    check(isDataFileName("tasks.csv") && isDataFileName("sub/Users.CSV") && isDataFileName("archive.csv.tmp") &&
+              isDataFileName("save.journal"),
+          "data files are recognised");
+    check(!isDataFileName("report.txt") && !isDataFileName("tasks.csv.bak"), "other files are not data files");
+
+    freeAllData(&users);
+    remove("live.txt");
+    remove("live.csv");
+    remove("snapshot.txt");
+    remove("snapshot.csv");
+    remove("background.txt");
+    remove("background.csv");
+    remove("first.csv");
+    for (int type = 0; type < REPORT_TYPES; type++) {
+        snprintf(name, sizeof(name), "first%d.txt", type);
+        remove(name);
+    }
+    if (failures > 0) {
+        printf("snapshot: %d checks failed\n", failures);
+        return 1;
+    }
+    printf("snapshot: all checks passed\n");
+    return 0;
+}
@@ -0,0 +1,274 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <windows.h>
+#include "functions.h"
+
+// Work-stealing pool: every worker has a deque of its own. A worker runs the newest job of its
+// deque first, so the jobs a job spawns run while its data is still in the cache, and when its
+// deque is empty it steals the oldest job of another worker, which tends to be the largest piece
+// of work left. Jobs submitted from outside the pool are dealt to the deques in turn and jobs
+// submitted by a job go to the deque of the worker running it. Each deque has its own lock, so
+// workers only meet on a lock when one steals from another; the pool lock is only taken to put
+// a worker to sleep or wake one.
+
+#define INITIAL_QUEUE_CAPACITY 64
+
+typedef struct Job {
+    void (*function)(void* arg);
+    void* arg;
+} Job;
+
+// Ring buffer of jobs: the owner pushes and pops at the bottom, thieves take from the top
+typedef struct WorkQueue {
+    CRITICAL_SECTION lock;
+    Job* jobs;
+    size_t capacity;
+    size_t top;        // Oldest job
+    size_t count;
+} WorkQueue;
+
+typedef struct Worker {
+    ThreadPool* pool;
+    int index;         // Of the worker's queue
+} Worker;
+
+struct ThreadPool {
+    HANDLE* threads;
+    int threadCount;
+    Worker* workers;
+    WorkQueue* queues;            // One per worker
+    int queueCount;               // Workers asked for; threadCount may have come out lower
+    volatile LONG queuedJobs;     // Jobs waiting in any queue
+    volatile LONG pendingJobs;    // Jobs queued or still running
+    volatile LONG sleepingWorkers;
+    volatile LONG nextQueue;      // Deals out the jobs submitted from outside the pool
+    int shuttingDown;
+    CRITICAL_SECTION lock;
+    CONDITION_VARIABLE jobAvailable;
+    CONDITION_VARIABLE allJobsDone;
+};
+
+static DWORD workerSlot = TLS_OUT_OF_INDEXES; // Thread-local Worker of the pool thread running
+
+// Returns the number of logical processors, at least 1
+int getCoreCount() {
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwNumberOfProcessors > 0 ? (int)info.dwNumberOfProcessors : 1;
+}
+
+// Adds a job at the bottom of the queue; returns 0 if there was no memory to grow it
+static int pushJob(WorkQueue* queue, Job job) {
+    EnterCriticalSection(&queue->lock);
+    if (queue->count == queue->capacity) {
+        size_t capacity = queue->capacity ? queue->capacity * 2 : INITIAL_QUEUE_CAPACITY;
+        Job* jobs = malloc(capacity * sizeof(Job));
+        if (jobs == NULL) {
+            LeaveCriticalSection(&queue->lock);
+            return 0;
+        }
+        for (size_t i = 0; i < queue->count; i++) {
+            jobs[i] = queue->jobs[(queue->top + i) % queue->capacity];
+        }
+        free(queue->jobs);
+        queue->jobs = jobs;
+        queue->capacity = capacity;
+        queue->top = 0;
+    }
+    queue->jobs[(queue->top + queue->count) % queue->capacity] = job;
+    queue->count++;
+    LeaveCriticalSection(&queue->lock);
+    return 1;
+}
+
+// Takes the newest job, for the queue's own worker
+static int popJob(WorkQueue* queue, Job* job) {
+    int found = 0;
+    EnterCriticalSection(&queue->lock);
+    if (queue->count > 0) {
+        queue->count--;
+        *job = queue->jobs[(queue->top + queue->count) % queue->capacity];
+        found = 1;
+    }
+    LeaveCriticalSection(&queue->lock);
+    return found;
+}
+
+// Takes the oldest job, for the other workers
+static int takeOldestJob(WorkQueue* queue, Job* job) {
+    int found = 0;
+    EnterCriticalSection(&queue->lock);
+    if (queue->count > 0) {
+        *job = queue->jobs[queue->top];
+        queue->top = (queue->top + 1) % queue->capacity;
+        queue->count--;
+        found = 1;
+    }
+    LeaveCriticalSection(&queue->lock);
+    return found;
+}
+
+// Looks through the other workers' queues, starting with the next one so thieves spread out
+static int stealJob(ThreadPool* pool, int thief, Job* job) {
+    for (int i = 1; i < pool->queueCount; i++) {
+        if (takeOldestJob(&pool->queues[(thief + i) % pool->queueCount], job)) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// Reads a counter the other threads change with interlocked operations, as a full barrier
+static LONG readCounter(volatile LONG* counter) {
+    return InterlockedCompareExchange(counter, 0, 0);
+}
+
+static void finishJob(ThreadPool* pool) {
+    if (InterlockedDecrement(&pool->pendingJobs) == 0) {
+        EnterCriticalSection(&pool->lock);
+        WakeAllConditionVariable(&pool->allJobsDone);
+        LeaveCriticalSection(&pool->lock);
+    }
+}
+
+// Sleeps until a job is queued; returns 0 when the pool shuts down with nothing left to do.
+// The worker counts itself as sleeping before it looks at the queued jobs and a submitter
+// counts its job before it looks for sleepers, so one of them always sees the other.
+static int waitForWork(ThreadPool* pool) {
+    EnterCriticalSection(&pool->lock);
+    InterlockedIncrement(&pool->sleepingWorkers);
+    while (readCounter(&pool->queuedJobs) <= 0 && !pool->shuttingDown) {
+        SleepConditionVariableCS(&pool->jobAvailable, &pool->lock, INFINITE);
+    }
+    InterlockedDecrement(&pool->sleepingWorkers);
+    int working = readCounter(&pool->queuedJobs) > 0;
+    LeaveCriticalSection(&pool->lock);
+    return working;
+}
+
+static DWORD WINAPI workerMain(LPVOID param) {
+    Worker* self = (Worker*)param;
+    ThreadPool* pool = self->pool;
+    TlsSetValue(workerSlot, self);
+    while (1) {
+        Job job;
+        if (popJob(&pool->queues[self->index], &job) || stealJob(pool, self->index, &job)) {
+            InterlockedDecrement(&pool->queuedJobs);
+            job.function(job.arg);
+            finishJob(pool);
+        } else if (!waitForWork(pool)) {
+            return 0;
+        }
+    }
+}
+
+ThreadPool* createThreadPool(int threadCount) {
+    if (workerSlot == TLS_OUT_OF_INDEXES) {
+        workerSlot = TlsAlloc(); // Pools are created on the main thread, so this runs once
+        if (workerSlot == TLS_OUT_OF_INDEXES) {
+            fprintf(stderr, "No thread-local slot left for the thread pool.\n");
+            return NULL;
+        }
+    }
+    ThreadPool* pool = malloc(sizeof(ThreadPool));
+    if (pool == NULL) {
+        perror("Memory allocation failed for thread pool");
+        return NULL;
+    }
+    memset(pool, 0, sizeof(ThreadPool));
+    InitializeCriticalSection(&pool->lock);
+    InitializeConditionVariable(&pool->jobAvailable);
+    InitializeConditionVariable(&pool->allJobsDone);
+
+    pool->threads = malloc(threadCount * sizeof(HANDLE));
+    pool->workers = malloc(threadCount * sizeof(Worker));
+    pool->queues = calloc(threadCount, sizeof(WorkQueue));
+    if (pool->threads == NULL || pool->workers == NULL || pool->queues == NULL) {
+        perror("Memory allocation failed for worker threads");
+        free(pool->threads);
+        free(pool->workers);
+        free(pool->queues);
+        DeleteCriticalSection(&pool->lock);
+        free(pool);
+        return NULL;
+    }
+    // Every queue exists before the first worker starts looking through them
+    pool->queueCount = threadCount;
+    for (int i = 0; i < threadCount; i++) {
+        InitializeCriticalSection(&pool->queues[i].lock);
+        pool->workers[i].pool = pool;
+        pool->workers[i].index = i;
+    }
+    for (int i = 0; i < threadCount; i++) {
+        HANDLE thread = CreateThread(NULL, 0, workerMain, &pool->workers[i], 0, NULL);
+        if (thread == NULL) {
+            break; // Run with the workers we managed to start; the others' queues stay empty
+        }
+        pool->threads[pool->threadCount++] = thread;
+    }
+    return pool;
+}
+
+// Queues a job; jobs may themselves submit further jobs to the same pool
+void submitJob(ThreadPool* pool, void (*function)(void* arg), void* arg) {
+    if (pool == NULL || pool->threadCount == 0) {
+        function(arg); // No pool available, run the job on the calling thread
+        return;
+    }
+    Worker* self = TlsGetValue(workerSlot);
+    int index = self != NULL && self->pool == pool
+        ? self->index
+        : (int)((unsigned long)InterlockedIncrement(&pool->nextQueue) % (unsigned long)pool->threadCount);
+    Job job = { function, arg };
+
+    // Counted as pending before it can run, so the count cannot reach 0 while it is queued
+    InterlockedIncrement(&pool->pendingJobs);
+    if (!pushJob(&pool->queues[index], job)) {
+        function(arg); // No memory to queue it, run it here
+        finishJob(pool);
+        return;
+    }
+    InterlockedIncrement(&pool->queuedJobs);
+    if (readCounter(&pool->sleepingWorkers) > 0) {
+        EnterCriticalSection(&pool->lock);
+        WakeConditionVariable(&pool->jobAvailable);
+        LeaveCriticalSection(&pool->lock);
+    }
+}
+
+// Blocks until every submitted job, including jobs submitted by jobs, has finished
+void waitForJobs(ThreadPool* pool) {
+    if (pool == NULL) {
+        return;
+    }
+    EnterCriticalSection(&pool->lock);
+    while (readCounter(&pool->pendingJobs) > 0) {
+        SleepConditionVariableCS(&pool->allJobsDone, &pool->lock, INFINITE);
+    }
+    LeaveCriticalSection(&pool->lock);
+}
+
+void destroyThreadPool(ThreadPool* pool) {
+    if (pool == NULL) {
+        return;
+    }
+    EnterCriticalSection(&pool->lock);
+    pool->shuttingDown = 1;
+    WakeAllConditionVariable(&pool->jobAvailable);
+    LeaveCriticalSection(&pool->lock);
+
+    for (int i = 0; i < pool->threadCount; i++) {
+        WaitForSingleObject(pool->threads[i], INFINITE);
+        CloseHandle(pool->threads[i]);
+    }
+    for (int i = 0; i < pool->queueCount; i++) {
+        DeleteCriticalSection(&pool->queues[i].lock);
+        free(pool->queues[i].jobs);
+    }
+    DeleteCriticalSection(&pool->lock);
+    free(pool->queues);
+    free(pool->workers);
+    free(pool->threads);
+    free(pool);
+}
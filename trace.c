@@ -0,0 +1,73 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <windows.h>
+#include "functions.h"
+
+// Spans are written as Chrome trace-event JSON ("X" complete events), which chrome://tracing
+// and Perfetto open directly. Everything here compiles away unless UTBOARD_TRACE is defined.
+#ifdef UTBOARD_TRACE
+
+static FILE* traceFile = NULL;
+static CRITICAL_SECTION traceLock;
+static long long traceOrigin;
+static double ticksPerMicrosecond;
+static int firstEvent;
+
+// Opens the trace file; call before any other thread can record a span
+void startTrace(const char* fileName) {
+    traceFile = fopen(fileName, "w");
+    if (traceFile == NULL) {
+        perror("Unable to open trace file");
+        return;
+    }
+    InitializeCriticalSection(&traceLock);
+    LARGE_INTEGER frequency;
+    QueryPerformanceFrequency(&frequency);
+    ticksPerMicrosecond = frequency.QuadPart / 1000000.0;
+    traceOrigin = statsClock();
+    firstEvent = 1;
+    fprintf(traceFile, "{\"traceEvents\":[\n");
+}
+
+void stopTrace() {
+    if (traceFile == NULL) {
+        return;
+    }
+    fprintf(traceFile, "\n],\"displayTimeUnit\":\"ms\"}\n");
+    fclose(traceFile);
+    traceFile = NULL;
+    DeleteCriticalSection(&traceLock);
+}
+
+// Records a span from startTicks until now on the calling thread
+void traceSpan(const char* name, long long startTicks) {
+    if (traceFile == NULL) {
+        return;
+    }
+    long long endTicks = statsClock();
+    char escaped[128];
+    size_t length = 0;
+    for (const char* p = name; *p && length < sizeof(escaped) - 2; p++) {
+        if (*p == '"' || *p == '\\') {
+            escaped[length++] = '\\';
+        }
+        escaped[length++] = *p;
+    }
+    escaped[length] = '\0';
+
+    EnterCriticalSection(&traceLock);
+    fprintf(traceFile, "%s{\"name\":\"%s\",\"cat\":\"utboard\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%lu}",
+            firstEvent ? "" : ",\n", escaped, (startTicks - traceOrigin) / ticksPerMicrosecond,
+            (endTicks - startTicks) / ticksPerMicrosecond, (unsigned long)GetCurrentThreadId());
+    firstEvent = 0;
+    LeaveCriticalSection(&traceLock);
+}
+
+void traceMenuSpan(const char* menu, int option, long long startTicks) {
+    char name[64];
+    snprintf(name, sizeof(name), "%s option %d", menu, option);
+    traceSpan(name, startTicks);
+}
+
+#endif